@@ -0,0 +1,50 @@
+#ifndef ASCII_NUMBER_H
+#define ASCII_NUMBER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace cos_lib
+{
+    namespace aux
+    {
+        /**
+         * @brief parse_float reads a decimal number written in the C locale, such as -12.5e-3, nan or inf
+         * @details the number is read without allocating and without depending on the locale; up to 19 significant digits
+         * are read exactly, the value is computed as a double and this double is rounded to a float. Rounding twice may give the
+         * float next to the nearest one for numbers very close to the middle of two floats, the 9 digits written by format_float
+         * being always read back as the same float
+         * @param begin is a pointer to the first character of the number
+         * @param end is a pointer past the last character that may be read
+         * @param value is set to the number read, 0 if no number could be read
+         * @return a pointer past the last character of the number, begin if no number could be read
+         */
+        const char* parse_float(const char* begin, const char* end, float& value);
+
+        /**
+         * @brief max_float_length is the maximum number of characters written by format_float
+         */
+        const size_t max_float_length = 16;
+
+        /**
+         * @brief format_float writes a float with 9 significant digits, as printf's %.9g in the C locale, such as -12.5, 1e-05 or nan
+         * @details 9 significant digits are enough to read the exact same float back; the digits are computed through a double,
+         * without allocating and without depending on the locale. The few values whose digits are too close to a tie for the double
+         * to round them are given their digits by printf, so the text is always the one of printf
+         * @param value is the number to write
+         * @param out is a pointer to a buffer of at least max_float_length characters, no terminating null character is written
+         * @return a pointer past the last character written
+         */
+        char* format_float(float value, char* out);
+
+        /**
+         * @brief format_uint writes an unsigned integer in decimal
+         * @param value is the number to write
+         * @param out is a pointer to a buffer of at least 10 characters, no terminating null character is written
+         * @return a pointer past the last character written
+         */
+        char* format_uint(uint32_t value, char* out);
+    }
+}
+
+#endif // ASCII_NUMBER_H
@@ -0,0 +1,164 @@
+#ifndef CLOUD_BINARY_H
+#define CLOUD_BINARY_H
+
+#include "../include/invalid_path.h"
+#include "../include/invalid_cloud_pointer.h"
+#include "../include/normal_estimator.h"
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <stdexcept>
+#include <stdint.h>
+
+#include <QFile>
+#include <QString>
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+namespace cos_lib
+{
+    namespace io
+    {
+        /**
+         * @brief The binary_cloud_header struct is the header at the beginning of a .cosc file
+         * @details A .cosc file is made of this header, of a directory holding one binary_cloud_chunk_entry per chunk, and of the chunks.
+         * A chunk holds the columns x, y, z and rgb of up to chunk_capacity points, then, if the file has them, the columns
+         * normal_x, normal_y, normal_z and curvature, then the column label. Floats and integers are stored little-endian, as in memory,
+         * and every chunk starts on a multiple of 64 bytes
+         */
+        struct binary_cloud_header
+        {
+            char magic[4];              // "COSC"
+            uint32_t version;
+            uint32_t flags;             // binary_cloud_has_normals | binary_cloud_has_labels
+            uint32_t chunk_capacity;    // number of points of every chunk but the last one
+            uint64_t nb_points;
+            uint64_t nb_chunks;
+        };
+
+        /**
+         * @brief The binary_cloud_chunk_entry struct describes one chunk of a .cosc file in its directory
+         */
+        struct binary_cloud_chunk_entry
+        {
+            uint64_t offset;            // position of the chunk from the beginning of the file
+            uint32_t nb_points;
+            uint32_t reserved;
+            float min[3];               // bounding box of the points of the chunk
+            float max[3];
+        };
+
+        const uint32_t binary_cloud_version = 1;
+        const uint32_t binary_cloud_has_normals = 1;
+        const uint32_t binary_cloud_has_labels = 2;
+
+        /**
+         * @brief The binary_cloud_chunk struct gives access to the columns of one chunk of a mapped .cosc file
+         * @details The pointers point straight into the mapped file, the columns that are not in the file are nullptr
+         */
+        struct binary_cloud_chunk
+        {
+            size_t nb_points;
+            const float* min;
+            const float* max;
+            const float* x;
+            const float* y;
+            const float* z;
+            const uint32_t* rgb;        // 0x00RRGGBB
+            const float* normal_x;
+            const float* normal_y;
+            const float* normal_z;
+            const float* curvature;
+            const uint32_t* label;
+        };
+
+        /**
+         * @brief The binary_cloud_view class maps a .cosc file in memory and reads its chunks without copying them
+         * @details The file is checked once when the view is created, the chunks are then only pointers into the mapping,
+         * which stays valid as long as the view
+         */
+        class binary_cloud_view
+        {
+        public:
+            /**
+             * @brief binary_cloud_view maps a .cosc file in memory
+             * @param path is a string representing a unique location in the file system
+             * @throw invalid_path if the file cannot be opened or mapped, or if it is not a valid .cosc file
+             */
+            binary_cloud_view(std::string path);
+
+            ~binary_cloud_view();
+
+            binary_cloud_view(const binary_cloud_view&) = delete;
+            binary_cloud_view& operator=(const binary_cloud_view&) = delete;
+
+            size_t getNbPoints() const { return (size_t)this->header->nb_points; }
+            size_t getNbChunks() const { return (size_t)this->header->nb_chunks; }
+            bool hasNormals() const { return (this->header->flags & binary_cloud_has_normals) != 0; }
+            bool hasLabels() const { return (this->header->flags & binary_cloud_has_labels) != 0; }
+
+            /**
+             * @brief getChunkOffset gets the index in the whole cloud of the first point of a chunk
+             */
+            size_t getChunkOffset(size_t chunk) const { return chunk * this->header->chunk_capacity; }
+
+            /**
+             * @brief getChunk gets the columns of a chunk
+             * @param chunk is the index of the chunk, lower than getNbChunks()
+             */
+            cos_lib::io::binary_cloud_chunk getChunk(size_t chunk) const;
+
+            /**
+             * @brief toCloud copies the points into a new pcl cloud, the chunks being converted in parallel
+             * @return a pointer to the cloud
+             */
+            pcl::PointCloud<pcl::PointXYZRGB>::Ptr toCloud() const;
+
+            /**
+             * @brief toNormals copies the normals into a normal buffer
+             * @param normals is resized to the number of points, and filled with NaN if the file has no normal
+             */
+            void toNormals(cos_lib::normal_buffer& normals) const;
+
+            /**
+             * @brief toLabels copies the labels into a vector
+             * @param labels is resized to the number of points, and filled with 0 if the file has no label
+             */
+            void toLabels(std::vector<uint32_t>& labels) const;
+
+        private:
+            QFile file;
+            const uchar* data;
+            const cos_lib::io::binary_cloud_header* header;
+            const cos_lib::io::binary_cloud_chunk_entry* directory;
+        };
+
+        /**
+         * @brief save_cloud_binary writes a point cloud to a .cosc file
+         * @details the points are written chunk by chunk, each chunk being gathered into columns then written at once
+         * @param path is a string representing a unique location in the file system
+         * @param cloud_ptr is a pointer to the cloud to be saved
+         * @param normals is a pointer to the normals of the cloud, nullptr to save no normal
+         * @param labels is a pointer to one label per point, such as a cluster index, nullptr to save no label
+         * @param chunk_capacity is the number of points per chunk
+         * @throw invalid_cloud_pointer if cloud_ptr is nullptr
+         * @throw invalid_path if failed to open or write the file
+         * @throw std::invalid_argument if chunk_capacity is 0 or if normals or labels do not have one element per point
+         */
+        void save_cloud_binary(std::string path, pcl::PointCloud<pcl::PointXYZRGB>::ConstPtr cloud_ptr,
+                               const cos_lib::normal_buffer* normals = nullptr, const std::vector<uint32_t>* labels = nullptr,
+                               size_t chunk_capacity = 1 << 16);
+
+        /**
+         * @brief load_cloud_binary generates a cloud from a .cosc file
+         * @param path is a string representing a unique location in the file system
+         * @throw invalid_path if the file cannot be opened or is not a valid .cosc file
+         * @return a pointer to the cloud that has been read
+         */
+        pcl::PointCloud<pcl::PointXYZRGB>::Ptr load_cloud_binary(std::string path);
+    }
+}
+
+#endif // CLOUD_BINARY_H
@@ -8,6 +8,10 @@
 
 #include "../include/invalid_path.h"
 #include "../include/invalid_cloud_pointer.h"
+#include "../include/ascii_number.h"
+#include "../include/pcd_format.h"
+#include "../include/ply_format.h"
+#include "../include/las_format.h"
 
 #include <iostream>
 #include <sstream>
@@ -15,15 +19,19 @@
 #include <ios>
 #include <exception>
 #include <type_traits>
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include <cstring>
 
 #include <QTextStream>
 #include <QString>
 #include <QStringList>
 #include <QFile>
+#include <QByteArray>
 
 #include <pcl/point_cloud.h>
 #include <pcl/point_types.h>
-#include <pcl/io/pcd_io.h>
 
 #include <boost/lexical_cast.hpp>
 
@@ -31,30 +39,96 @@ namespace cos_lib
 {
     namespace io
     {
+        /**
+         * @brief parse_cloud_txt generates a cloud from the content of a .txt file, one "x y z [r g b]" point per line
+         * @details the columns are separated by tabs or spaces and their number is read once, on the first line: 3 to 5 columns
+         * give white points, 6 columns give coloured points. Empty lines are ignored. The text is cut into chunks of whole lines
+         * which are parsed in parallel straight into the cloud
+         * @param begin is a pointer to the first character of the text
+         * @param end is a pointer past the last character of the text
+         * @throw invalid_path if the first line does not have 3 to 6 columns, or if a line does not have the columns of the first one
+         * @return a pointer to the cloud that has been read
+         */
+        pcl::PointCloud<pcl::PointXYZRGB>::Ptr parse_cloud_txt(const char* begin, const char* end);
+
         /**
          * @brief import_cloud_txt generates a cloud from a .txt file
+         * @details the file is memory mapped and parsed by parse_cloud_txt
          * @param path is a string representing a unique location in the file system
-         * @throw invalid_path if failed to open file
+         * @throw invalid_path if failed to open file or if its content is not a cloud
          * @return a pointer to the cloud that has been read
          */
         pcl::PointCloud<pcl::PointXYZRGB>::Ptr import_cloud_txt(std::string path);
 
         /**
-         * @brief import_cloud generates a cloud from a .txt or .pcd file
+         * @brief parse_cloud_pcd generates a cloud from the content of a .pcd file, ascii, binary or binary_compressed
+         * @details the points are decoded in parallel straight into the cloud, the points without rgb or rgba field being white
+         * @param begin is a pointer to the first byte of the file
+         * @param end is a pointer past the last byte of the file
+         * @throw invalid_path if the header is invalid or if the data does not hold the points announced by the header
+         * @return a pointer to the cloud that has been read
+         */
+        pcl::PointCloud<pcl::PointXYZRGB>::Ptr parse_cloud_pcd(const char* begin, const char* end);
+
+        /**
+         * @brief parse_cloud_ply generates a cloud from the vertices of a .ply file, ascii or binary
+         * @details the vertices are decoded in parallel straight into the cloud, the vertices without colour being white
+         * @param begin is a pointer to the first byte of the file
+         * @param end is a pointer past the last byte of the file
+         * @throw invalid_path if the header is invalid or if the data does not hold the vertices announced by the header
+         * @return a pointer to the cloud that has been read
+         */
+        pcl::PointCloud<pcl::PointXYZRGB>::Ptr parse_cloud_ply(const char* begin, const char* end);
+
+        /**
+         * @brief parse_cloud_las generates a cloud from the content of a .las file
+         * @details the points are decoded in parallel straight into the cloud, the points without colour being white.
+         * The 16 bits colours are reduced to 8 bits, unless the file only holds 8 bits values. The coordinates are relative to the
+         * origin chosen by parse_las_header, so that georeferenced clouds keep their precision
+         * @param begin is a pointer to the first byte of the file
+         * @param end is a pointer past the last byte of the file
+         * @param origin if not nullptr, is set to the 3 coordinates to add to the points to get their position in the file
+         * @throw invalid_path if the header is invalid, if the file does not hold its points, or if they are compressed (.laz)
+         * @return a pointer to the cloud that has been read
+         */
+        pcl::PointCloud<pcl::PointXYZRGB>::Ptr parse_cloud_las(const char* begin, const char* end, double* origin = nullptr);
+
+        /**
+         * @brief The cloud_format enum lists the file formats recognised by detect_cloud_format
+         */
+        enum class cloud_format { unknown, txt, pcd, ply, las, laz, cosc };
+
+        /**
+         * @brief detect_cloud_format finds the format of a cloud file from its first bytes, whatever its extension
+         * @param begin is a pointer to the first byte of the file
+         * @param end is a pointer past the last byte available, at least the first line of a text file being needed
+         * @return the format of the file, unknown if it is none of the others
+         */
+        cos_lib::io::cloud_format detect_cloud_format(const char* begin, const char* end);
+
+        /**
+         * @brief import_cloud generates a cloud from a .txt, .pcd, .ply, .las or .cosc file
+         * @details the file is memory mapped and its format is detected from its content, then it is parsed straight into the cloud
          * @param path is a string representing a unique location in the file system
-         * @throw invalid_path if failed to open file
+         * @param origin if not nullptr, is set to the 3 coordinates to add to the points to get their position in the file,
+         * which are only not 0 for a .las file, as parse_cloud_las reads it
+         * @throw invalid_path if failed to open file, if its format is not supported, .laz included, or if its content is invalid
          * @return the a pointer to the cloud that has been read
          */
-        pcl::PointCloud<pcl::PointXYZRGB>::Ptr import_cloud(std::string path);
+        pcl::PointCloud<pcl::PointXYZRGB>::Ptr import_cloud(std::string path, double* origin = nullptr);
 
         /**
-         * @brief export_cloud writes a point cloud to a text file.
+         * @brief export_cloud writes a point cloud to a text file, one "x\ty\tz\tr\tg\tb" point per line
+         * @details the coordinates are written with 9 significant digits, so that they are read back exactly. The points are
+         * formatted by chunks into reusable buffers which are written at once. In parallel, the chunks are formatted by all the
+         * threads and still written in the cloud order
          * @param path is a string representing a unique location in the file system
-         * @throw invalid_path if failed to open file
-         * @throw invalid_cloud_pointer if cloud_ptr is nullptr
          * @param cloud_ptr is a pointer to the cloud to be exported
+         * @param parallel is true to format the chunks on several threads
+         * @throw invalid_path if failed to open or write the file
+         * @throw invalid_cloud_pointer if cloud_ptr is nullptr
          **/
-        void export_cloud(std::string path, pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud_ptr);
+        void export_cloud(std::string path, pcl::PointCloud<pcl::PointXYZRGB>::ConstPtr cloud_ptr, bool parallel = true);
     }
 }
 
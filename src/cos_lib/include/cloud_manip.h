@@ -11,6 +11,7 @@
 #include "point_xy_mixed.h"
 #include "point_clstr.h"
 #include "invalid_cloud_pointer.h"
+#include "colour_quantizer.h"
 
 #include <pcl/point_cloud.h>
 #include <pcl/point_types.h>
@@ -33,6 +34,24 @@ namespace cos_lib
         /** @return all of the z coordinates found in the parameter cloud */
         std::vector<float> cloud_z_coords(pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud_ptr);
 
+        /**
+         * @brief The cloud_bounds struct holds the smallest and the largest coordinates of the points of a cloud
+         */
+        struct cloud_bounds
+        {
+            float x_min, x_max;
+            float y_min, y_max;
+            float z_min, z_max;
+        };
+
+        /**
+         * @brief compute_bounds finds the smallest and the largest coordinates of a cloud in one parallel pass
+         * @details the minima of an empty cloud are FLT_MAX and its maxima -FLT_MAX
+         * @param cloud is the cloud to be bounded
+         * @return the bounds of the cloud
+         */
+        cos_lib::cloud_manip::cloud_bounds compute_bounds(const pcl::PointCloud<pcl::PointXYZRGB>& cloud);
+
         /**
          * @brief copy_cloud copies a cloud into another cloud
          * @param src is a pointer to the source cloud
@@ -53,6 +72,12 @@ namespace cos_lib
         void scale_cloud(pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud_ptr, float x_scale, float y_scale,
                          float z_scale);
 
+        /**
+         * @brief scale_batch rescales in place the points of a batch, such as one read by an io::cloud_reader
+         * @throw std::invalid_argument if x_scale, y_scale or z_scale are null
+         */
+        void scale_batch(pcl::PointCloud<pcl::PointXYZRGB>& batch, float x_scale, float y_scale, float z_scale);
+
         /**
          * @brief crop_cloud removes the points of which the coordinates are beyond a certain threshold
          * @param base_cloud_ptr is a pointer to the point cloud to be treated
@@ -65,14 +90,30 @@ namespace cos_lib
         pcl::PointCloud<pcl::PointXYZRGB>::Ptr crop_cloud(pcl::PointCloud<pcl::PointXYZRGB>::Ptr base_cloud_ptr,
                                float x_thresh, float y_thresh, float z_thresh);
 
+        /**
+         * @brief crop_batch removes in place the points of a batch of which the coordinates are beyond a certain threshold
+         * @details the points kept stay in the same order, a threshold close to 0 crops nothing along its axis
+         */
+        void crop_batch(pcl::PointCloud<pcl::PointXYZRGB>& batch, float x_thresh, float y_thresh, float z_thresh);
+
         /**
          * @brief homogenize_cloud homogenizes the similar colors within a cloud
          * @details if two points have similar but not identical colors they will be attributed the same color
          * @param cloud a pointer to the point cloud to be homogenized
          * @param epsilon defines the 3 dimensions of the cube used to regroup colors
+         * @param histogram if not nullptr, is set to the histogram of the homogenized colors, counted in the same pass
          * @throw std::invalid_argument if cloud_ptr is equal to nullptr or if epsilon is null
          */
-        void homogenize_cloud(pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud_ptr, short epsilon);
+        void homogenize_cloud(pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud_ptr, short epsilon,
+                              cos_lib::colour_histogram* histogram = nullptr);
+
+        /**
+         * @brief homogenize_batch homogenizes in place the colors of the points of a batch
+         * @details the channels are rounded by the tables of a colour_quantizer, one chunk of the batch per thread
+         * @throw std::invalid_argument if epsilon is null
+         */
+        void homogenize_batch(pcl::PointCloud<pcl::PointXYZRGB>& batch, short epsilon,
+                              cos_lib::colour_histogram* histogram = nullptr);
 
         /**
          * @brief fragment_cloud breaks a cloud down into smaller pieces along the y axis
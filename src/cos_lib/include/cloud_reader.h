@@ -0,0 +1,160 @@
+#ifndef CLOUD_READER_H
+#define CLOUD_READER_H
+
+#include "../include/invalid_path.h"
+#include "../include/cloud_io.h"
+#include "../include/cloud_binary.h"
+#include "../include/pcd_format.h"
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <fstream>
+#include <stdexcept>
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+namespace cos_lib
+{
+    namespace io
+    {
+        /**
+         * @brief The cloud_reader class reads a cloud file batch by batch, so that clouds bigger than the memory can be processed
+         * @details Only the current batch and a block of the file are held in memory
+         */
+        class cloud_reader
+        {
+        public:
+            virtual ~cloud_reader() { }
+
+            /**
+             * @brief read reads the next points of the file
+             * @param batch is filled with the next points of the file, at most getBatchSize() of them
+             * @throw invalid_path if the file cannot be read or if its content is not a cloud
+             * @return false if there was no point left, batch then being empty
+             */
+            virtual bool read(pcl::PointCloud<pcl::PointXYZRGB>& batch) = 0;
+
+            /**
+             * @brief getBatchSize gets the maximum number of points of a batch
+             */
+            size_t getBatchSize() const { return this->batch_size; }
+
+        protected:
+            /**
+             * @throw std::invalid_argument if batch_size is 0
+             */
+            cloud_reader(size_t batch_size);
+
+            size_t batch_size;
+        };
+
+        /**
+         * @brief The text_block_reader class reads a text file by blocks of whole lines
+         */
+        class text_block_reader
+        {
+        public:
+            /**
+             * @param file is the stream the blocks are read from, starting at its current position
+             * @param block_size is the number of characters read at once, a block being longer only when a line is
+             */
+            text_block_reader(std::istream& file, size_t block_size);
+
+            /**
+             * @brief next reads the next block of lines, the last line of the file being included even without a final '\n'
+             * @param begin is set to a pointer to the first character of the block
+             * @param end is set to a pointer past the last character of the block, which stays valid until the next call
+             * @return false if the end of the file was reached
+             */
+            bool next(const char*& begin, const char*& end);
+
+        private:
+            std::istream& file;
+            size_t block_size;
+            std::vector<char> buffer;
+            size_t tail_begin;      // the part of the buffer that follows the last block returned, the beginning of its next line
+            size_t tail_end;
+        };
+
+        /**
+         * @brief The txt_cloud_reader class reads a .txt cloud by batches, one "x y z [r g b]" point per line
+         * @details each block of lines is parsed in parallel by parse_cloud_txt
+         */
+        class txt_cloud_reader : public cloud_reader
+        {
+        public:
+            /**
+             * @throw invalid_path if failed to open file
+             * @throw std::invalid_argument if batch_size is 0
+             */
+            txt_cloud_reader(std::string path, size_t batch_size);
+
+            bool read(pcl::PointCloud<pcl::PointXYZRGB>& batch);
+
+        private:
+            std::ifstream file;
+            cos_lib::io::text_block_reader blocks;
+            pcl::PointCloud<pcl::PointXYZRGB>::Ptr pending;     // points of the current block not returned yet
+            size_t pending_begin;
+        };
+
+        /**
+         * @brief The pcd_cloud_reader class reads an ascii or binary .pcd cloud by batches
+         * @details binary_compressed files hold all their points in one compressed block, which cannot be read by batches
+         */
+        class pcd_cloud_reader : public cloud_reader
+        {
+        public:
+            /**
+             * @throw invalid_path if failed to open file, if its header is invalid or if its data is binary_compressed
+             * @throw std::invalid_argument if batch_size is 0
+             */
+            pcd_cloud_reader(std::string path, size_t batch_size);
+
+            bool read(pcl::PointCloud<pcl::PointXYZRGB>& batch);
+
+        private:
+            std::ifstream file;
+            cos_lib::io::pcd_header header;
+            size_t nb_points_read;
+            std::vector<char> buffer;                           // binary points of the current batch
+            std::unique_ptr<cos_lib::io::text_block_reader> blocks;
+            const char* line;                                   // next ascii line of the current block
+            const char* block_end;
+        };
+
+        /**
+         * @brief The binary_cloud_reader class reads a .cosc cloud by batches from its memory mapping
+         */
+        class binary_cloud_reader : public cloud_reader
+        {
+        public:
+            /**
+             * @throw invalid_path if the file cannot be opened or is not a valid .cosc file
+             * @throw std::invalid_argument if batch_size is 0
+             */
+            binary_cloud_reader(std::string path, size_t batch_size);
+
+            bool read(pcl::PointCloud<pcl::PointXYZRGB>& batch);
+
+        private:
+            cos_lib::io::binary_cloud_view view;
+            size_t chunk;
+            size_t chunk_position;
+        };
+
+        /**
+         * @brief open_cloud_reader opens a .txt, .pcd or .cosc cloud to be read by batches, its format being detected from its content
+         * @param path is a string representing a unique location in the file system
+         * @param batch_size is the maximum number of points of a batch
+         * @throw invalid_path if failed to open file or if its format is not supported
+         * @throw std::invalid_argument if batch_size is 0
+         * @return a pointer to the reader
+         */
+        std::unique_ptr<cos_lib::io::cloud_reader> open_cloud_reader(std::string path, size_t batch_size = 1 << 20);
+    }
+}
+
+#endif // CLOUD_READER_H
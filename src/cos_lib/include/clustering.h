@@ -1,62 +1,174 @@
-#include <map>
-#include <vector>
-#include <iterator>
-#include <algorithm>
-#include <pcl/point_cloud.h>
-#include <pcl/point_types.h>
-#include <pcl/kdtree/impl/kdtree_flann.hpp>
-#include <pcl/kdtree/impl/io.hpp>
-#include "point_clstr.h"
-#include "../include/cloud_io.h"
-#include "cloud_manip.h"
-#include "bounding.h"
-
-#ifndef CLUSTERING_H
-#define CLUSTERING_H
-
-
-namespace cos_lib
-{
-    class clustering
-    {
-    public:
-        /**
-         * @brief getClustersFromColouredCloud Retuns a vector containing the coloured clusters found in cloud.
-         * @param cloud PCL Cloud with XYZRGB points in which you want to find the clusters
-         * @param neighbours_radius Radius of search, used to define at least how near two neighbour points must be from eachother
-         * @param isWidop If the cloud to analyse is a Widop cloud
-         * @param min_cluster_size Minimum of points a cluster must have
-         * @return A vector that contains the clusters found
-         */
-        static std::vector<pcl::PointCloud<pcl::PointXYZRGB>::Ptr> getClustersFromColouredCloud(pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud, double neighbours_radius, bool isWidop = true, size_t min_cluster_size = 1000);
-    private:
-        /**
-         * @brief coloured_clouds_map Map that, for a string representing a colour, associate a plane coloured cloud
-         */
-        static std::map<std::string, pcl::PointCloud<cos_lib::point_clstr>::Ptr> coloured_clouds_map;
-        /**
-         * @brief neighboursNotYetPushed Vector that remembers which points are yet to be seen during the adding of the neighbours
-         */
-        static std::vector<cos_lib::point_clstr*> neighboursNotYetPushed;
-
-        /**
-         * @brief sortPointsByColor Sorts all the cloud's points into the coloured_cloud_map according to their colour
-         * @param base_cloud The cloud we want its points to be sorted
-         */
-        static void sortPointsByColor(pcl::PointCloud<cos_lib::point_clstr>::Ptr base_cloud);
-        /**
-         * @brief setNeighbourhoodForPoints With a view to not keep a kd-tree along the whole algorithm, this function tells each points who their neighbours is
-         * @param unicoloured_cloud Cloud that is plane coloured
-         * @param neighbours_radius Search radius for the neighbours
-         */
-        static void setNeighbourhoodForPoints(pcl::PointCloud<cos_lib::point_clstr>::Ptr unicoloured_cloud, double neighbours_radius);
-        /**
-         * @brief addNeighboursIntoCluster Add the current point and its neighbours into the cluster
-         * @param point_ptr The current point you want to add
-         * @param cluster The cluster you want to push the point in
-         * @return A vector that contains the points neighbours that hasn't been seen yet
-         */
-        static std::vector<cos_lib::point_clstr*> addNeighboursIntoCluster(cos_lib::point_clstr* point_ptr, pcl::PointCloud<cos_lib::point_clstr>::Ptr cluster);
-    };
-}
-#endif // CLUSTERING_H
+#include <set>
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <vector>
+#include <iterator>
+#include <algorithm>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <pcl/kdtree/impl/io.hpp>
+#include "colour_buckets.h"
+#include "voxel_hash_index.h"
+#include "neighbour_graph.h"
+#include "disjoint_set.h"
+#include "../include/cloud_io.h"
+#include "cloud_manip.h"
+#include "bounding.h"
+
+#ifndef CLUSTERING_H
+#define CLUSTERING_H
+
+
+namespace cos_lib
+{
+    /**
+     * @brief The clustering class is the engine that cuts a coloured cloud into unicoloured, connected clusters
+     * @details An engine only holds its parameters, so the same engine can be used by several threads at once. The colours
+     * of a cloud are clustered in parallel, the biggest colours first. The clusters are either streamed to a sink as soon as they are found,
+     * or returned by increasing packed colour.
+     * Points whose colour is one of the ignored colours (black and 0,0,200 by default) are never clustered
+     */
+    class clustering
+    {
+    public:
+        /**
+         * @brief The method enum lists the ways the clusters of a colour can be built, both give the same clusters
+         * @details REGION_GROWING stores every neighbourhood then walks through it, one colour per thread.
+         * UNION_FIND joins the points while their neighbours are searched, never stores a neighbourhood and splits
+         * each colour between all the threads
+         */
+        enum method { REGION_GROWING, UNION_FIND };
+
+        /**
+         * @brief clustering Creates a clustering engine
+         * @param neighbours_radius Radius of search, used to define at least how near two neighbour points must be from eachother
+         * @param isWidop If the clouds to analyse are Widop clouds, whose y axis is then measured 100 times bigger
+         * @param min_cluster_size Minimum of points a cluster must have
+         * @param clustering_method The way the clusters are built
+         */
+        clustering(double neighbours_radius, bool isWidop = true, size_t min_cluster_size = 1000, method clustering_method = REGION_GROWING);
+
+        /**
+         * @brief cluster_sink Receives a cluster as soon as it is found: its packed colour and the indices of its points in the analysed cloud
+         * @details The indices are only valid during the call, the sink must copy what it needs to keep
+         */
+        typedef std::function<void(uint32_t colour, const uint32_t* indices_begin, const uint32_t* indices_end)> cluster_sink;
+
+        /**
+         * @brief getClusters Retuns a vector containing the coloured clusters found in cloud.
+         * @param cloud PCL Cloud with XYZRGB points in which you want to find the clusters
+         * @throw std::invalid_argument if a colour spans more than 2^21 cells of neighbours_radius along one axis
+         * @return A vector that contains the clusters found, always in the same order for the same cloud
+         */
+        std::vector<pcl::PointCloud<pcl::PointXYZRGB>::Ptr> getClusters(pcl::PointCloud<pcl::PointXYZRGB>::ConstPtr cloud) const;
+
+        /**
+         * @brief streamClusters Hands every cluster found in cloud to a sink instead of keeping them, so they can be written while the other colours are analysed
+         * @details The sink is never called by two threads at once. The clusters of one colour always come in the same order,
+         * but the colours come in the order they are finished. The sink may throw: the colours being analysed are finished
+         * without handing it more clusters, the colours left are skipped and the exception is thrown again once the threads are done,
+         * the clusters handed over before staying with the sink
+         * @param cloud PCL Cloud with XYZRGB points in which you want to find the clusters
+         * @param sink Called once for each cluster that contains at least min_cluster_size points
+         * @throw std::invalid_argument if a colour spans more than 2^21 cells of neighbours_radius along one axis
+         * @throw any exception thrown by the sink
+         */
+        void streamClusters(pcl::PointCloud<pcl::PointXYZRGB>::ConstPtr cloud, const cluster_sink& sink) const;
+
+        /**
+         * @brief setIgnoredColours Sets the colours whose points must not be clustered
+         * @param ignored_colours Colours packed on 24 bits (red << 16 | green << 8 | blue)
+         */
+        void setIgnoredColours(const std::set<uint32_t>& ignored_colours) { this->ignored_colours = ignored_colours; }
+
+        /**
+         * @brief setScale Sets the scale of each axis used when measuring the distance between two points, the cloud itself is never scaled
+         * @throw std::invalid_argument if a scale is not strictly positive
+         */
+        void setScale(float x_scale, float y_scale, float z_scale);
+
+        /**
+         * @brief getScale Gets the scale of an axis used when measuring the distance between two points
+         * @param axis 0 for x, 1 for y, 2 for z
+         */
+        float getScale(int axis) const { return this->scale[axis]; }
+
+        /**
+         * @brief getIgnoredColours Gets the colours whose points are not clustered, packed on 24 bits
+         */
+        const std::set<uint32_t>& getIgnoredColours() const { return this->ignored_colours; }
+
+        /**
+         * @brief getClustersFromColouredCloud Retuns a vector containing the coloured clusters found in cloud.
+         * @param cloud PCL Cloud with XYZRGB points in which you want to find the clusters
+         * @param neighbours_radius Radius of search, used to define at least how near two neighbour points must be from eachother
+         * @param isWidop If the cloud to analyse is a Widop cloud
+         * @param min_cluster_size Minimum of points a cluster must have
+         * @param clustering_method The way the clusters are built
+         * @throw std::invalid_argument if a colour spans more than 2^21 cells of neighbours_radius along one axis
+         * @return A vector that contains the clusters found
+         */
+        static std::vector<pcl::PointCloud<pcl::PointXYZRGB>::Ptr> getClustersFromColouredCloud(pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud, double neighbours_radius, bool isWidop = true, size_t min_cluster_size = 1000, method clustering_method = REGION_GROWING);
+    private:
+        /**
+         * @brief neighbours_radius Search radius for the neighbours
+         */
+        double neighbours_radius;
+        /**
+         * @brief scale Scale of each axis in the distances, (1, 100, 1) for Widop clouds
+         */
+        float scale[3];
+        /**
+         * @brief min_cluster_size Minimum of points a cluster must have
+         */
+        size_t min_cluster_size;
+        /**
+         * @brief clustering_method The way the clusters are built
+         */
+        method clustering_method;
+        /**
+         * @brief ignored_colours Packed colours whose points are not clustered
+         */
+        std::set<uint32_t> ignored_colours;
+
+        /**
+         * @brief streamClustersFromUnicolouredCloud Cuts the points of one colour into clusters
+         * @param cloud The cloud the points belong to
+         * @param colour Packed colour of the points
+         * @param indices_begin Pointer on the index of the first point of the colour
+         * @param indices_end Pointer past the index of the last point of the colour
+         * @param sink Receives the clusters that contain at least min_cluster_size points, in the order they were found
+         */
+        void streamClustersFromUnicolouredCloud(pcl::PointCloud<pcl::PointXYZRGB>::ConstPtr cloud, uint32_t colour, const uint32_t* indices_begin, const uint32_t* indices_end, const cluster_sink& sink) const;
+        /**
+         * @brief streamClustersByUnionFind Cuts the points of one colour into clusters by joining neighbours as soon as they are found
+         * @details The neighbours search is shared between all the threads, the points of a cluster are given in the cloud order
+         * @param cloud The cloud the points belong to
+         * @param colour Packed colour of the points
+         * @param indices_begin Pointer on the index of the first point of the colour
+         * @param indices_end Pointer past the index of the last point of the colour
+         * @param sink Receives the clusters that contain at least min_cluster_size points, in the same order as streamClustersFromUnicolouredCloud
+         */
+        void streamClustersByUnionFind(pcl::PointCloud<pcl::PointXYZRGB>::ConstPtr cloud, uint32_t colour, const uint32_t* indices_begin, const uint32_t* indices_end, const cluster_sink& sink) const;
+        /**
+         * @brief convertCluster Creates the PCL cloud of a cluster
+         * @param cloud The cloud the cluster was found in
+         * @param indices_begin Pointer on the index of the first point of the cluster
+         * @param indices_end Pointer past the index of the last point of the cluster
+         * @return The cluster as a PCL RGB cloud
+         */
+        static pcl::PointCloud<pcl::PointXYZRGB>::Ptr convertCluster(pcl::PointCloud<pcl::PointXYZRGB>::ConstPtr cloud, const uint32_t* indices_begin, const uint32_t* indices_end);
+        /**
+         * @brief growCluster Gathers every point that can be reached from the seed point by jumping from neighbour to neighbour
+         * @param seed_index Index of the point the cluster starts from
+         * @param graph Neighbourhood of the unicoloured cloud the seed belongs to
+         * @param added Bitset remembering which points of the unicoloured cloud already belong to a cluster
+         * @param cluster_indices Filled with the indices of the cluster's points, in the order they were reached
+         */
+        static void growCluster(size_t seed_index, const cos_lib::neighbour_graph& graph, std::vector<bool>& added, std::vector<uint32_t>& cluster_indices);
+    };
+}
+#endif // CLUSTERING_H
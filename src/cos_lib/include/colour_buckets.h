@@ -0,0 +1,176 @@
+#include <vector>
+#include <map>
+#include <string>
+#include <fstream>
+#include <algorithm>
+#include <stdint.h>
+#include "invalid_path.h"
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+#ifndef COLOUR_BUCKETS_H
+#define COLOUR_BUCKETS_H
+
+namespace cos_lib
+{
+    /**
+     * @brief The colour_buckets class regroups the indices of a cloud's points by colour without copying the points
+     * @details Colours are packed on 24 bits (red << 16 | green << 8 | blue). The indices of all the points are sorted by
+     * colour in one array, so each colour owns one contiguous range of it, and the cloud order is kept within a colour
+     */
+    class colour_buckets
+    {
+    public:
+        /**
+         * @brief colour_buckets Default constructor, creates an empty set of buckets
+         */
+        colour_buckets();
+
+        /**
+         * @brief build Sorts the indices of the cloud's points by colour with a two pass radix sort
+         * @param cloud The cloud we want its points to be sorted
+         */
+        void build(pcl::PointCloud<pcl::PointXYZRGB>::ConstPtr cloud);
+
+        /**
+         * @brief clear Removes every bucket and frees the memory
+         */
+        void clear();
+
+        /**
+         * @brief packColour Packs the colour of a point on 24 bits
+         */
+        static uint32_t packColour(const pcl::PointXYZRGB& point) { return ((uint32_t)point.r << 16) | ((uint32_t)point.g << 8) | (uint32_t)point.b; }
+
+        /**
+         * @brief getNbColours Gets how many different colours were found
+         */
+        size_t getNbColours() const { return this->colours.size(); }
+
+        /**
+         * @brief getColour Gets the packed colour of a bucket, buckets being sorted by increasing colour
+         */
+        uint32_t getColour(size_t bucket) const { return this->colours[bucket]; }
+
+        /**
+         * @brief getBucketSize Gets how many points have the colour of a bucket
+         */
+        size_t getBucketSize(size_t bucket) const { return this->offsets[bucket + 1] - this->offsets[bucket]; }
+
+        /**
+         * @brief bucketBegin Gets a pointer on the first point index of a bucket
+         */
+        const uint32_t* bucketBegin(size_t bucket) const { return this->indices.data() + this->offsets[bucket]; }
+
+        /**
+         * @brief bucketEnd Gets a pointer past the last point index of a bucket
+         */
+        const uint32_t* bucketEnd(size_t bucket) const { return this->indices.data() + this->offsets[bucket + 1]; }
+
+    private:
+        /**
+         * @brief colours Packed colour of each bucket
+         */
+        std::vector<uint32_t> colours;
+        /**
+         * @brief offsets Position of the first index of each bucket in indices, plus a last entry holding the number of points
+         */
+        std::vector<size_t> offsets;
+        /**
+         * @brief indices Indices of all the cloud's points, sorted by colour
+         */
+        std::vector<uint32_t> indices;
+
+        /**
+         * @brief radixPass Stable counting sort of the keys and their indices on 12 bits of the keys
+         * @param shift Position of the lowest of the 12 bits used
+         */
+        static void radixPass(const std::vector<uint32_t>& keys_in, const std::vector<uint32_t>& indices_in,
+                              std::vector<uint32_t>& keys_out, std::vector<uint32_t>& indices_out, unsigned int shift);
+    };
+
+    /**
+     * @brief The colour_bucket_stream class regroups by colour the points of batches, such as the ones read by an io::cloud_reader,
+     * with a bounded memory
+     * @details The points are buffered by colour and, once too many points are buffered, all the buffers are appended to a
+     * spill file, one segment per colour. Only the coordinates are kept, the colour being the one of the bucket
+     */
+    class colour_bucket_stream
+    {
+    public:
+        /**
+         * @brief colour_bucket_stream Creates an empty stream
+         * @param spill_path Path of the spill file, which is created and then removed by the destructor
+         * @param max_buffered_points Number of points buffered in memory before they are spilled
+         * @throw cos_lib::except::invalid_path if the spill file cannot be created
+         */
+        colour_bucket_stream(std::string spill_path, size_t max_buffered_points = 1 << 24);
+
+        ~colour_bucket_stream();
+
+        colour_bucket_stream(const colour_bucket_stream&) = delete;
+        colour_bucket_stream& operator=(const colour_bucket_stream&) = delete;
+
+        /**
+         * @brief add Adds the points of a batch to the buckets of their colours
+         * @throw cos_lib::except::invalid_path if the spill file cannot be written
+         */
+        void add(const pcl::PointCloud<pcl::PointXYZRGB>& batch);
+
+        /**
+         * @brief getColours Gets the packed colours of the buckets, by increasing colour
+         */
+        std::vector<uint32_t> getColours() const;
+
+        /**
+         * @brief getBucketSize Gets how many points have a colour
+         */
+        size_t getBucketSize(uint32_t colour) const;
+
+        /**
+         * @brief getNbPoints Gets how many points were added
+         */
+        size_t getNbPoints() const { return this->nb_points; }
+
+        /**
+         * @brief loadBucket Reads the points of a colour, in the order they were added
+         * @throw cos_lib::except::invalid_path if the spill file cannot be read
+         * @return a pointer to a cloud holding the points of the colour, empty if no point has it
+         */
+        pcl::PointCloud<pcl::PointXYZRGB>::Ptr loadBucket(uint32_t colour);
+
+    private:
+        /**
+         * @brief The segment struct is a run of points of one colour in the spill file
+         */
+        struct segment
+        {
+            uint64_t offset;
+            size_t nb_points;
+        };
+
+        struct bucket
+        {
+            bucket() : nb_points(0) { }
+
+            size_t nb_points;
+            std::vector<cos_lib::colour_bucket_stream::segment> segments;
+            std::vector<float> buffer;      // x, y and z of the points not spilled yet
+        };
+
+        /**
+         * @brief flush Appends every buffer to the spill file and frees them
+         */
+        void flush();
+
+        std::string spill_path;
+        std::fstream spill;
+        uint64_t spill_size;
+        size_t max_buffered_points;
+        size_t nb_buffered_points;
+        size_t nb_points;
+        std::map<uint32_t, cos_lib::colour_bucket_stream::bucket> buckets;
+    };
+}
+
+#endif // COLOUR_BUCKETS_H
@@ -0,0 +1,77 @@
+#include <vector>
+#include <stdexcept>
+#include <stdint.h>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+#ifndef COLOUR_QUANTIZER_H
+#define COLOUR_QUANTIZER_H
+
+namespace cos_lib
+{
+    /**
+     * @brief The colour_histogram struct counts the points of each colour of a cloud
+     * @details Colours are packed on 24 bits (red << 16 | green << 8 | blue) and sorted by increasing colour, only the colours found are kept
+     */
+    struct colour_histogram
+    {
+        std::vector<uint32_t> colours;
+        std::vector<uint32_t> counts;
+    };
+
+    /**
+     * @brief The colour_quantizer class rounds the channels of colours down to a multiple of epsilon, as homogenize_cloud does
+     * @details The rounded value of each channel is looked up in a table of 256 entries built once per epsilon, already shifted to its place in a
+     * packed colour, so a colour is quantized with three lookups and no division
+     */
+    class colour_quantizer
+    {
+    public:
+        /**
+         * @brief colour_quantizer Builds the tables of an epsilon
+         * @param epsilon Size of the cube used to regroup colours, a negative epsilon acting as its opposite
+         * @throw std::invalid_argument if epsilon is null
+         */
+        colour_quantizer(short epsilon);
+
+        /**
+         * @brief quantize Quantizes a packed colour, the bits above the 24 colour bits being kept
+         */
+        uint32_t quantize(uint32_t rgba) const { return this->red[(rgba >> 16) & 0xFF] | this->green[(rgba >> 8) & 0xFF] | this->blue[rgba & 0xFF] | (rgba & 0xFF000000); }
+
+        /**
+         * @brief apply Quantizes in place the colours of the points of a batch, the batch being cut into one chunk per thread
+         * @param batch Points to be quantized
+         */
+        void apply(pcl::PointCloud<pcl::PointXYZRGB>& batch) const;
+
+        /**
+         * @brief apply Quantizes in place the colours of the points of a batch and counts the points of each quantized colour in the same pass
+         * @param batch Points to be quantized
+         * @param histogram Set to the histogram of the quantized batch
+         * @throw std::invalid_argument if the batch holds 2^32 points or more
+         */
+        void apply(pcl::PointCloud<pcl::PointXYZRGB>& batch, cos_lib::colour_histogram& histogram) const;
+
+        /**
+         * @brief getNbLevels Gets how many values a quantized channel can take
+         */
+        size_t getNbLevels() const { return this->nb_levels; }
+
+    private:
+        /**
+         * @brief red Quantized red channel of each red value, shifted by 16 bits, green and blue being shifted by 8 and 0 bits
+         */
+        uint32_t red[256];
+        uint32_t green[256];
+        uint32_t blue[256];
+        /**
+         * @brief levels Rank of the quantized value of each channel value, used to index the cells of a histogram
+         */
+        uint32_t levels[256];
+        size_t nb_levels;
+        size_t step;
+    };
+}
+
+#endif // COLOUR_QUANTIZER_H
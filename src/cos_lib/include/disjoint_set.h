@@ -0,0 +1,53 @@
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include <stdlib.h>
+#include <stdint.h>
+
+#ifndef DISJOINT_SET_H
+#define DISJOINT_SET_H
+
+namespace cos_lib
+{
+    /**
+     * @brief The disjoint_set class is a lock-free union-find structure over the indices of a cloud
+     * @details Several threads can join sets at the same time. A root is always linked under the smaller of the two roots,
+     * so once every union is done the representative of a set is the smallest index it contains
+     */
+    class disjoint_set
+    {
+    public:
+        /**
+         * @brief disjoint_set Creates as many sets as there are elements, each element being alone in its set
+         * @param nb_elements Number of elements
+         */
+        disjoint_set(size_t nb_elements);
+
+        /**
+         * @brief find Gets the representative of the set an element belongs to
+         * @param element Index of the element
+         * @return The index of the representative
+         */
+        uint32_t find(uint32_t element);
+
+        /**
+         * @brief unite Merges the sets two elements belong to
+         * @param element_a Index of the first element
+         * @param element_b Index of the second element
+         */
+        void unite(uint32_t element_a, uint32_t element_b);
+
+        /**
+         * @brief size Gets the number of elements
+         */
+        size_t size() const { return this->parents.size(); }
+
+    private:
+        /**
+         * @brief parents Parent of each element, a root being its own parent
+         */
+        std::vector<std::atomic<uint32_t>> parents;
+    };
+}
+
+#endif // DISJOINT_SET_H
@@ -6,6 +6,7 @@
 #define IMAGE_GREYSCALE_H
 
 #include "image.h"
+#include "pixel_buffer.h"
 
 #include <vector>
 #include <stdexcept>
@@ -15,7 +16,7 @@ namespace cos_lib
     class image_greyscale : public image
     {
     private:
-        std::vector<std::vector<unsigned short>> _pixels;
+        cos_lib::pixel_buffer<unsigned short> _pixels;
     public:
         /**
          * @brief image_greyscale is the class constructor
@@ -24,11 +25,25 @@ namespace cos_lib
          */
         image_greyscale(size_t width, size_t height);
 
+        /**
+         * @brief image_greyscale is the constructor of an image holding an existing plane, whose memory may be shared
+         * @param pixels is the plane of grey values, whose size is the size of the image
+         */
+        image_greyscale(cos_lib::pixel_buffer<unsigned short> pixels);
+
         /** @brief get_grey_at gets grey value at coordinates [y, x] */
-        unsigned short get_grey_at(size_t y, size_t x) const;
+        unsigned short get_grey_at(size_t y, size_t x) const { return _pixels.row(y)[x]; }
 
         /** @brief set_grey_at sets grey value at coordinates [y, x] */
-        void set_grey_at(size_t y, size_t x, unsigned short grey);
+        void set_grey_at(size_t y, size_t x, unsigned short grey) { _pixels.row(y)[x] = grey; }
+
+        /** @brief row gets a pointer to the first grey value of row y, the values of a row being contiguous */
+        unsigned short* row(size_t y) { return _pixels.row(y); }
+        const unsigned short* row(size_t y) const { return _pixels.row(y); }
+
+        /** @brief pixels gets the plane holding the grey values */
+        cos_lib::pixel_buffer<unsigned short>& pixels() { return _pixels; }
+        const cos_lib::pixel_buffer<unsigned short>& pixels() const { return _pixels; }
 
         /** @brief init initializes image pixels */
         virtual void init();
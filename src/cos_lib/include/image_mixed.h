@@ -6,6 +6,7 @@
 #define IMAGE_MIXED_H
 
 #include "image.h"
+#include "pixel_buffer.h"
 
 #include <stdint.h>
 #include <stdexcept>
@@ -13,10 +14,14 @@
 
 namespace cos_lib
 {
+    /**
+     * @brief The image_mixed class holds a grey value and an rgb value per pixel, stored in two separate planes
+     */
     class image_mixed : public image
     {
     private:
-        std::vector<std::vector<std::pair<unsigned short, uint32_t> *>> _pixels;
+        cos_lib::pixel_buffer<unsigned short> _grey_pixels;
+        cos_lib::pixel_buffer<uint32_t> _rgb_pixels;
     public:
         /**
          * @brief image_mixed is the class constructor
@@ -26,25 +31,41 @@ namespace cos_lib
         image_mixed(size_t width, size_t height);
 
         /** @brief get_grey_at gets grey value at coordinates [y, x] */
-        unsigned short get_grey_at(size_t y, size_t x) const;
+        unsigned short get_grey_at(size_t y, size_t x) const { return _grey_pixels.row(y)[x]; }
 
         /** @brief get_rgb_at gets rgb value at coordinates [y, x] */
-        uint32_t get_rgb_at(size_t y, size_t x) const;
+        uint32_t get_rgb_at(size_t y, size_t x) const { return _rgb_pixels.row(y)[x]; }
 
         /** @brief get_red_at gets red value at coordinates [y, x] */
-        uint8_t get_red_at(size_t y, size_t x) const;
+        uint8_t get_red_at(size_t y, size_t x) const { return (_rgb_pixels.row(y)[x] >> 16) & 0x0000ff; }
 
         /** @brief get_green_at gets green value at coordinates [y, x] */
-        uint8_t get_green_at(size_t y, size_t x) const;
+        uint8_t get_green_at(size_t y, size_t x) const { return (_rgb_pixels.row(y)[x] >> 8) & 0x0000ff; }
 
         /** @brief get_blue_at gets blue value at coordinates [y, x] */
-        uint8_t get_blue_at(size_t y, size_t x) const;
+        uint8_t get_blue_at(size_t y, size_t x) const { return _rgb_pixels.row(y)[x] & 0x0000ff; }
 
         /** @brief set_grey_at sets grey value at coordinates [y, x] */
-        void set_grey_at(size_t y, size_t x, unsigned short grey);
+        void set_grey_at(size_t y, size_t x, unsigned short grey) { _grey_pixels.row(y)[x] = grey; }
 
         /** @brief set_rgb_at sets rgb value at coordinates [y, x] */
-        void set_rgb_at(size_t y, size_t x, uint32_t rgb);
+        void set_rgb_at(size_t y, size_t x, uint32_t rgb) { _rgb_pixels.row(y)[x] = rgb; }
+
+        /** @brief grey_row gets a pointer to the first grey value of row y */
+        unsigned short* grey_row(size_t y) { return _grey_pixels.row(y); }
+        const unsigned short* grey_row(size_t y) const { return _grey_pixels.row(y); }
+
+        /** @brief rgb_row gets a pointer to the first rgb value of row y */
+        uint32_t* rgb_row(size_t y) { return _rgb_pixels.row(y); }
+        const uint32_t* rgb_row(size_t y) const { return _rgb_pixels.row(y); }
+
+        /** @brief grey_plane gets the plane holding the grey values */
+        cos_lib::pixel_buffer<unsigned short>& grey_plane() { return _grey_pixels; }
+        const cos_lib::pixel_buffer<unsigned short>& grey_plane() const { return _grey_pixels; }
+
+        /** @brief rgb_plane gets the plane holding the rgb values */
+        cos_lib::pixel_buffer<uint32_t>& rgb_plane() { return _rgb_pixels; }
+        const cos_lib::pixel_buffer<uint32_t>& rgb_plane() const { return _rgb_pixels; }
 
         /** @brief init initializes image pixels */
         virtual void init();
@@ -10,12 +10,15 @@
 #include "../include/image_greyscale.h"
 #include "../include/image_rgb.h"
 #include "../include/image_mixed.h"
+#include "../include/pixel_buffer.h"
 #include "../include/point_xy_greyscale.h"
 #include "../include/point_xy_rgb.h"
 #include "../include/point_xy_mixed.h"
 #include "../include/invalid_cloud_pointer.h"
 
 #include <vector>
+#include <memory>
+#include <atomic>
 #include <stdint.h>
 
 #include <pcl/point_cloud.h>
@@ -72,17 +75,93 @@ namespace cos_lib
          * @param mixed_img the mixed image to be turned into rgb
          * @return the rgb image
          */
-        image_rgb mixed_image_to_rgb(image_mixed mixed_img);
+        image_rgb mixed_image_to_rgb(const image_mixed& mixed_img);
 
         /**
          * @brief mixed_image_to_greyscale turns a mixed image into a grey scale image
          * @param mixed_img the mixed image to be turned into grey scale
          * @return the grey scale image
          */
-        image_greyscale mixed_image_to_greyscale(image_mixed mixed_img);
+        image_greyscale mixed_image_to_greyscale(const image_mixed& mixed_img);
+
+        /**
+         * @brief The cloud_raster struct holds a cloud rasterized by cloud_to_raster, with what is needed to go back to the cloud
+         */
+        struct cloud_raster
+        {
+            /** @brief empty_pixel is the point index of the pixels on which no point is drawn */
+            static const uint32_t empty_pixel = UINT32_MAX;
+
+            cos_lib::image_mixed image;                         // depth as grey values and colours of the drawn points
+            cos_lib::pixel_buffer<uint32_t> point_indices;      // index in the cloud of the point drawn on each pixel
+            cos_lib::cloud_manip::cloud_bounds bounds;          // bounds of the cloud, which the image spans
+
+            /**
+             * @brief cloud_raster is the constructor, the pixels are set to 0
+             * @param width is the width of the image in pixels
+             * @param height is the height of the image in pixels
+             */
+            cloud_raster(size_t width, size_t height);
+
+            /**
+             * @brief pixel_of finds the pixel a point of the cloud falls on, whether it is drawn on it or hidden by a higher one
+             * @param point is a point of the rasterized cloud
+             * @param x is set to the column of the pixel
+             * @param y is set to the row of the pixel
+             * @return false if the point is out of the bounds of the image
+             */
+            bool pixel_of(const pcl::PointXYZRGB& point, size_t& x, size_t& y) const;
+        };
+
+        /**
+         * @brief cloud_to_raster rasterizes a cloud into a mixed image, its depth as grey values and its colours
+         * @details the bounds of the cloud are found in one reduction, then every point is drawn in one parallel pass:
+         * a pixel takes the grey value and the colour of its highest point, the first in the cloud on ties,
+         * as mixed_vector_to_image does with the points of cloud_to_2d_mixed
+         * @param cloud_ptr is a pointer to the cloud to be rasterized
+         * @param width is the width of the image
+         * @param height is the height of the image
+         * @throw invalid_cloud_pointer if cloud_ptr is equal to nullptr
+         * @throw std::invalid_argument if the image is empty or if the cloud holds 2^32 - 1 points or more
+         * @return the image with the index of the point drawn on each pixel and the bounds of the cloud
+         */
+        cloud_raster cloud_to_raster(
+                pcl::PointCloud<pcl::PointXYZRGB>::ConstPtr cloud_ptr, size_t width, size_t height);
+
+        /**
+         * @brief cloud_to_mixed_image rasterizes a cloud into a mixed image as cloud_to_raster does, keeping the image only
+         * @throw invalid_cloud_pointer if cloud_ptr is equal to nullptr
+         * @throw std::invalid_argument if the image is empty or if the cloud holds 2^32 - 1 points or more
+         */
+        image_mixed cloud_to_mixed_image(
+                pcl::PointCloud<pcl::PointXYZRGB>::ConstPtr cloud_ptr, size_t width, size_t height);
+
+        /**
+         * @brief raster_to_cloud creates a point cloud from the pixels of a raster on which a point is drawn
+         * @details each of these pixels gives one point, placed as mixed_image_to_cloud does from the grey value
+         * and the colour of the image, which may have been modified since the rasterization; empty pixels give no point
+         * @param raster is the rasterized cloud
+         * @return a pointer to the resulted cloud
+         */
+        pcl::PointCloud<pcl::PointXYZRGB>::Ptr raster_to_cloud(const cloud_raster& raster);
+
+        /**
+         * @brief select_points keeps the points of a rasterized cloud which fall on the non null pixels of a mask
+         * @details the original points are kept as they are, so that a 2D result such as detect_contours applies to the cloud
+         * @param raster is the raster of the cloud
+         * @param cloud_ptr is a pointer to the cloud given to cloud_to_raster
+         * @param mask is an image of the size of the raster
+         * @throw invalid_cloud_pointer if cloud_ptr is equal to nullptr
+         * @throw std::invalid_argument if the mask and the raster are not of the same size
+         * @return a pointer to the cloud of the selected points, in their original order
+         */
+        pcl::PointCloud<pcl::PointXYZRGB>::Ptr select_points(
+                const cloud_raster& raster, pcl::PointCloud<pcl::PointXYZRGB>::ConstPtr cloud_ptr,
+                const image_greyscale& mask);
 
         /**
          * @brief cloud_to_depth creates a depth image based on a point cloud
+         * @details the grey plane of cloud_to_mixed_image is kept as is
          * @param cloud_ptr is a pointer to our point cloud
          * @param width is the width of the image
          * @param height is the height of the image
@@ -93,49 +172,78 @@ namespace cos_lib
 
         /**
          * @brief mixed_image_to_cloud creates a pointer to a point cloud based on a mixed image
+         * @details every pixel gives a point, raster_to_cloud skips the empty ones without going through the base cloud
          * @param mixed is the image that serves as the base for the creation of the point cloud
          * @param base_cloud_ptr is a pointer to the cloud used to create the image
          * @throw invalid_cloud_pointer if base_cloud_ptr is equal to nullptr
          * @return a pointer to the resulted cloud
          */
         pcl::PointCloud<pcl::PointXYZRGB>::Ptr mixed_image_to_cloud(
-                image_mixed mixed_img,
+                const image_mixed& mixed_img,
                 pcl::PointCloud<pcl::PointXYZRGB>::Ptr base_cloud_ptr);
 
         /**
          * @brief greyscale_image_to_mat transforms an cos_lib::image_greyscale object into a cv::Mat object
+         * @details the grey values are converted to CV_8UC1 in one pass, values above 255 being saturated;
+         * mat_view wraps the image without any conversion
          * @param gs_img is the cos_lib::image_greyscale to be transformed into a Mat
          * @return the grey scale image as a Mat object
          */
-        cv::Mat greyscale_image_to_mat(image_greyscale gs_img);
+        cv::Mat greyscale_image_to_mat(const image_greyscale& gs_img);
 
         /**
          * @brief rgb_image_to_mat transforms an cos_lib::image_rgb object into a cv::Mat object
+         * @details the Mat is of type CV_8UC3, red being its first channel; mat_view wraps the image without any conversion
          * @param rgb_img is the cos_lib::image_rgb to be transformed into a Mat
          * @return the rgb image as a Mat object
          */
-        cv::Mat rgb_image_to_mat(image_rgb rgb_img);
+        cv::Mat rgb_image_to_mat(const image_rgb& rgb_img);
+
+        /**
+         * @brief mat_view wraps a plane of grey values into a cv::Mat of type CV_16UC1 without copying its pixels
+         * @details the Mat shares the memory of the plane, rows and padding included, so it must not outlive it
+         * @param plane is the plane to be wrapped
+         * @return a Mat header over the plane
+         */
+        cv::Mat mat_view(cos_lib::pixel_buffer<unsigned short>& plane);
+
+        /**
+         * @brief mat_view wraps a plane of rgb values into a cv::Mat of type CV_8UC4 without copying its pixels
+         * @details the bytes of a 0x00RRGGBB value being stored as blue, green, red, 0 on little-endian machines,
+         * the Mat is in the BGRA order of OpenCV, with a null alpha; it must not outlive the plane
+         * @param plane is the plane to be wrapped
+         * @return a Mat header over the plane
+         */
+        cv::Mat mat_view(cos_lib::pixel_buffer<uint32_t>& plane);
 
         /**
          * @brief mat_to_greyscale_image transforms a cv::Mat object into an cos_lib::image_greyscale object
+         * @details a CV_16UC1 Mat is not copied, the image sharing its memory and keeping it alive,
+         * while a CV_8UC1 Mat is converted in one pass
          * @param gs_mat is the Mat to be transformed
+         * @throw std::invalid_argument if gs_mat is neither of type CV_8UC1 nor CV_16UC1
          * @return an cos_lib::image_greyscale object
          */
         image_greyscale mat_to_greyscale_image(cv::Mat gs_mat);
 
         /**
          * @brief mat_to_rgb_image transforms a cv::Mat object into an cos_lib::image_rgb object
+         * @details a CV_8UC4 Mat in the BGRA order of mat_view whose alpha is 0 everywhere, as in the Mats of mat_view, is not copied,
+         * the image sharing its memory and keeping it alive; any other CV_8UC4 Mat is copied with its alpha cleared,
+         * while a CV_8UC3 Mat, red being its first channel as in rgb_image_to_mat, is converted in one pass
          * @param rgb_mat is the Mat to be transformed
+         * @throw std::invalid_argument if rgb_mat is neither of type CV_8UC3 nor CV_8UC4
          * @return an cos_lib::image_rgb object
          */
         image_rgb mat_to_rgb_image(cv::Mat rgb_mat);
 
         /**
          * @brief detect_contour is a function that detects contours in a depth image
+         * @details the images are wrapped into Mats, so that OpenCV reads and writes their pixels directly
          * @param gs_img is the image to detect the contours of
          * @return the contours in the depth image
          */
-        image_greyscale detect_contours(image_greyscale gs_img, int hist_num_cls);
+        image_greyscale detect_contours(const image_greyscale& gs_img, int hist_num_cls);
 
         /**
          * @brief remove_colors removes the parameter colors from the mixed image
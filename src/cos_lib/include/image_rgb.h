@@ -6,6 +6,7 @@
 #define IMAGE_RGB_H
 
 #include "image.h"
+#include "pixel_buffer.h"
 
 #include <stdint.h>
 #include <stdexcept>
@@ -16,7 +17,7 @@ namespace cos_lib
     class image_rgb : public image
     {
     private:
-        std::vector<std::vector<uint32_t>> _pixels;
+        cos_lib::pixel_buffer<uint32_t> _pixels;
     public:
         /**
          * @brief image_rgb is the class constructor
@@ -25,20 +26,34 @@ namespace cos_lib
          */
         image_rgb(size_t width, size_t height);
 
+        /**
+         * @brief image_rgb is the constructor of an image holding an existing plane, whose memory may be shared
+         * @param pixels is the plane of 0x00RRGGBB values, whose size is the size of the image
+         */
+        image_rgb(cos_lib::pixel_buffer<uint32_t> pixels);
+
         /** @brief get_rgb_at gets rgb value at coordinates [y, x] */
-        uint32_t get_rgb_at(size_t y, size_t x) const;
+        uint32_t get_rgb_at(size_t y, size_t x) const { return _pixels.row(y)[x]; }
 
         /** @brief get_red_at gets red value at coordinates [y, x] */
-        uint8_t get_red_at(size_t y, size_t x) const;
+        uint8_t get_red_at(size_t y, size_t x) const { return (_pixels.row(y)[x] >> 16) & 0x0000ff; }
 
         /** @brief get_green_at gets green value at coordinates [y, x] */
-        uint8_t get_green_at(size_t y, size_t x) const;
+        uint8_t get_green_at(size_t y, size_t x) const { return (_pixels.row(y)[x] >> 8) & 0x0000ff; }
 
         /** @brief get_blue_at gets blue value at coordinates [y, x] */
-        uint8_t get_blue_at(size_t y, size_t x) const;
+        uint8_t get_blue_at(size_t y, size_t x) const { return _pixels.row(y)[x] & 0x0000ff; }
 
         /** @brief set_rgb_at sets rgb value at coordinates [y, x] */
-        void set_rgb_at(size_t y, size_t x, uint32_t rgb);
+        void set_rgb_at(size_t y, size_t x, uint32_t rgb) { _pixels.row(y)[x] = rgb; }
+
+        /** @brief row gets a pointer to the first 0x00RRGGBB value of row y, the values of a row being contiguous */
+        uint32_t* row(size_t y) { return _pixels.row(y); }
+        const uint32_t* row(size_t y) const { return _pixels.row(y); }
+
+        /** @brief pixels gets the plane holding the rgb values */
+        cos_lib::pixel_buffer<uint32_t>& pixels() { return _pixels; }
+        const cos_lib::pixel_buffer<uint32_t>& pixels() const { return _pixels; }
 
         /** @brief init initializes image pixels */
         virtual void init();
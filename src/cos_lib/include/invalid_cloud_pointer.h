@@ -14,7 +14,7 @@ namespace cos_lib
             const char *_what = "Invalid cloud pointer argument.";
 
         public:
-            invalid_cloud_pointer() : std::invalid_argument(_what) { }
+            invalid_cloud_pointer() : std::invalid_argument("Invalid cloud pointer argument.") { }
             virtual const char *what() const throw() { return _what; }
         };
     }
@@ -14,7 +14,7 @@ namespace cos_lib
             const char *_what = "Invalid path argument.";
 
         public:
-            invalid_path() : std::invalid_argument(_what) { }
+            invalid_path() : std::invalid_argument("Invalid path argument.") { }
             virtual const char *what() const throw() { return _what; }
         };
     }
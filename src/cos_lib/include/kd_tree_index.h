@@ -0,0 +1,44 @@
+#include <pcl/kdtree/impl/kdtree_flann.hpp>
+#include "spatial_index.h"
+
+#ifndef KD_TREE_INDEX_H
+#define KD_TREE_INDEX_H
+
+namespace cos_lib
+{
+    /**
+     * @brief The kd_tree_index class answers neighbour queries with a FLANN kd-tree
+     * @details Unlike the voxel hash, it does not depend on the search radius, so it is the one to use when the
+     * queries mix very different radii or when the points are very unevenly spread
+     */
+    class kd_tree_index : public spatial_index
+    {
+    public:
+        /**
+         * @brief kd_tree_index Default constructor, creates an empty index
+         */
+        kd_tree_index();
+
+        size_t radiusSearch(const pcl::PointXYZ& query, double radius, std::vector<uint32_t>& positions,
+                            std::vector<float>& sq_distances, size_t max_neighbours) const;
+
+        size_t nearestKSearch(const pcl::PointXYZ& query, size_t k, std::vector<uint32_t>& positions,
+                              std::vector<float>& sq_distances) const;
+
+    protected:
+        void buildStructure();
+
+    private:
+        /**
+         * @brief kdtree The kd-tree built on the coordinates
+         */
+        pcl::KdTreeFLANN<pcl::PointXYZ> kdtree;
+
+        /**
+         * @brief copyResults Converts the results of the kd-tree to positions
+         */
+        static size_t copyResults(const std::vector<int>& PointsID, std::vector<uint32_t>& positions);
+    };
+}
+
+#endif // KD_TREE_INDEX_H
@@ -0,0 +1,63 @@
+#ifndef LAS_FORMAT_H
+#define LAS_FORMAT_H
+
+#include "../include/invalid_path.h"
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <pcl/point_types.h>
+
+namespace cos_lib
+{
+    namespace io
+    {
+        /**
+         * @brief The las_header struct holds what is needed from the header of a .las file to read its points
+         */
+        struct las_header
+        {
+            uint8_t version_major;
+            uint8_t version_minor;
+            uint8_t point_format;       // point data record format, 0 to 10
+            bool is_compressed;         // the points are compressed by LASzip, the file being a .laz
+            size_t point_step;          // size in bytes of a point record
+            size_t nb_points;
+            size_t data_offset;         // position of the first point record
+            double scale[3];            // a coordinate is its integer times the scale plus the offset
+            double offset[3];
+            double origin[3];           // the points are decoded relative to it, so that their float coordinates keep the precision of the file
+            int colour_offset;          // position of the red, green and blue integers in a point record, -1 if the format has none
+        };
+
+        /**
+         * @brief parse_las_header reads the header of a .las or .laz file
+         * @details the origin is the minimum corner of the bounds of the header, floored, or the offset if the bounds are not finite:
+         * georeferenced coordinates are too big for a float to keep their centimetres, while their distance to the origin is not
+         * @param begin is a pointer to the first byte of the file
+         * @param end is a pointer past the last byte of the file
+         * @throw invalid_path if the file is not a .las file, if its point format is unknown, or if its points are not all in
+         * the file while not being compressed
+         * @return the header
+         */
+        cos_lib::io::las_header parse_las_header(const char* begin, const char* end);
+
+        /**
+         * @brief decode_las_colour_max gets the biggest colour component of a point record, 0 if the format has no colour
+         */
+        uint16_t decode_las_colour_max(const cos_lib::io::las_header& header, const char* record);
+
+        /**
+         * @brief decode_las_point reads a point record
+         * @details the coordinates are relative to the origin of the header, the points without colour are white
+         * @param header is the header of the file
+         * @param record is a pointer to the first byte of the point record
+         * @param colour_shift is the number of bits the 16 bits colour components are shifted right by, 8 for 16 bits
+         * colours and 0 for files storing 8 bits colours in the 16 bits components
+         * @param point is set to the point read
+         */
+        void decode_las_point(const cos_lib::io::las_header& header, const char* record, int colour_shift, pcl::PointXYZRGB& point);
+    }
+}
+
+#endif // LAS_FORMAT_H
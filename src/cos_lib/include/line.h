@@ -12,7 +12,7 @@ namespace cos_lib
     {
     private:
         std::vector<int> inliers;
-        Eigen::VectorXf* coefficients;
+        Eigen::VectorXf coefficients;
 
     public:
         /**
@@ -23,9 +23,9 @@ namespace cos_lib
         /**
          * @brief Line basic initialization constructor
          * @param inliers the indices of the inliers of the line
-         * @param coefficients the coefficients that define the line
+         * @param coefficients the coefficients that define the line, a point of the line followed by its direction, which are copied
          */
-        Line(std::vector<int> inliers, Eigen::VectorXf* coefficients);
+        Line(std::vector<int> inliers, Eigen::VectorXf coefficients);
 
         /**
          * @brief getInliers returns the indices of the inliers
@@ -37,7 +37,7 @@ namespace cos_lib
          * @brief getCoefficients
          * @return Eigen::vectorXf
          */
-        Eigen::VectorXf* getCoefficients();
+        Eigen::VectorXf getCoefficients();
 
         /**
          * @brief getAnglesToOrigin WIP not working, just used for testing
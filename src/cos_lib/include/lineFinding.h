@@ -5,6 +5,7 @@
 #include <pcl/point_types.h>
 #include <boost/shared_ptr.hpp>
 #include <vector>
+#include <stdint.h>
 #include "plane.h"
 #include "line.h"
 
@@ -64,31 +65,58 @@ namespace cos_lib
     std::vector<int> colorRandomizer();
 
     /**
-     * @brief findALineInYDirection finds a line in the Y direction of the point cloud with rRANSAC
+     * @brief findALineInYDirection finds a line within 45 degrees of the Y direction of the point cloud with RANSAC
      * @param cloud IN the cloud to look for the line in
-     * @return the Line object found
+     * @return the Line object found, NULL if no line follows the Y direction
      */
     Line* findALineInYDirection(pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud);
 
     /**
-     * @brief findLinesInYDirection finds multiple lines in Y direction
-     * @param cloud IN the base point cloud
+     * @brief findALineAlongAxis finds the best line within an angle of an axis with RANSAC, the samples giving another direction
+     * being rejected before any point is scored against them
+     * @param cloud IN the cloud to look for the line in
+     * @param axis IN the direction the line must follow, either way
+     * @param maxAngle IN the maximum angle in radians between the line and the axis
+     * @param distanceThreshold IN distance under which a point belongs to the line
+     * @return the Line object found, NULL if no line follows the axis
+     */
+    Line* findALineAlongAxis(pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud, const Eigen::Vector3f& axis, double maxAngle, double distanceThreshold=0.01);
+
+    /**
+     * @brief findLinesInYDirection finds multiple lines within 45 degrees of the Y direction with RANSAC drawing its samples in the cells
+     * of an octree, until such a line of pointsPerLine points is unlikely to be left
+     * @param cloud IN OUT the base point cloud, replaced by the lines found
+     * @param distanceThreshold IN distance under which a point belongs to a line
+     * @param pointsPerLine IN minimum number of points of a line, at least 2
      */
-    void findLinesInYDirection(pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud);
+    void findLinesInYDirection(pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud, double distanceThreshold=0.01, int pointsPerLine=100);
 
     /**
-     * @brief findLinesInClusters looks for lines in clusters of points created by the color segmentation part of the project
+     * @brief findLinesInClusters looks for lines in clusters of points created by the color segmentation part of the project,
+     * the clusters being processed in parallel
      * @param clusters IN vector of Point clouds
-     * @return returns a point cloud containing the lines found
+     * @param lines OUT if not NULL, set to the lines found, their inliers being the indices of their points in the cloud returned
+     * @param seed IN the seed of the samples and of the colors, each cluster drawing them from its own generator
+     * @param distanceThreshold IN distance under which a point belongs to a line
+     * @param pointsPerLine IN minimum number of points of a line
+     * @throw invalid_cloud_pointer if a cluster is NULL
+     * @throw std::invalid_argument if distanceThreshold is negative or NaN, if pointsPerLine is lower than 2 or if a cluster holds too many points
+     * @return returns a point cloud containing the lines found, the lines of each cluster following the lines of the previous one
      */
-    pcl::PointCloud<pcl::PointXYZRGB>::Ptr findLinesInClusters(std::vector<pcl::PointCloud<pcl::PointXYZRGB>::Ptr> clusters);
+    pcl::PointCloud<pcl::PointXYZRGB>::Ptr findLinesInClusters(std::vector<pcl::PointCloud<pcl::PointXYZRGB>::Ptr> clusters, std::vector<Line>* lines=NULL,
+                                                               uint64_t seed=0, double distanceThreshold=0.01, int pointsPerLine=100);
 
     /**
-     * @brief findLines finds multiple lines in one point cloud
+     * @brief findLines finds multiple lines in one point cloud with RANSAC drawing its samples in the cells of an octree,
+     * until a line of pointsPerLine points is unlikely to be left
      * @param cloud IN the base cloud
+     * @param distanceThreshold IN distance under which a point belongs to a line
+     * @param pointsPerLine IN minimum number of points of a line, at least 2
+     * @param lines OUT if not NULL, set to the lines found, their inliers being the indices of their points in the cloud returned
      * @return return a new cloud containing the lines
      */
-    pcl::PointCloud<pcl::PointXYZRGB>::Ptr findLines(pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud);
+    pcl::PointCloud<pcl::PointXYZRGB>::Ptr findLines(pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud, double distanceThreshold=0.01, int pointsPerLine=100,
+                                                     std::vector<Line>* lines=NULL);
 
     /**
      * @brief findBestLine finds the best line in one point cloud
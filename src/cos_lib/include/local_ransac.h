@@ -0,0 +1,138 @@
+#include <vector>
+#include <stdexcept>
+#include <stdint.h>
+#include <Eigen/Core>
+#include "model_extraction.h"
+#include "ransac_engine.h"
+#include "sampling_octree.h"
+
+#ifndef LOCAL_RANSAC_H
+#define LOCAL_RANSAC_H
+
+namespace cos_lib
+{
+    /**
+     * @brief The local_ransac_extractor class extracts the models of a point_buffer one after the other, drawing samples localized in an octree
+     * @details This follows the Efficient RANSAC of Schnabel et al.: the first point of a sample is drawn from the whole buffer and the others
+     * from the cell of the octree containing it, so a small structure gets minimal samples made of its own points. The level of the cell is
+     * drawn with a probability following the scores of the candidates each level gave so far.
+     * Candidates are scored on a random subset of the buffer, large enough for a model with min_support inliers to be seen in it, and kept
+     * in a priority queue shared by all the extractions under an upper confidence bound of their score, the best one being scored on the
+     * whole buffer before it is extracted. A model is extracted once a better one is unlikely to have been missed, and the
+     * extraction stops once a model with enough inliers is unlikely to be left, or once the budget of candidates is spent
+     */
+    class local_ransac_extractor
+    {
+    public:
+        /**
+         * @brief local_ransac_extractor Creates an extractor
+         * @param buffer Points the models are extracted from, which must outlive the extractor and only be changed by it
+         * @param model Model extracted, which must outlive the extractor
+         * @param distance_threshold Distance under which a point is an inlier of a model
+         * @param min_support Minimum number of inliers of a model
+         * @param seed Seed of the generators drawing the samples
+         * @throw std::invalid_argument if the threshold is negative or if min_support is lower than the sample size of the model
+         */
+        local_ransac_extractor(cos_lib::point_buffer& buffer, const cos_lib::sac_model& model, double distance_threshold, size_t min_support, uint64_t seed = 0);
+
+        /**
+         * @brief setProbability Sets the probability of not missing a better model, 0.99 by default
+         * @throw std::invalid_argument if the probability is not strictly between 0 and 1
+         */
+        void setProbability(double probability);
+
+        /**
+         * @brief setMaxCandidates Sets the number of candidates that can be drawn over all the extractions, 100000 by default
+         */
+        void setMaxCandidates(size_t max_candidates) { this->max_candidates = max_candidates; }
+
+        /**
+         * @brief setRefinement Sets whether models are fitted again on their inliers with least squares before being extracted, which is not done by default
+         */
+        void setRefinement(bool refine) { this->refine = refine; }
+
+        /**
+         * @brief extractModel Finds the model explaining the most active points and deactivates its inliers
+         * @return Indices in the cloud of the inliers of the model sorted by increasing index, empty if no model with min_support inliers is left
+         */
+        std::vector<int> extractModel();
+
+        /**
+         * @brief getModelCoefficients Gets the coefficients of the last model extracted
+         */
+        const Eigen::VectorXf& getModelCoefficients() const { return this->coefficients; }
+
+        /**
+         * @brief getStatistics Gets the work done by the last extraction
+         */
+        const cos_lib::ransac_statistics& getStatistics() const { return this->statistics; }
+
+    private:
+        /**
+         * @brief The candidate struct is a model kept in the priority queue
+         */
+        struct candidate
+        {
+            /**
+             * @brief score Number of inliers of the candidate, an upper confidence bound estimated from the subset or exact if scored after the last extraction
+             */
+            size_t score;
+            /**
+             * @brief scored_at Number of extractions done when the exact score was computed, SIZE_MAX while the score is estimated
+             */
+            size_t scored_at;
+            /**
+             * @brief rank Order in which the candidates were drawn, which breaks ties
+             */
+            size_t rank;
+            Eigen::VectorXf coefficients;
+
+            bool operator<(const candidate& other) const { return this->score < other.score || (this->score == other.score && this->rank > other.rank); }
+        };
+
+        cos_lib::point_buffer& buffer;
+        const cos_lib::sac_model& model;
+        float distance_threshold;
+        size_t min_support;
+        double probability;
+        size_t max_candidates;
+        bool refine;
+        uint64_t seed;
+
+        cos_lib::sampling_octree octree;
+        /**
+         * @brief octree_size Size of the buffer when the octree was built, the octree being rebuilt once the buffer is compacted
+         */
+        size_t octree_size;
+        /**
+         * @brief level_scores Sum of the scores of the candidates drawn at each level of the octree
+         */
+        std::vector<double> level_scores;
+        /**
+         * @brief candidates Max-heap of the candidates
+         */
+        std::vector<candidate> candidates;
+        size_t nb_drawn;
+        size_t nb_extracted;
+        /**
+         * @brief coverage Sum over the candidates drawn of the probability that a sample of a given point is drawn, as the active points
+         * were when the candidate was drawn, so that a model with n inliers was missed with a probability of exp(-n * coverage)
+         */
+        double coverage;
+
+        Eigen::VectorXf coefficients;
+        cos_lib::ransac_statistics statistics;
+
+        /**
+         * @brief missProbability Gets the probability that no sample of a model with a number of inliers was drawn among the candidates
+         */
+        double missProbability(size_t nb_inliers) const;
+
+        /**
+         * @brief drawCandidates Draws a batch of candidates, scores them on a subset and pushes in the queue those which may have min_support inliers
+         */
+        void drawCandidates();
+    };
+}
+
+#endif // LOCAL_RANSAC_H
@@ -0,0 +1,213 @@
+#include <vector>
+#include <stdexcept>
+#include <stdint.h>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <Eigen/Core>
+
+#ifndef MODEL_EXTRACTION_H
+#define MODEL_EXTRACTION_H
+
+namespace cos_lib
+{
+    /**
+     * @brief The sample_generator class is a splitmix64 generator, cheap enough to be seeded once per hypothesis
+     */
+    class sample_generator
+    {
+    public:
+        /**
+         * @brief sample_generator Seeds a generator, generators seeded with a different stream giving unrelated sequences
+         */
+        sample_generator(uint64_t seed, uint64_t stream = 0) { this->state = seed ^ (stream * 0xD1B54A32D192ED03ull); }
+
+        uint64_t next()
+        {
+            uint64_t value = (this->state += 0x9E3779B97F4A7C15ull);
+            value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+            value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+            return value ^ (value >> 31);
+        }
+
+        /**
+         * @brief nextBelow Draws an integer lower than a bound
+         */
+        size_t nextBelow(size_t bound) { return (size_t)(this->next() % bound); }
+
+    private:
+        uint64_t state;
+    };
+
+    /**
+     * @brief The point_buffer class holds the coordinates of a cloud in one array per axis, along with a mask of the points still to be explained
+     * @details The points are stored in a random order drawn from a seed, so any range of slots is a random sample of the cloud.
+     * Extracting a model from the buffer only clears the mask of its inliers, no point is copied. Once most of the slots are inactive
+     * the buffer is compacted, keeping the order of the slots, so that scanning it stays proportional to the number of active points
+     */
+    class point_buffer
+    {
+    public:
+        /**
+         * @brief point_buffer Copies the coordinates of a cloud in a random order, every point being active
+         * @param seed Seed of the order of the points
+         * @throw std::invalid_argument if the cloud holds 2^31 points or more
+         */
+        point_buffer(const pcl::PointCloud<pcl::PointXYZRGB>& cloud, uint64_t seed = 0);
+
+        /**
+         * @brief deactivate Clears the mask of a set of slots, the buffer being compacted if less than half of its slots stay active
+         * @param slots Slots to be deactivated, which are no longer valid after the call
+         */
+        void deactivate(const std::vector<size_t>& slots);
+
+        /**
+         * @brief getSize Gets the number of slots of the buffer, active or not
+         */
+        size_t getSize() const { return this->indices.size(); }
+
+        /**
+         * @brief getNbActive Gets the number of active points
+         */
+        size_t getNbActive() const { return this->nb_active; }
+
+        const float* getX() const { return this->x.data(); }
+        const float* getY() const { return this->y.data(); }
+        const float* getZ() const { return this->z.data(); }
+
+        /**
+         * @brief getActive Gets the mask of the slots, 1 for an active point and 0 otherwise
+         */
+        const uint8_t* getActive() const { return this->active.data(); }
+
+        /**
+         * @brief getIndex Gets the index in the cloud of the point of a slot
+         */
+        int getIndex(size_t slot) const { return this->indices[slot]; }
+
+    private:
+        std::vector<float> x;
+        std::vector<float> y;
+        std::vector<float> z;
+        std::vector<uint8_t> active;
+        std::vector<int> indices;
+        size_t nb_active;
+
+        /**
+         * @brief compact Moves the active points to the front of the buffer and drops the other slots
+         */
+        void compact();
+    };
+
+    /**
+     * @brief The sac_model class is the common interface of the models estimated by cos_lib::ransac_engine
+     * @details A model is fitted on a minimal sample of slots of a point_buffer and scored by counting the active points of a range of slots
+     * lying within a threshold of it. The coefficients follow the layout of the matching PCL model
+     */
+    class sac_model
+    {
+    public:
+        virtual ~sac_model() { }
+
+        /**
+         * @brief getSampleSize Gets the number of points a minimal sample is made of
+         */
+        virtual size_t getSampleSize() const = 0;
+
+        /**
+         * @brief fit Computes the model going through a minimal sample
+         * @param buffer Points the sample is taken from
+         * @param sample getSampleSize() distinct slots of the buffer
+         * @param coefficients Set to the coefficients of the model
+         * @return false if the sample is degenerate, the coefficients then being meaningless
+         */
+        virtual bool fit(const cos_lib::point_buffer& buffer, const size_t* sample, Eigen::VectorXf& coefficients) const = 0;
+
+        /**
+         * @brief countInliers Counts the active points of a range of slots lying within a threshold of the model
+         * @param begin First slot of the range
+         * @param end Slot past the last slot of the range
+         */
+        virtual size_t countInliers(const cos_lib::point_buffer& buffer, const Eigen::VectorXf& coefficients, float threshold, size_t begin, size_t end) const = 0;
+
+        /**
+         * @brief selectInliers Gets the slots of the active points lying within a threshold of the model, by increasing slot
+         */
+        virtual void selectInliers(const cos_lib::point_buffer& buffer, const Eigen::VectorXf& coefficients, float threshold, std::vector<size_t>& slots) const = 0;
+
+        /**
+         * @brief refit Computes the model fitting a set of points best in the least squares sense
+         * @param slots Slots of the points, at least getSampleSize() of them
+         * @return false if the points are degenerate
+         */
+        virtual bool refit(const cos_lib::point_buffer& buffer, const std::vector<size_t>& slots, Eigen::VectorXf& coefficients) const = 0;
+    };
+
+    /**
+     * @brief The plane_model class is the model of a plane, its coefficients (a, b, c, d) being a unit normal and an offset with a.x + b.y + c.z + d = 0
+     */
+    class plane_model : public sac_model
+    {
+    public:
+        size_t getSampleSize() const { return 3; }
+        bool fit(const cos_lib::point_buffer& buffer, const size_t* sample, Eigen::VectorXf& coefficients) const;
+        size_t countInliers(const cos_lib::point_buffer& buffer, const Eigen::VectorXf& coefficients, float threshold, size_t begin, size_t end) const;
+        void selectInliers(const cos_lib::point_buffer& buffer, const Eigen::VectorXf& coefficients, float threshold, std::vector<size_t>& slots) const;
+
+        /**
+         * @brief refit Fits the plane going through the centroid of the points, normal to the direction along which they spread the least
+         */
+        bool refit(const cos_lib::point_buffer& buffer, const std::vector<size_t>& slots, Eigen::VectorXf& coefficients) const;
+    };
+
+    /**
+     * @brief The line_model class is the model of a line, its coefficients being a point of the line followed by its unit direction
+     */
+    class line_model : public sac_model
+    {
+    public:
+        size_t getSampleSize() const { return 2; }
+        bool fit(const cos_lib::point_buffer& buffer, const size_t* sample, Eigen::VectorXf& coefficients) const;
+        size_t countInliers(const cos_lib::point_buffer& buffer, const Eigen::VectorXf& coefficients, float threshold, size_t begin, size_t end) const;
+        void selectInliers(const cos_lib::point_buffer& buffer, const Eigen::VectorXf& coefficients, float threshold, std::vector<size_t>& slots) const;
+
+        /**
+         * @brief refit Fits the line going through the centroid of the points along the direction they spread the most
+         */
+        bool refit(const cos_lib::point_buffer& buffer, const std::vector<size_t>& slots, Eigen::VectorXf& coefficients) const;
+    };
+
+    /**
+     * @brief The axis_line_model class is the model of a line whose direction is within an angle of an axis
+     * @details Samples giving a direction too far from the axis are rejected when they are fitted, before any point is scored against them
+     */
+    class axis_line_model : public line_model
+    {
+    public:
+        /**
+         * @brief axis_line_model Creates the model of the lines along an axis
+         * @param axis Direction the lines must follow, either way
+         * @param max_angle Maximum angle in radians between a line and the axis
+         * @throw std::invalid_argument if the axis is null or the angle is not between 0 and pi / 2
+         */
+        axis_line_model(const Eigen::Vector3f& axis, double max_angle);
+
+        bool fit(const cos_lib::point_buffer& buffer, const size_t* sample, Eigen::VectorXf& coefficients) const;
+
+        /**
+         * @brief refit Fits the line going through the centroid of the points along the direction they spread the most
+         * @return false if the points are degenerate or if that direction is too far from the axis
+         */
+        bool refit(const cos_lib::point_buffer& buffer, const std::vector<size_t>& slots, Eigen::VectorXf& coefficients) const;
+
+        /**
+         * @brief isAligned Tells whether the direction of a line is within the angle of the axis
+         */
+        bool isAligned(const Eigen::VectorXf& coefficients) const;
+
+    private:
+        Eigen::Vector3f axis;
+        float min_cosine;
+    };
+}
+
+#endif // MODEL_EXTRACTION_H
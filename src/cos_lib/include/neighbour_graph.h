@@ -0,0 +1,70 @@
+#include <vector>
+#include <stdint.h>
+#include "spatial_index.h"
+
+#ifndef NEIGHBOUR_GRAPH_H
+#define NEIGHBOUR_GRAPH_H
+
+namespace cos_lib
+{
+    /**
+     * @brief The neighbour_graph class stores the neighbourhood of every point of a cloud as a compressed sparse row graph
+     * @details The neighbours of the point i are the indices stored between offsets[i] and offsets[i + 1] in one single
+     * indices array, so walking through a neighbourhood only reads contiguous memory
+     */
+    class neighbour_graph
+    {
+    public:
+        /**
+         * @brief neighbour_graph Default constructor, creates an empty graph
+         */
+        neighbour_graph();
+
+        /**
+         * @brief build Fills the graph with the radius neighbours of every point of an index, the point itself excluded
+         * @details The points and their neighbours are identified by their position in the index, not by their index in the cloud
+         * @param index The spatial index of the points, already built
+         * @param neighbours_radius Search radius for the neighbours
+         */
+        void build(const cos_lib::spatial_index& index, double neighbours_radius);
+
+        /**
+         * @brief clear Removes every point and edge from the graph and frees its memory
+         */
+        void clear();
+
+        /**
+         * @brief getNbPoints Gets how many points the graph contains
+         */
+        size_t getNbPoints() const { return this->offsets.empty() ? 0 : this->offsets.size() - 1; }
+
+        /**
+         * @brief getNbEdges Gets how many neighbour relations the graph stores
+         */
+        size_t getNbEdges() const { return this->indices.size(); }
+
+        /**
+         * @brief neighboursBegin Gets a pointer on the first neighbour index of a point
+         * @param point_index Position of the point in the index used to build the graph
+         */
+        const uint32_t* neighboursBegin(size_t point_index) const { return this->indices.data() + this->offsets[point_index]; }
+
+        /**
+         * @brief neighboursEnd Gets a pointer past the last neighbour index of a point
+         * @param point_index Position of the point in the index used to build the graph
+         */
+        const uint32_t* neighboursEnd(size_t point_index) const { return this->indices.data() + this->offsets[point_index + 1]; }
+
+    private:
+        /**
+         * @brief offsets Position of the first neighbour of each point in indices, plus a last entry holding the number of edges
+         */
+        std::vector<size_t> offsets;
+        /**
+         * @brief indices Neighbours indices of all the points, stored one neighbourhood after the other
+         */
+        std::vector<uint32_t> indices;
+    };
+}
+
+#endif // NEIGHBOUR_GRAPH_H
@@ -6,23 +6,65 @@
 #define NORMAL_ESTIMATION_H
 
 #include "aux_op.h"
+#include "spatial_index.h"
+#include "voxel_hash_index.h"
+#include "normal_estimator.h"
 
 namespace cos_lib
 {
     /**
-     * @brief estimate_normals is a function that estimates the normal vectors of a point cloud
+     * @brief estimate_normals is a function that estimates the normal vectors of a point cloud and colors each point with its normal
+     * @details the normals are computed on all cores by a normal_estimator, tile by tile with a halo of one radius so the tiles leave no seam
      * @param cloud_ptr is a pointer to the point cloud to estimates the normal vectors of
-     * @param radius defines the range in which the k-d tree of cloud will look for the closest neighbours of a given point of the cloud
-     * @param max_neighbs is the maximum number of neighbours the kd-tree search function should return
+     * @param radius defines the range in which the voxel hash of cloud will look for the closest neighbours of a given point of the cloud
+     * @param max_neighbs is the maximum number of neighbours the search function should return
      */
     void estimate_normals(pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud_ptr, float radius, int max_neighbs);
 
     /**
-     * @brief estimate_normals is a function that estimates the normals of the parameter cloud using the standard pcl library
+     * @brief estimate_normals is a function that estimates the normal vectors of a point cloud using an already built spatial index and colors each point with its normal
+     * @param cloud_ptr is a pointer to the point cloud to estimates the normal vectors of
+     * @param index is a spatial index built on the whole cloud, which can then be shared with other algorithms
+     * @param radius defines the range in which the index will look for the closest neighbours of a given point of the cloud
+     * @param max_neighbs is the maximum number of neighbours the search function should return
+     * @throw std::invalid_argument if the index was not built on every point of the cloud
+     */
+    void estimate_normals(pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud_ptr, const cos_lib::spatial_index& index, float radius, int max_neighbs);
+
+    /**
+     * @brief color_with_normals colors each point of a cloud with the absolute value of its normal's coordinates
+     * @param cloud_ptr is a pointer to the point cloud to color
+     * @param normals holds one normal per point of the cloud, points with a NaN normal keep their color
+     * @throw invalid_cloud_pointer if cloud_ptr is nullptr
+     * @throw std::invalid_argument if normals does not hold one normal per point
+     */
+    void color_with_normals(pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud_ptr, const cos_lib::normal_buffer& normals);
+
+    /**
+     * @brief estimate_normals is a function that computes the normals of the parameter cloud as pcl normals, on all cores
+     * @details the normals are oriented towards the origin, as pcl does; points with less than 3 neighbours get NaN normals
      * @param cloud_ptr is a pointer to the point cloud to find the normals of
-     * @throw std::invalid_argument if cloud_ptr is nullptr
+     * @param normals_ptr is a pointer to the cloud filled with one normal and curvature per point of cloud_ptr
+     * @param radius defines the range in which the neighbours of a point are searched, 0 to only use the k nearest neighbours
+     * @param k is the maximum number of closest neighbours used for a point, 0 to use every neighbour in the radius
+     * @throw invalid_cloud_pointer if cloud_ptr or normals_ptr is nullptr
+     * @throw std::invalid_argument if radius is negative or if both radius and k are 0
+     */
+    void estimate_normals(pcl::PointCloud<pcl::PointXYZRGB>::ConstPtr cloud_ptr, pcl::PointCloud<pcl::Normal>::Ptr normals_ptr,
+                          float radius = 0.03, int k = 0);
+
+    /**
+     * @brief estimate_normals is a function that computes the normals of the parameter cloud as pcl normals using an already built spatial index
+     * @details the normals are expressed in the scaled coordinates of the index and oriented towards its origin
+     * @param index is a spatial index built on the whole cloud, for instance the one used for clustering
+     * @param normals_ptr is a pointer to the cloud filled with one normal and curvature per point of the index
+     * @param radius defines the range in which the neighbours of a point are searched, 0 to only use the k nearest neighbours
+     * @param k is the maximum number of closest neighbours used for a point, 0 to use every neighbour in the radius
+     * @throw invalid_cloud_pointer if normals_ptr is nullptr
+     * @throw std::invalid_argument if radius is negative or if both radius and k are 0
      */
-    void estimate_normals(pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud_ptr);
+    void estimate_normals(const cos_lib::spatial_index& index, pcl::PointCloud<pcl::Normal>::Ptr normals_ptr,
+                          float radius = 0.03, int k = 0);
 }
 
 #endif // NORMAL_ESTIMATION_H
@@ -0,0 +1,120 @@
+#ifndef NORMAL_ESTIMATOR_H
+#define NORMAL_ESTIMATOR_H
+
+#include "spatial_index.h"
+#include "voxel_hash_index.h"
+#include "kd_tree_index.h"
+#include "tile_scheduler.h"
+#include "invalid_cloud_pointer.h"
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+#include <vector>
+#include <stdexcept>
+
+namespace cos_lib
+{
+    /**
+     * @brief The normal_buffer struct stores the normals of a cloud column by column
+     * @details normal_x[i], normal_y[i], normal_z[i] and curvature[i] belong to the point i of the cloud.
+     * Points whose neighbourhood was too small to fit a plane hold NaN
+     */
+    struct normal_buffer
+    {
+        std::vector<float> normal_x;
+        std::vector<float> normal_y;
+        std::vector<float> normal_z;
+        /** @brief curvature is the surface variation, smallest eigenvalue divided by the sum of the eigenvalues */
+        std::vector<float> curvature;
+
+        /** @brief resize sets the number of points of the buffer */
+        void resize(size_t nb_points);
+
+        /** @brief size gets the number of points of the buffer */
+        size_t size() const { return normal_x.size(); }
+    };
+
+    /**
+     * @brief The normal_estimator class estimates the normal of each point as the smallest eigenvector of its neighbourhood's covariance
+     * @details The cloud is cut into blocks of points processed by all the threads. The covariances of a block are stored
+     * column by column so that the closed-form 3x3 eigen solver runs on the whole block with SIMD instructions
+     */
+    class normal_estimator
+    {
+    public:
+        /**
+         * @brief normal_estimator is the class constructor
+         * @param radius is the range in which the neighbours of a point are searched, 0 to use the max_neighbs closest points whatever their distance
+         * @param max_neighbs is the maximum number of closest neighbours used for a point, 0 to use every neighbour in the radius
+         * @throw std::invalid_argument if radius is negative, or if both radius and max_neighbs are 0
+         */
+        normal_estimator(float radius, size_t max_neighbs = 0);
+
+        /**
+         * @brief compute estimates the normals of every point of a cloud
+         * @details a voxel hash with cells of the search radius is built for the search, or a kd-tree for a k nearest search
+         * @param cloud_ptr is a pointer to the point cloud to estimate the normals of
+         * @param normals is filled with the normals, one per point of the cloud
+         * @throw invalid_cloud_pointer if cloud_ptr is nullptr
+         */
+        void compute(pcl::PointCloud<pcl::PointXYZRGB>::ConstPtr cloud_ptr, normal_buffer& normals) const;
+
+        /**
+         * @brief compute estimates the normals of every point of an already built spatial index
+         * @details the normals are expressed in the scaled coordinates of the index
+         * @param index is a spatial index built on the whole cloud
+         * @param normals is filled with the normals, one per point of the index
+         */
+        void compute(const cos_lib::spatial_index& index, normal_buffer& normals) const;
+
+        /**
+         * @brief compute estimates the normals of every point of a cloud tile by tile
+         * @details each tile gets its own small voxel hash, which stays in cache, and the normals of its core points are
+         * written in place in the buffer; the halo makes the result the same as without tiles
+         * @param cloud_ptr is a pointer to the point cloud to estimate the normals of
+         * @param tiles is a tile scheduler built on the cloud, with a halo at least as big as the search radius
+         * @param normals is filled with the normals, one per point of the cloud
+         * @throw invalid_cloud_pointer if cloud_ptr is nullptr
+         * @throw std::invalid_argument if the estimator has no radius or if the halo is smaller than the radius
+         */
+        void compute(pcl::PointCloud<pcl::PointXYZRGB>::ConstPtr cloud_ptr, const cos_lib::tile_scheduler& tiles, normal_buffer& normals) const;
+
+        /** @brief getRadius gets the range in which the neighbours of a point are searched, 0 meaning a k nearest search */
+        float getRadius() const { return this->radius; }
+
+        /** @brief getMaxNeighbs gets the maximum number of neighbours used for a point, 0 meaning no limit */
+        size_t getMaxNeighbs() const { return this->max_neighbs; }
+
+    private:
+        float radius;
+        size_t max_neighbs;
+
+        /**
+         * @brief block_size is the number of points whose eigen systems are solved together
+         */
+        static const size_t block_size = 16;
+
+        /**
+         * @brief computeBlock estimates the normals of block_size consecutive positions of an index
+         * @param index is the spatial index the points belong to
+         * @param first is the position of the first point of the block
+         * @param count is the number of points of the block, at most block_size
+         * @param pt_ids and pt_sq_dist are the search buffers of the calling thread
+         * @param normals is filled with the normals, one row of block_size values per coordinate, NaN for points without enough neighbours
+         * @param curvatures is filled with the surface variations
+         */
+        void computeBlock(const cos_lib::spatial_index& index, size_t first, size_t count, std::vector<uint32_t>& pt_ids,
+                          std::vector<float>& pt_sq_dist, float* normals, float* curvatures) const;
+
+        /**
+         * @brief solveBlock computes the smallest eigenvector of block_size symmetric 3x3 matrices
+         * @param covariances holds the six upper coefficients (xx, xy, xz, yy, yz, zz) of the matrices, one row of block_size values per coefficient
+         * @param normals is filled with the eigenvectors, one row of block_size values per coordinate
+         * @param curvatures is filled with the surface variations
+         */
+        static void solveBlock(const double* covariances, float* normals, float* curvatures);
+    };
+}
+
+#endif // NORMAL_ESTIMATOR_H
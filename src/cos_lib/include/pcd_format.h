@@ -0,0 +1,100 @@
+#ifndef PCD_FORMAT_H
+#define PCD_FORMAT_H
+
+#include "../include/invalid_path.h"
+#include "../include/ascii_number.h"
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include <pcl/point_types.h>
+
+namespace cos_lib
+{
+    namespace io
+    {
+        /**
+         * @brief The pcd_field struct describes one field of the points of a .pcd file, as given by its FIELDS, SIZE, TYPE and COUNT lines
+         */
+        struct pcd_field
+        {
+            std::string name;
+            char type;          // 'F' for floating point, 'U' for unsigned and 'I' for signed integers
+            size_t size;        // size in bytes of one element
+            size_t count;       // number of elements of the field
+            size_t offset;      // position of the field in a binary point
+            size_t column;      // position of the first element of the field in an ascii line
+        };
+
+        /**
+         * @brief The pcd_header struct holds the header of a .pcd file
+         */
+        struct pcd_header
+        {
+            enum data_type { ascii, binary, binary_compressed };
+
+            std::vector<cos_lib::io::pcd_field> fields;
+            size_t nb_points;
+            size_t point_step;      // size in bytes of a binary point
+            size_t nb_columns;      // number of columns of an ascii line
+            data_type data;
+            size_t data_offset;     // position of the first byte following the DATA line
+
+            int x_field;            // index in fields of x, y, z and of the packed colour, rgb or rgba, -1 if missing
+            int y_field;
+            int z_field;
+            int colour_field;
+        };
+
+        /**
+         * @brief parse_pcd_header reads the header of a .pcd file, from its beginning to its DATA line
+         * @param begin is a pointer to the first character of the file
+         * @param end is a pointer past the last character available, the header being searched for only up to it
+         * @throw invalid_path if the header is incomplete, inconsistent, or if the points have no x, y or z field
+         * @return the header
+         */
+        cos_lib::io::pcd_header parse_pcd_header(const char* begin, const char* end);
+
+        /**
+         * @brief decode_pcd_point reads a point stored in binary, the fields of the point following each other
+         * @details the points without colour are white
+         * @param header is the header of the file
+         * @param record is a pointer to the first byte of the point
+         * @param point is set to the point read
+         */
+        void decode_pcd_point(const cos_lib::io::pcd_header& header, const char* record, pcl::PointXYZRGB& point);
+
+        /**
+         * @brief decode_pcd_compressed_point reads a point of the decompressed data of a binary_compressed file
+         * @details the decompressed data holds each field of all the points before the next field
+         * @param header is the header of the file
+         * @param data is a pointer to the first byte of the decompressed data
+         * @param index is the index of the point in the file
+         * @param point is set to the point read
+         */
+        void decode_pcd_compressed_point(const cos_lib::io::pcd_header& header, const char* data, size_t index, pcl::PointXYZRGB& point);
+
+        /**
+         * @brief lzf_decompress decompresses the LZF data of a binary_compressed file
+         * @param in is a pointer to the compressed data
+         * @param in_size is the size in bytes of the compressed data
+         * @param out is a pointer to the buffer receiving the decompressed data
+         * @param out_size is the size in bytes of the buffer
+         * @return the number of bytes decompressed, 0 if the data is corrupted or does not fit in the buffer
+         */
+        size_t lzf_decompress(const char* in, size_t in_size, char* out, size_t out_size);
+
+        /**
+         * @brief parse_pcd_line reads a point stored as an ascii line
+         * @param header is the header of the file
+         * @param begin is a pointer to the first character of the line
+         * @param end is a pointer past the last character of the line, '\n' excluded
+         * @param point is set to the point read
+         * @return false if the line does not hold the columns given by the header
+         */
+        bool parse_pcd_line(const cos_lib::io::pcd_header& header, const char* begin, const char* end, pcl::PointXYZRGB& point);
+    }
+}
+
+#endif // PCD_FORMAT_H
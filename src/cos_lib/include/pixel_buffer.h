@@ -0,0 +1,135 @@
+#ifndef PIXEL_BUFFER_H
+#define PIXEL_BUFFER_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <cstring>
+#include <memory>
+#include <utility>
+
+namespace cos_lib
+{
+    /**
+     * @brief The pixel_buffer class holds the pixels of an image plane in one contiguous block of memory
+     * @details each row starts on a multiple of alignment bytes, rows being padded up to stride() pixels,
+     * so that a plane is allocated once and its rows can be processed with vector instructions.
+     * A buffer can also share memory allocated elsewhere, a cv::Mat for instance, which is kept alive by an owner.
+     * Copying a buffer copies its pixels into a new allocation.
+     */
+    template <typename T>
+    class pixel_buffer
+    {
+    public:
+        /** @brief alignment is the alignment in bytes of the first pixel of each row */
+        static const size_t alignment = 64;
+
+        /**
+         * @brief pixel_buffer is the class constructor, the pixels are set to 0
+         * @param width is the width of the plane in pixels
+         * @param height is the height of the plane in pixels
+         */
+        pixel_buffer(size_t width, size_t height)
+        {
+            allocate(width, height);
+        }
+
+        /**
+         * @brief pixel_buffer is the constructor of a buffer sharing memory it does not allocate
+         * @details the rows of the buffer keep the alignment of the memory they come from
+         * @param width is the width of the plane in pixels
+         * @param height is the height of the plane in pixels
+         * @param stride is the distance in pixels between the beginnings of two consecutive rows
+         * @param data is a pointer to the first pixel of the plane
+         * @param owner keeps the memory alive as long as the buffer uses it
+         */
+        pixel_buffer(size_t width, size_t height, size_t stride, T* data, std::shared_ptr<void> owner)
+            : _width(width), _height(height), _stride(stride), _owner(std::move(owner)), _data(data)
+        {
+        }
+
+        pixel_buffer(const pixel_buffer& other)
+        {
+            allocate(other._width, other._height);
+
+            for (size_t y = 0; y < _height; y++)
+                std::memcpy(row(y), other.row(y), _width * sizeof(T));
+        }
+
+        pixel_buffer(pixel_buffer&& other)
+            : _width(other._width), _height(other._height), _stride(other._stride),
+              _owner(std::move(other._owner)), _data(other._data)
+        {
+            other._width = other._height = other._stride = 0;
+            other._data = nullptr;
+        }
+
+        pixel_buffer& operator=(pixel_buffer other)
+        {
+            std::swap(_width, other._width);
+            std::swap(_height, other._height);
+            std::swap(_stride, other._stride);
+            std::swap(_owner, other._owner);
+            std::swap(_data, other._data);
+
+            return *this;
+        }
+
+        /** @brief width gets width */
+        size_t width() const { return _width; }
+
+        /** @brief height gets height */
+        size_t height() const { return _height; }
+
+        /** @brief stride gets the distance in pixels between the beginnings of two consecutive rows */
+        size_t stride() const { return _stride; }
+
+        /** @brief step gets the distance in bytes between the beginnings of two consecutive rows */
+        size_t step() const { return _stride * sizeof(T); }
+
+        /** @brief data gets a pointer to the first pixel of the plane */
+        T* data() { return _data; }
+        const T* data() const { return _data; }
+
+        /** @brief row gets a pointer to the first pixel of row y */
+        T* row(size_t y) { return _data + y * _stride; }
+        const T* row(size_t y) const { return _data + y * _stride; }
+
+        /** @brief fill sets every pixel of the plane to value, the padding of shared memory being left untouched */
+        void fill(T value)
+        {
+            for (size_t y = 0; y < _height; y++)
+            {
+                T* pixels = row(y);
+
+                for (size_t x = 0; x < _width; x++)
+                    pixels[x] = value;
+            }
+        }
+
+    private:
+        size_t _width;
+        size_t _height;
+        size_t _stride;
+        std::shared_ptr<void> _owner;
+        T* _data;
+
+        /**
+         * @brief allocate allocates the plane filled with 0, as the vectors the images used to hold were,
+         * moving the beginning of the block up to the next multiple of alignment
+         */
+        void allocate(size_t width, size_t height)
+        {
+            size_t row_size = (width * sizeof(T) + alignment - 1) / alignment * alignment;
+            unsigned char* block = new unsigned char[row_size * height + alignment]();
+            uintptr_t address = (uintptr_t)block;
+
+            _width = width;
+            _height = height;
+            _stride = row_size / sizeof(T);
+            _owner = std::shared_ptr<unsigned char>(block, std::default_delete<unsigned char[]>());
+            _data = (T*)((address + alignment - 1) / alignment * alignment);
+        }
+    };
+}
+
+#endif // PIXEL_BUFFER_H
@@ -0,0 +1,79 @@
+#ifndef PLY_FORMAT_H
+#define PLY_FORMAT_H
+
+#include "../include/invalid_path.h"
+#include "../include/ascii_number.h"
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include <pcl/point_types.h>
+
+namespace cos_lib
+{
+    namespace io
+    {
+        /**
+         * @brief The ply_property struct describes one property of the vertices of a .ply file
+         */
+        struct ply_property
+        {
+            std::string name;
+            char type;          // 'F' for floating point, 'U' for unsigned and 'I' for signed integers
+            size_t size;        // size in bytes
+            size_t offset;      // position of the property in a binary vertex
+        };
+
+        /**
+         * @brief The ply_header struct holds the header of a .ply file, the vertices being the points of the cloud
+         */
+        struct ply_header
+        {
+            enum data_type { ascii, binary_little_endian, binary_big_endian };
+
+            data_type data;
+            std::vector<cos_lib::io::ply_property> properties;
+            size_t nb_points;
+            size_t point_step;      // size in bytes of a binary vertex
+            size_t data_offset;     // position of the first byte following the end_header line
+            size_t skipped_size;    // for ascii, lines, and for binary, bytes of the elements stored before the vertices
+
+            int x_property;         // index in properties of x, y, z, red, green and blue, -1 if missing
+            int y_property;
+            int z_property;
+            int colour_properties[3];
+        };
+
+        /**
+         * @brief parse_ply_header reads the header of a .ply file, from its beginning to its end_header line
+         * @param begin is a pointer to the first character of the file
+         * @param end is a pointer past the last character of the file
+         * @throw invalid_path if the header is incomplete or inconsistent, if the vertices have no x, y or z property,
+         * or if the vertices, or the elements stored before them in a binary file, have list properties
+         * @return the header
+         */
+        cos_lib::io::ply_header parse_ply_header(const char* begin, const char* end);
+
+        /**
+         * @brief decode_ply_point reads a vertex stored in binary
+         * @details the vertices without colour are white, floating point colours are mapped from [0, 1] to [0, 255]
+         * @param header is the header of the file
+         * @param record is a pointer to the first byte of the vertex
+         * @param point is set to the point read
+         */
+        void decode_ply_point(const cos_lib::io::ply_header& header, const char* record, pcl::PointXYZRGB& point);
+
+        /**
+         * @brief parse_ply_line reads a vertex stored as an ascii line
+         * @param header is the header of the file
+         * @param begin is a pointer to the first character of the line
+         * @param end is a pointer past the last character of the line, '\n' excluded
+         * @param point is set to the point read
+         * @return false if the line does not hold one number per property
+         */
+        bool parse_ply_line(const cos_lib::io::ply_header& header, const char* begin, const char* end, pcl::PointXYZRGB& point);
+    }
+}
+
+#endif // PLY_FORMAT_H
@@ -0,0 +1,133 @@
+#include <vector>
+#include <stdexcept>
+#include <stdint.h>
+#include <Eigen/Core>
+#include "model_extraction.h"
+
+#ifndef RANSAC_ENGINE_H
+#define RANSAC_ENGINE_H
+
+namespace cos_lib
+{
+    /**
+     * @brief The ransac_statistics struct describes the work done by the last run of a ransac_engine
+     */
+    struct ransac_statistics
+    {
+        /**
+         * @brief nb_iterations Number of hypotheses drawn
+         */
+        size_t nb_iterations;
+        /**
+         * @brief nb_rejected_samples Number of minimal samples the model could not be fitted on
+         */
+        size_t nb_rejected_samples;
+        /**
+         * @brief nb_evaluations Number of distances computed between a point and a hypothesis
+         */
+        size_t nb_evaluations;
+        /**
+         * @brief seconds Duration of the run
+         */
+        double seconds;
+    };
+
+    /**
+     * @brief The ransac_engine class estimates the model explaining the most active points of a point_buffer
+     * @details The hypotheses are drawn by batches and scored with preemption: the batch is scored on consecutive blocks of slots, which are
+     * random samples of the points since the buffer is shuffled, and only the best half of the batch goes on after each block. The hypothesis
+     * left is then scored on every point. Each hypothesis of a batch is handled by a different thread and draws its sample from its own
+     * generator, seeded by the seed of the engine, the number of the run and its rank, so the results only depend on the seed.
+     * The number of hypotheses drawn is adapted to the best inlier ratio found so far
+     */
+    class ransac_engine
+    {
+    public:
+        /**
+         * @brief ransac_engine Creates an engine
+         * @param model Model estimated, which must outlive the engine
+         * @param distance_threshold Distance under which a point is an inlier of a model
+         * @param seed Seed of the generators drawing the samples
+         * @throw std::invalid_argument if the threshold is negative
+         */
+        ransac_engine(const cos_lib::sac_model& model, double distance_threshold, uint64_t seed = 0);
+
+        /**
+         * @brief setProbability Sets the probability of drawing at least one sample made only of inliers of the best model, 0.99 by default
+         * @throw std::invalid_argument if the probability is not strictly between 0 and 1
+         */
+        void setProbability(double probability);
+
+        /**
+         * @brief setMaxIterations Sets the maximum number of hypotheses drawn in a run, 10000 by default
+         */
+        void setMaxIterations(size_t max_iterations) { this->max_iterations = max_iterations; }
+
+        /**
+         * @brief setPreemption Sets how hypotheses are scored, by default by batches of 64 hypotheses on blocks of 1024 slots
+         * @param batch_size Number of hypotheses drawn and scored together
+         * @param block_size Number of slots the hypotheses of a batch are scored on before the worst half is dropped,
+         * 0 to score every hypothesis on every point
+         * @throw std::invalid_argument if batch_size is 0
+         */
+        void setPreemption(size_t batch_size, size_t block_size);
+
+        /**
+         * @brief setRefinement Sets whether the best model is fitted again on its inliers with least squares, which is not done by default
+         */
+        void setRefinement(bool refine) { this->refine = refine; }
+
+        /**
+         * @brief computeModel Estimates the model explaining the most active points of a buffer
+         * @return false if no model could be fitted on the buffer
+         */
+        bool computeModel(const cos_lib::point_buffer& buffer);
+
+        /**
+         * @brief extractModel Estimates the model explaining the most active points of a buffer then deactivates its inliers
+         * @return Indices in the cloud of the inliers of the model, empty if no model could be fitted
+         */
+        std::vector<int> extractModel(cos_lib::point_buffer& buffer);
+
+        /**
+         * @brief getInliers Gets the indices in the cloud of the inliers of the last model estimated, sorted by increasing index
+         */
+        const std::vector<int>& getInliers() const { return this->inliers; }
+
+        /**
+         * @brief getModelCoefficients Gets the coefficients of the last model estimated
+         */
+        const Eigen::VectorXf& getModelCoefficients() const { return this->coefficients; }
+
+        /**
+         * @brief getStatistics Gets the work done by the last run
+         */
+        const cos_lib::ransac_statistics& getStatistics() const { return this->statistics; }
+
+    private:
+        const cos_lib::sac_model& model;
+        float distance_threshold;
+        double probability;
+        size_t max_iterations;
+        size_t batch_size;
+        size_t block_size;
+        bool refine;
+        uint64_t seed;
+        /**
+         * @brief run Number of runs so far, which changes the samples drawn by the next one
+         */
+        uint64_t run;
+
+        std::vector<size_t> inlier_slots;
+        std::vector<int> inliers;
+        Eigen::VectorXf coefficients;
+        cos_lib::ransac_statistics statistics;
+
+        /**
+         * @brief countInliers Counts the inliers of a hypothesis among length slots starting at a slot, wrapping around the end of the buffer
+         */
+        size_t countInliers(const cos_lib::point_buffer& buffer, const Eigen::VectorXf& hypothesis, size_t first, size_t length) const;
+    };
+}
+
+#endif // RANSAC_ENGINE_H
@@ -0,0 +1,70 @@
+#include <vector>
+#include <stdint.h>
+#include "model_extraction.h"
+
+#ifndef SAMPLING_OCTREE_H
+#define SAMPLING_OCTREE_H
+
+namespace cos_lib
+{
+    /**
+     * @brief The sampling_octree class splits the active points of a point_buffer into an octree, so that samples can be drawn from one cell
+     * @details The points are sorted by the Morton code of their leaf, which makes every cell of every level one contiguous range of entries:
+     * the cell of a level containing an entry is found by two binary searches on the codes, nothing else is stored
+     */
+    class sampling_octree
+    {
+    public:
+        /**
+         * @brief max_depth Deepest level of the octree, a Morton code holding max_depth bits per axis
+         */
+        static const int max_depth = 10;
+
+        /**
+         * @brief sampling_octree Creates an empty octree
+         */
+        sampling_octree();
+
+        /**
+         * @brief build Builds the octree on the active points of a buffer, the entries being valid until the buffer is compacted
+         * @param buffer Points the octree is built on
+         * @param min_cell_size Size under which cells are not split anymore, which sets the depth of the octree
+         */
+        void build(const cos_lib::point_buffer& buffer, double min_cell_size);
+
+        /**
+         * @brief getDepth Gets the deepest level of the octree, level 0 being the cell holding every point
+         */
+        int getDepth() const { return this->depth; }
+
+        /**
+         * @brief getNbEntries Gets the number of points the octree was built on
+         */
+        size_t getNbEntries() const { return this->slots.size(); }
+
+        /**
+         * @brief getSlot Gets the slot in the buffer of an entry
+         */
+        size_t getSlot(size_t entry) const { return this->slots[entry]; }
+
+        /**
+         * @brief getCell Gets the range of entries of the cell of a level containing an entry
+         * @param begin Set to the first entry of the cell
+         * @param end Set to the entry past the last entry of the cell
+         */
+        void getCell(size_t entry, int level, size_t& begin, size_t& end) const;
+
+    private:
+        int depth;
+        /**
+         * @brief codes Morton code of the leaf of each entry, sorted
+         */
+        std::vector<uint32_t> codes;
+        /**
+         * @brief slots Slot in the buffer of each entry
+         */
+        std::vector<uint32_t> slots;
+    };
+}
+
+#endif // SAMPLING_OCTREE_H
@@ -0,0 +1,118 @@
+#include <vector>
+#include <stdexcept>
+#include <stdint.h>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+#ifndef SPATIAL_INDEX_H
+#define SPATIAL_INDEX_H
+
+namespace cos_lib
+{
+    /**
+     * @brief The spatial_index class is the common interface of the structures answering neighbour queries on a cloud
+     * @details The index is built once on a set of points and can then be queried by several threads at the same time.
+     * Neighbours are identified by their position in the set of points the index was built on, getCloudIndex gives
+     * their index in the cloud back.
+     * The index can measure distances with a different scale on each axis: its coordinates are the cloud coordinates
+     * multiplied by the scale as they are gathered, so an anisotropic metric costs nothing and the cloud is never modified.
+     * Queries, getPoint and the distances returned are all expressed in these scaled coordinates
+     */
+    class spatial_index
+    {
+    public:
+        /**
+         * @brief spatial_index Creates an empty index measuring distances with the same scale on every axis
+         */
+        spatial_index();
+
+        virtual ~spatial_index();
+
+        /**
+         * @brief setScale Sets the scale of each axis used for the next builds
+         * @throw std::invalid_argument if a scale is not strictly positive
+         */
+        void setScale(float x_scale, float y_scale, float z_scale);
+
+        /**
+         * @brief scalePoint Gives the coordinates of a cloud point in the space of the index, which is what queries expect
+         */
+        pcl::PointXYZ scalePoint(const pcl::PointXYZRGB& point) const { return pcl::PointXYZ(point.x * this->scale[0], point.y * this->scale[1], point.z * this->scale[2]); }
+
+        /**
+         * @brief build Builds the index on every point of a cloud, positions then being the indices in the cloud
+         * @param cloud The cloud the index is built on
+         * @throw cos_lib::except::invalid_cloud_pointer if cloud is nullptr
+         */
+        void build(pcl::PointCloud<pcl::PointXYZRGB>::ConstPtr cloud);
+
+        /**
+         * @brief build Builds the index on a set of points of a cloud
+         * @param cloud The cloud the points belong to
+         * @param indices_begin Pointer on the index of the first point
+         * @param indices_end Pointer past the index of the last point
+         * @throw cos_lib::except::invalid_cloud_pointer if cloud is nullptr
+         */
+        void build(pcl::PointCloud<pcl::PointXYZRGB>::ConstPtr cloud, const uint32_t* indices_begin, const uint32_t* indices_end);
+
+        /**
+         * @brief radiusSearch Finds every point of the index within a radius of a query point, the query itself included if it is indexed
+         * @param query The point we want the neighbours of
+         * @param radius Search radius
+         * @param positions Filled with the positions of the neighbours
+         * @param sq_distances Filled with the squared distances from the query to the neighbours
+         * @param max_neighbours If not 0, only the max_neighbours closest neighbours are kept and they are sorted by increasing distance,
+         * otherwise the neighbours come in no particular order
+         * @return The number of neighbours found
+         */
+        virtual size_t radiusSearch(const pcl::PointXYZ& query, double radius, std::vector<uint32_t>& positions,
+                                    std::vector<float>& sq_distances, size_t max_neighbours) const = 0;
+
+        /**
+         * @brief nearestKSearch Finds the k points of the index closest to a query point, sorted by increasing distance
+         * @param query The point we want the neighbours of
+         * @param k Number of neighbours wanted
+         * @param positions Filled with the positions of the neighbours
+         * @param sq_distances Filled with the squared distances from the query to the neighbours
+         * @return The number of neighbours found, lower than k only if the index holds less than k points
+         */
+        virtual size_t nearestKSearch(const pcl::PointXYZ& query, size_t k, std::vector<uint32_t>& positions,
+                                      std::vector<float>& sq_distances) const = 0;
+
+        /**
+         * @brief getNbPoints Gets how many points the index was built on
+         */
+        size_t getNbPoints() const { return this->coordinates ? this->coordinates->size() : 0; }
+
+        /**
+         * @brief getPoint Gets the coordinates of the point at a position of the index
+         */
+        const pcl::PointXYZ& getPoint(size_t position) const { return this->coordinates->points[position]; }
+
+        /**
+         * @brief getCloudIndex Gets the index in the cloud of the point at a position of the index
+         */
+        uint32_t getCloudIndex(size_t position) const { return this->cloud_indices.empty() ? (uint32_t)position : this->cloud_indices[position]; }
+
+    protected:
+        /**
+         * @brief buildStructure Builds the search structure once the coordinates have been gathered
+         */
+        virtual void buildStructure() = 0;
+
+        /**
+         * @brief scale Scale of each axis
+         */
+        float scale[3];
+        /**
+         * @brief coordinates Scaled coordinates of the indexed points, in the order of their positions
+         */
+        pcl::PointCloud<pcl::PointXYZ>::Ptr coordinates;
+        /**
+         * @brief cloud_indices Index in the cloud of each position, empty when the whole cloud is indexed
+         */
+        std::vector<uint32_t> cloud_indices;
+    };
+}
+
+#endif // SPATIAL_INDEX_H
@@ -0,0 +1,95 @@
+#include <vector>
+#include <functional>
+#include <stdexcept>
+#include <stdint.h>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+#ifndef TILE_SCHEDULER_H
+#define TILE_SCHEDULER_H
+
+namespace cos_lib
+{
+    /**
+     * @brief The cloud_tile struct holds the points of one tile of a cloud
+     * @details indices first holds the core points, which are the points lying inside the tile, then the halo points,
+     * which lie outside the tile but close enough to it to be the neighbours of a core point
+     */
+    struct cloud_tile
+    {
+        /**
+         * @brief indices Indices in the cloud of the core points followed by the halo points, each part in the cloud order
+         */
+        std::vector<uint32_t> indices;
+        /**
+         * @brief nb_core_points Number of core points at the beginning of indices
+         */
+        size_t nb_core_points;
+    };
+
+    /**
+     * @brief The tile_scheduler class cuts a cloud into cubic tiles with an overlapping halo and runs a task on each tile in parallel
+     * @details Every point is the core point of exactly one tile, so a task that only writes the results of its core points can
+     * write them straight into the cloud or into a buffer indexed like the cloud. With a halo at least as big as the search
+     * radius, a core point has the same neighbours in its tile as in the whole cloud, so the tiles leave no seam
+     */
+    class tile_scheduler
+    {
+    public:
+        /**
+         * @brief tile_scheduler Creates a scheduler with no tile
+         * @param tile_size Edge length of the tiles
+         * @param halo Distance around a tile within which points are added to its halo
+         * @throw std::invalid_argument if tile_size is not strictly positive, or if halo is negative or bigger than tile_size
+         */
+        tile_scheduler(double tile_size, double halo);
+
+        /**
+         * @brief build Cuts a cloud into tiles, the empty tiles being dropped
+         * @param cloud The cloud to cut
+         * @throw cos_lib::except::invalid_cloud_pointer if cloud is nullptr
+         * @throw std::invalid_argument if the cloud spans more than 2^21 tiles along one axis
+         */
+        void build(pcl::PointCloud<pcl::PointXYZRGB>::ConstPtr cloud);
+
+        /**
+         * @brief clear Removes every tile and frees the memory
+         */
+        void clear();
+
+        /**
+         * @brief run Runs a task on every tile, the tiles being shared between all the threads
+         * @details The biggest tiles are dispatched first and each thread takes the next tile as soon as it is done,
+         * so a few dense tiles do not leave the other threads idle at the end. The task may be called by several threads at once
+         * @param task The task, which receives the tile to process
+         */
+        void run(const std::function<void(const cos_lib::cloud_tile&)>& task) const;
+
+        /**
+         * @brief getNbTiles Gets how many non empty tiles the cloud was cut into
+         */
+        size_t getNbTiles() const { return this->tiles.size(); }
+
+        /**
+         * @brief getTile Gets a tile, tiles being sorted by decreasing number of core points
+         */
+        const cos_lib::cloud_tile& getTile(size_t tile) const { return this->tiles[tile]; }
+
+        /**
+         * @brief getTileSize Gets the edge length of the tiles
+         */
+        double getTileSize() const { return this->tile_size; }
+
+        /**
+         * @brief getHalo Gets the distance around a tile within which points are added to its halo
+         */
+        double getHalo() const { return this->halo; }
+
+    private:
+        double tile_size;
+        double halo;
+        std::vector<cos_lib::cloud_tile> tiles;
+    };
+}
+
+#endif // TILE_SCHEDULER_H
@@ -0,0 +1,118 @@
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <cmath>
+#include <stdint.h>
+#include "spatial_index.h"
+
+#ifndef VOXEL_HASH_INDEX_H
+#define VOXEL_HASH_INDEX_H
+
+namespace cos_lib
+{
+    /**
+     * @brief The voxel_hash_index class answers neighbour queries with a uniform grid of cubic cells stored in a hash table
+     * @details The points are sorted by cell so each cell is one contiguous range of coordinates. With a cell size equal to
+     * the search radius, a radius search only scans the 27 cells around the query and building the index is a single sort.
+     * Radii bigger than the cell size still work, they just scan more cells
+     */
+    class voxel_hash_index : public spatial_index
+    {
+    public:
+        /**
+         * @brief voxel_hash_index Creates an empty index
+         * @param cell_size Edge length of the cells, ideally the radius the index will be queried with
+         * @throw std::invalid_argument if cell_size is not strictly positive
+         */
+        voxel_hash_index(double cell_size);
+
+        size_t radiusSearch(const pcl::PointXYZ& query, double radius, std::vector<uint32_t>& positions,
+                            std::vector<float>& sq_distances, size_t max_neighbours) const;
+
+        size_t nearestKSearch(const pcl::PointXYZ& query, size_t k, std::vector<uint32_t>& positions,
+                              std::vector<float>& sq_distances) const;
+
+        /**
+         * @brief getCellSize Gets the edge length of the cells
+         */
+        double getCellSize() const { return this->cell_size; }
+
+        /**
+         * @brief getNbCells Gets how many cells hold at least one point
+         */
+        size_t getNbCells() const { return this->cell_keys.size(); }
+
+    protected:
+        /**
+         * @throw std::invalid_argument if the cloud spans more than 2^21 cells along one axis
+         */
+        void buildStructure();
+
+    private:
+        double cell_size;
+        /**
+         * @brief origin Lowest corner of the grid, which is the lowest corner of the bounding box of the points
+         */
+        double origin[3];
+        /**
+         * @brief nb_cells Number of cells of the grid along each axis
+         */
+        int64_t nb_cells[3];
+
+        /**
+         * @brief cell_keys Key of each non empty cell, sorted
+         */
+        std::vector<uint64_t> cell_keys;
+        /**
+         * @brief cell_offsets Position of the first point of each cell in cell_points, plus a last entry holding the number of points
+         */
+        std::vector<uint32_t> cell_offsets;
+        /**
+         * @brief cell_points Coordinates of the points sorted by cell, three floats per point
+         */
+        std::vector<float> cell_points;
+        /**
+         * @brief cell_positions Position of each point of cell_points in the index
+         */
+        std::vector<uint32_t> cell_positions;
+        /**
+         * @brief hash_table Open addressing table giving the cell number of a key, empty slots holding UINT32_MAX
+         */
+        std::vector<uint32_t> hash_table;
+
+        /**
+         * @brief getCellCoordinate Gets the cell coordinate of a value along one axis, which can be outside of the grid
+         */
+        int64_t getCellCoordinate(double value, int axis) const { return (int64_t)std::floor((value - this->origin[axis]) / this->cell_size); }
+
+        /**
+         * @brief packKey Packs the coordinates of a cell of the grid on 63 bits
+         */
+        static uint64_t packKey(int64_t x, int64_t y, int64_t z) { return (uint64_t)x | ((uint64_t)y << 21) | ((uint64_t)z << 42); }
+
+        /**
+         * @brief hashKey Spreads a key over the hash table
+         */
+        size_t hashKey(uint64_t key) const { return (size_t)((key * 0x9E3779B97F4A7C15ull) >> 32) & (this->hash_table.size() - 1); }
+
+        /**
+         * @brief findCell Gets the number of the cell of a key
+         * @return The cell number, UINT32_MAX if the cell holds no point
+         */
+        uint32_t findCell(uint64_t key) const;
+
+        /**
+         * @brief scanCell Adds the points of a cell of the grid which are within a squared distance of the query
+         */
+        void scanCell(int64_t x, int64_t y, int64_t z, const pcl::PointXYZ& query, float max_sq_distance,
+                      std::vector<uint32_t>& positions, std::vector<float>& sq_distances) const;
+
+        /**
+         * @brief scanCellNearest Offers the points of a cell of the grid to a max-heap of the k closest points
+         */
+        void scanCellNearest(int64_t x, int64_t y, int64_t z, const pcl::PointXYZ& query, size_t k,
+                             std::vector<std::pair<float, uint32_t>>& heap) const;
+    };
+}
+
+#endif // VOXEL_HASH_INDEX_H
@@ -1,11 +1,47 @@
 #include "../include/ModelDetection.h"
+#include "../include/ransac_engine.h"
 
-#include <pcl/sample_consensus/ransac.h>
-#include <pcl/sample_consensus/sac_model_line.h>
-#include <pcl/sample_consensus/sac_model_plane.h>
 #include <pcl/filters/extract_indices.h>
 #include <pcl/cloud_iterator.h>
 
+namespace
+{
+    /**
+     * @brief colorModels Extracts the models of a cloud one after the other and keeps the colored models explaining enough points
+     * @details the points are only copied once, when their model is colored, removing a model just clears their mask in the buffer
+     */
+    void colorModels(pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud, const cos_lib::sac_model& model, double distanceThreshold, int pointsPerModel){
+        cos_lib::point_buffer buffer(*cloud, rand());
+        cos_lib::ransac_engine ransac(model, distanceThreshold, rand());
+        pcl::PointCloud<pcl::PointXYZRGB>::Ptr colored (new pcl::PointCloud<pcl::PointXYZRGB>);
+
+        while(buffer.getNbActive()>(uint)pointsPerModel){
+            std::vector<int> inliers = ransac.extractModel(buffer);
+
+            if(inliers.empty())
+                break;
+
+            if((int) inliers.size() >= pointsPerModel){
+                std::vector<int> color = cos_lib::colorRandomizer();
+                size_t offset = colored->points.size();
+
+                colored->points.resize(offset + inliers.size());
+                for(uint i=0; i<inliers.size(); i++){
+                    pcl::PointXYZRGB& point = colored->points[offset + i];
+                    point = cloud->points[inliers[i]];
+                    point.r = color[0];
+                    point.g = color[1];
+                    point.b = color[2];
+                }
+            }
+        }
+
+        colored->width = colored->points.size();
+        colored->height = 1;
+        cloud->clear();
+        *cloud = *colored;
+    }
+}
 
 void cos_lib::coloringProcess(pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud, std::vector<int> inliers, std::vector<int> color){
 
@@ -28,14 +64,12 @@ void cos_lib::coloringPointCloud(pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud, s
 
 std::vector<int> cos_lib::getBestPlan(pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud,double distanceThreshold){
 
-    pcl::SampleConsensusModelPlane<pcl::PointXYZRGB>::Ptr model (new pcl::SampleConsensusModelPlane<pcl::PointXYZRGB> (cloud));
-    pcl::RandomSampleConsensus<pcl::PointXYZRGB> ransac (model);
-    std::vector<int> inliers;
-    ransac.setDistanceThreshold(distanceThreshold);
-    ransac.computeModel();
-    ransac.getInliers(inliers);
+    cos_lib::point_buffer buffer(*cloud, rand());
+    cos_lib::plane_model model;
+    cos_lib::ransac_engine ransac(model, distanceThreshold, rand());
+    ransac.computeModel(buffer);
 
-    return inliers;
+    return ransac.getInliers();
 }
 
 pcl::PointCloud<pcl::PointXYZRGB>::Ptr cos_lib::getSubCloudFromIndices(pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud, std::vector<int> indices){
@@ -48,69 +82,22 @@ pcl::PointCloud<pcl::PointXYZRGB>::Ptr cos_lib::getSubCloudFromIndices(pcl::Poin
 }
 
 void cos_lib::colorPlans(pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud,double distanceThreshold,int pointsPerPlane){
-    pcl::PointCloud<pcl::PointXYZRGB>::Ptr temp (new pcl::PointCloud<pcl::PointXYZRGB>);
-    pcl::PointCloud<pcl::PointXYZRGB>::Ptr colored (new pcl::PointCloud<pcl::PointXYZRGB>);
-    *temp = *cloud;
-    colored->clear();
-
-    int i = 0;
-    while(temp->size()>(uint)pointsPerPlane){
-        std::vector<int> inliers = getBestPlan(temp, distanceThreshold);
-        pcl::PointCloud<pcl::PointXYZRGB>::Ptr tempPlane (new pcl::PointCloud<pcl::PointXYZRGB>);
-        tempPlane = getSubCloudFromIndices(temp, inliers);
-        temp = removeSetOfIndices(temp, inliers);
-
-        if((int) inliers.size() >= pointsPerPlane){
-            std::vector<int> color = colorRandomizer();
-            coloringPointCloud(tempPlane, color);
-            *colored += *tempPlane;
-        }
-
-        i++;
-    }
-
-    cloud->clear();
-    *cloud = *colored;
+    colorModels(cloud, cos_lib::plane_model(), distanceThreshold, pointsPerPlane);
 }
 
 
 std::vector<int> cos_lib::getBestLine(pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud,double distanceThreshold){
 
-    pcl::SampleConsensusModelLine<pcl::PointXYZRGB>::Ptr model (new pcl::SampleConsensusModelLine<pcl::PointXYZRGB> (cloud));
-    pcl::RandomSampleConsensus<pcl::PointXYZRGB> ransac (model);
-    std::vector<int> inliers;
-    ransac.setDistanceThreshold(distanceThreshold);
-    ransac.computeModel();
-    ransac.getInliers(inliers);
+    cos_lib::point_buffer buffer(*cloud, rand());
+    cos_lib::line_model model;
+    cos_lib::ransac_engine ransac(model, distanceThreshold, rand());
+    ransac.computeModel(buffer);
 
-    return inliers;
+    return ransac.getInliers();
 }
 
 void cos_lib::colorLines(pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud,double distanceThreshold,int pointsPerLine){
-
-    pcl::PointCloud<pcl::PointXYZRGB>::Ptr temp (new pcl::PointCloud<pcl::PointXYZRGB>);
-    pcl::PointCloud<pcl::PointXYZRGB>::Ptr colored (new pcl::PointCloud<pcl::PointXYZRGB>);
-    *temp = *cloud;
-    colored->clear();
-
-    int i = 0;
-    while(temp->size()>(uint)pointsPerLine){
-        std::vector<int> inliers = getBestLine(temp, distanceThreshold);
-        pcl::PointCloud<pcl::PointXYZRGB>::Ptr tempPlane (new pcl::PointCloud<pcl::PointXYZRGB>);
-        tempPlane = getSubCloudFromIndices(temp, inliers);
-        temp = removeSetOfIndices(temp, inliers);
-
-        if((int) inliers.size() >= pointsPerLine){
-            std::vector<int> color = colorRandomizer();
-            coloringPointCloud(tempPlane, color);
-            *colored += *tempPlane;
-        }
-
-        i++;
-    }
-
-    cloud->clear();
-    *cloud = *colored;
+    colorModels(cloud, cos_lib::line_model(), distanceThreshold, pointsPerLine);
 }
 
 pcl::PointCloud<pcl::PointXYZRGB>::Ptr cos_lib::removeSetOfIndices(pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud, std::vector<int> indices){
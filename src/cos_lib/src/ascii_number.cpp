@@ -0,0 +1,296 @@
+#include "../include/ascii_number.h"
+
+#include <limits>
+#include <cmath>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+    // powers of ten exactly representable by a double
+    const double pow10_table[23] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+    bool is_digit(char c) { return c >= '0' && c <= '9'; }
+
+    /**
+     * @brief tie_margin is the relative error of a value scaled by up to three multiplications or divisions in double precision,
+     * under which its rounding to an integer may differ from the rounding of the exact value
+     */
+    const double tie_margin = 8.8817841970012523e-16; // 2^-50
+
+    /**
+     * @brief printf_digits gets the 9 significant digits of a value correctly rounded, and the power of ten of the first one, from printf
+     * @details only the digits and the exponent are read, so the decimal point of the locale does not matter
+     */
+    uint64_t printf_digits(double magnitude, int& exponent)
+    {
+        char text[32];
+        const char* it = text;
+        uint64_t digits = 0;
+
+        std::snprintf(text, sizeof(text), "%.8e", magnitude);
+
+        for (; *it && *it != 'e'; it++)
+            if (is_digit(*it))
+                digits = digits * 10 + (*it - '0');
+
+        exponent = std::atoi(it + 1);
+        return digits;
+    }
+
+    /** @brief matches checks case-insensitively that the text starts with a lower-case word */
+    bool matches(const char* begin, const char* end, const char* word)
+    {
+        for (; *word; begin++, word++)
+            if (begin >= end || (*begin | 0x20) != *word)
+                return false;
+
+        return true;
+    }
+}
+
+const char* cos_lib::aux::parse_float(const char* begin, const char* end, float& value)
+{
+    const char* it = begin;
+    bool negative = false;
+
+    value = 0;
+
+    if (it < end && (*it == '-' || *it == '+'))
+    {
+        negative = (*it == '-');
+        it++;
+    }
+
+    if (matches(it, end, "nan"))
+    {
+        value = std::numeric_limits<float>::quiet_NaN();
+        return it + 3;
+    }
+
+    if (matches(it, end, "inf"))
+    {
+        value = negative ? -std::numeric_limits<float>::infinity() : std::numeric_limits<float>::infinity();
+        return matches(it, end, "infinity") ? it + 8 : it + 3;
+    }
+
+    uint64_t mantissa = 0;  // significant digits, leading zeros excluded
+    int nb_digits = 0;
+    int exponent = 0;       // power of ten the mantissa must be multiplied by
+    bool has_digits = false;
+
+    for (; it < end && is_digit(*it); it++)
+    {
+        has_digits = true;
+
+        if (nb_digits < 19)
+        {
+            mantissa = mantissa * 10 + (*it - '0');
+            nb_digits += (mantissa != 0);
+        }
+
+        else
+            exponent++; // digits beyond the 19th only change the magnitude
+    }
+
+    if (it < end && *it == '.')
+    {
+        for (it++; it < end && is_digit(*it); it++)
+        {
+            has_digits = true;
+
+            if (nb_digits < 19)
+            {
+                mantissa = mantissa * 10 + (*it - '0');
+                nb_digits += (mantissa != 0);
+                exponent--;
+            }
+        }
+    }
+
+    if (!has_digits)
+        return begin;
+
+    // the exponent is only consumed if it holds at least one digit
+    if (it < end && (*it == 'e' || *it == 'E'))
+    {
+        const char* exp_it = it + 1;
+        bool exp_negative = false;
+        int exp_value = 0;
+
+        if (exp_it < end && (*exp_it == '-' || *exp_it == '+'))
+        {
+            exp_negative = (*exp_it == '-');
+            exp_it++;
+        }
+
+        if (exp_it < end && is_digit(*exp_it))
+        {
+            for (; exp_it < end && is_digit(*exp_it); exp_it++)
+                if (exp_value < 100000)
+                    exp_value = exp_value * 10 + (*exp_it - '0');
+
+            exponent += exp_negative ? -exp_value : exp_value;
+            it = exp_it;
+        }
+    }
+
+    double result = (double)mantissa;
+
+    if (mantissa != 0)
+    {
+        for (; exponent > 22; exponent -= 22)
+            result *= 1e22;
+
+        for (; exponent < -22; exponent += 22)
+            result /= 1e22;
+
+        if (exponent >= 0)
+            result *= pow10_table[exponent];
+
+        else
+            result /= pow10_table[-exponent];
+    }
+
+    value = negative ? -(float)result : (float)result;
+    return it;
+}
+
+char* cos_lib::aux::format_float(float value, char* out)
+{
+    if (std::signbit(value))
+        *out++ = '-';
+
+    if (std::isnan(value) || std::isinf(value))
+    {
+        std::memcpy(out, std::isnan(value) ? "nan" : "inf", 3);
+        return out + 3;
+    }
+
+    if (value == 0)
+    {
+        *out++ = '0';
+        return out;
+    }
+
+    // the 9 significant digits are computed as an integer in [10^8, 10^9[, exponent being the power of ten of the first one
+    const double magnitude = std::fabs((double)value);
+    int exponent = (int)std::floor(std::log10(magnitude));
+    uint64_t digits = 0;
+
+    for (int attempt = 0; attempt < 2; attempt++)
+    {
+        double scaled = magnitude;
+        int scale = 8 - exponent;
+
+        for (; scale > 22; scale -= 22)
+            scaled *= 1e22;
+
+        for (; scale < -22; scale += 22)
+            scaled /= 1e22;
+
+        scaled = (scale >= 0) ? scaled * pow10_table[scale] : scaled / pow10_table[-scale];
+
+        // the scaled value is a few roundings off the exact one, which only matters when it is that close to a tie
+        if (std::fabs(scaled - std::floor(scaled) - 0.5) <= scaled * tie_margin)
+        {
+            digits = printf_digits(magnitude, exponent);
+            break;
+        }
+
+        digits = (uint64_t)std::nearbyint(scaled);
+
+        // log10 may be one off close to a power of ten, and rounding may carry to the next power of ten
+        if (digits >= 1000000000ull)
+            exponent++;
+
+        else if (digits < 100000000ull)
+            exponent--;
+
+        else
+            break;
+    }
+
+    char buffer[9];
+
+    for (int i = 8; i >= 0; i--)
+    {
+        buffer[i] = (char)('0' + digits % 10);
+        digits /= 10;
+    }
+
+    int nb_digits = 9;
+
+    while (nb_digits > 1 && buffer[nb_digits - 1] == '0')
+        nb_digits--;
+
+    if (exponent >= -4 && exponent < 9)
+    {
+        if (exponent < 0)
+        {
+            *out++ = '0';
+            *out++ = '.';
+
+            for (int i = -1; i > exponent; i--)
+                *out++ = '0';
+
+            std::memcpy(out, buffer, nb_digits);
+            return out + nb_digits;
+        }
+
+        int nb_integer_digits = exponent + 1;
+
+        std::memcpy(out, buffer, nb_integer_digits);
+        out += nb_integer_digits;
+
+        if (nb_digits > nb_integer_digits)
+        {
+            *out++ = '.';
+            std::memcpy(out, buffer + nb_integer_digits, nb_digits - nb_integer_digits);
+            out += nb_digits - nb_integer_digits;
+        }
+
+        return out;
+    }
+
+    *out++ = buffer[0];
+
+    if (nb_digits > 1)
+    {
+        *out++ = '.';
+        std::memcpy(out, buffer + 1, nb_digits - 1);
+        out += nb_digits - 1;
+    }
+
+    *out++ = 'e';
+    *out++ = (exponent < 0) ? '-' : '+';
+
+    int abs_exponent = std::abs(exponent);
+
+    if (abs_exponent >= 100)
+        *out++ = (char)('0' + abs_exponent / 100);
+
+    *out++ = (char)('0' + (abs_exponent / 10) % 10);
+    *out++ = (char)('0' + abs_exponent % 10);
+
+    return out;
+}
+
+char* cos_lib::aux::format_uint(uint32_t value, char* out)
+{
+    char buffer[10];
+    int nb_digits = 0;
+
+    do
+    {
+        buffer[9 - nb_digits++] = (char)('0' + value % 10);
+        value /= 10;
+    }
+    while (value != 0);
+
+    std::memcpy(out, buffer + 10 - nb_digits, nb_digits);
+    return out + nb_digits;
+}
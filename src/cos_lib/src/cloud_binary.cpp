@@ -0,0 +1,295 @@
+#include "../include/cloud_binary.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+    const char binary_cloud_magic[4] = { 'C', 'O', 'S', 'C' };
+
+    /** @brief column_count gets the number of 4 bytes columns of the chunks of a file */
+    size_t column_count(uint32_t flags)
+    {
+        return 4 + ((flags & cos_lib::io::binary_cloud_has_normals) ? 4 : 0) + ((flags & cos_lib::io::binary_cloud_has_labels) ? 1 : 0);
+    }
+
+    /** @brief align_chunk rounds a file position up to the next multiple of 64 bytes */
+    uint64_t align_chunk(uint64_t offset)
+    {
+        return (offset + 63) & ~(uint64_t)63;
+    }
+}
+
+cos_lib::io::binary_cloud_view::binary_cloud_view(std::string path) : file(QString(path.c_str()))
+{
+    this->data = nullptr;
+
+    if (!this->file.open(QIODevice::ReadOnly))
+        throw cos_lib::except::invalid_path();
+
+    qint64 file_size = this->file.size();
+
+    if (file_size < (qint64)sizeof(cos_lib::io::binary_cloud_header)
+            || !(this->data = this->file.map(0, file_size)))
+    {
+        this->file.close();
+        throw cos_lib::except::invalid_path();
+    }
+
+    this->header = (const cos_lib::io::binary_cloud_header*)this->data;
+    this->directory = (const cos_lib::io::binary_cloud_chunk_entry*)(this->data + sizeof(cos_lib::io::binary_cloud_header));
+
+    // every chunk is checked once so that getChunk never reads outside the mapping
+    const cos_lib::io::binary_cloud_header& head = *this->header;
+    bool is_valid = std::memcmp(head.magic, binary_cloud_magic, 4) == 0
+            && head.version == binary_cloud_version
+            && head.chunk_capacity > 0
+            && head.nb_chunks == (head.nb_points + head.chunk_capacity - 1) / head.chunk_capacity
+            && head.nb_chunks <= ((uint64_t)file_size - sizeof(cos_lib::io::binary_cloud_header)) / sizeof(cos_lib::io::binary_cloud_chunk_entry);
+
+    for (uint64_t chunk = 0; is_valid && chunk < head.nb_chunks; chunk++)
+    {
+        const cos_lib::io::binary_cloud_chunk_entry& entry = this->directory[chunk];
+        uint64_t expected_points = std::min((uint64_t)head.chunk_capacity, head.nb_points - chunk * head.chunk_capacity);
+
+        is_valid = entry.nb_points == expected_points
+                && entry.offset % 64 == 0
+                && entry.offset <= (uint64_t)file_size
+                && entry.nb_points * column_count(head.flags) * 4 <= (uint64_t)file_size - entry.offset;
+    }
+
+    if (!is_valid)
+    {
+        this->file.unmap((uchar*)this->data);
+        this->file.close();
+        throw cos_lib::except::invalid_path();
+    }
+}
+
+cos_lib::io::binary_cloud_view::~binary_cloud_view()
+{
+    this->file.unmap((uchar*)this->data);
+    this->file.close();
+}
+
+cos_lib::io::binary_cloud_chunk cos_lib::io::binary_cloud_view::getChunk(size_t chunk) const
+{
+    const cos_lib::io::binary_cloud_chunk_entry& entry = this->directory[chunk];
+    const uchar* column = this->data + entry.offset;
+    const size_t column_size = entry.nb_points * 4;
+    cos_lib::io::binary_cloud_chunk result;
+
+    result.nb_points = entry.nb_points;
+    result.min = entry.min;
+    result.max = entry.max;
+
+    result.x = (const float*)column; column += column_size;
+    result.y = (const float*)column; column += column_size;
+    result.z = (const float*)column; column += column_size;
+    result.rgb = (const uint32_t*)column; column += column_size;
+
+    result.normal_x = result.normal_y = result.normal_z = result.curvature = nullptr;
+    result.label = nullptr;
+
+    if (this->hasNormals())
+    {
+        result.normal_x = (const float*)column; column += column_size;
+        result.normal_y = (const float*)column; column += column_size;
+        result.normal_z = (const float*)column; column += column_size;
+        result.curvature = (const float*)column; column += column_size;
+    }
+
+    if (this->hasLabels())
+        result.label = (const uint32_t*)column;
+
+    return result;
+}
+
+pcl::PointCloud<pcl::PointXYZRGB>::Ptr cos_lib::io::binary_cloud_view::toCloud() const
+{
+    pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud(new pcl::PointCloud<pcl::PointXYZRGB>);
+
+    cloud->resize(this->getNbPoints());
+    cloud->width = cloud->points.size();
+    cloud->height = 1;
+
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (long chunk = 0; chunk < (long)this->getNbChunks(); chunk++)
+    {
+        cos_lib::io::binary_cloud_chunk columns = this->getChunk(chunk);
+        pcl::PointXYZRGB* points = &cloud->points[this->getChunkOffset(chunk)];
+
+        for (size_t i = 0; i < columns.nb_points; i++)
+        {
+            points[i].x = columns.x[i];
+            points[i].y = columns.y[i];
+            points[i].z = columns.z[i];
+            points[i].r = (uint8_t)(columns.rgb[i] >> 16);
+            points[i].g = (uint8_t)(columns.rgb[i] >> 8);
+            points[i].b = (uint8_t)columns.rgb[i];
+        }
+    }
+
+    return cloud;
+}
+
+void cos_lib::io::binary_cloud_view::toNormals(cos_lib::normal_buffer& normals) const
+{
+    normals.resize(this->getNbPoints());
+
+    if (!this->hasNormals())
+    {
+        const float nan = std::numeric_limits<float>::quiet_NaN();
+        std::fill(normals.normal_x.begin(), normals.normal_x.end(), nan);
+        std::fill(normals.normal_y.begin(), normals.normal_y.end(), nan);
+        std::fill(normals.normal_z.begin(), normals.normal_z.end(), nan);
+        std::fill(normals.curvature.begin(), normals.curvature.end(), nan);
+        return;
+    }
+
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (long chunk = 0; chunk < (long)this->getNbChunks(); chunk++)
+    {
+        cos_lib::io::binary_cloud_chunk columns = this->getChunk(chunk);
+        size_t offset = this->getChunkOffset(chunk);
+
+        std::memcpy(&normals.normal_x[offset], columns.normal_x, columns.nb_points * sizeof(float));
+        std::memcpy(&normals.normal_y[offset], columns.normal_y, columns.nb_points * sizeof(float));
+        std::memcpy(&normals.normal_z[offset], columns.normal_z, columns.nb_points * sizeof(float));
+        std::memcpy(&normals.curvature[offset], columns.curvature, columns.nb_points * sizeof(float));
+    }
+}
+
+void cos_lib::io::binary_cloud_view::toLabels(std::vector<uint32_t>& labels) const
+{
+    labels.assign(this->getNbPoints(), 0);
+
+    if (!this->hasLabels())
+        return;
+
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (long chunk = 0; chunk < (long)this->getNbChunks(); chunk++)
+    {
+        cos_lib::io::binary_cloud_chunk columns = this->getChunk(chunk);
+        std::memcpy(&labels[this->getChunkOffset(chunk)], columns.label, columns.nb_points * sizeof(uint32_t));
+    }
+}
+
+void cos_lib::io::save_cloud_binary(std::string path, pcl::PointCloud<pcl::PointXYZRGB>::ConstPtr cloud_ptr,
+                                    const cos_lib::normal_buffer* normals, const std::vector<uint32_t>* labels, size_t chunk_capacity)
+{
+    if (!cloud_ptr)
+        throw cos_lib::except::invalid_cloud_pointer();
+
+    const size_t nb_points = cloud_ptr->points.size();
+
+    if (chunk_capacity == 0 || chunk_capacity > std::numeric_limits<uint32_t>::max())
+        throw std::invalid_argument("The chunk capacity must be strictly positive and fit in 32 bits.");
+    if (normals && normals->size() != nb_points)
+        throw std::invalid_argument("There must be one normal per point.");
+    if (labels && labels->size() != nb_points)
+        throw std::invalid_argument("There must be one label per point.");
+
+    cos_lib::io::binary_cloud_header header;
+
+    std::memcpy(header.magic, binary_cloud_magic, 4);
+    header.version = binary_cloud_version;
+    header.flags = (normals ? binary_cloud_has_normals : 0) | (labels ? binary_cloud_has_labels : 0);
+    header.chunk_capacity = (uint32_t)chunk_capacity;
+    header.nb_points = nb_points;
+    header.nb_chunks = (nb_points + chunk_capacity - 1) / chunk_capacity;
+
+    // the directory, bounding boxes included, is built before writing anything
+    std::vector<cos_lib::io::binary_cloud_chunk_entry> directory(header.nb_chunks);
+    uint64_t offset = align_chunk(sizeof(header) + directory.size() * sizeof(cos_lib::io::binary_cloud_chunk_entry));
+
+    for (size_t chunk = 0; chunk < directory.size(); chunk++)
+    {
+        directory[chunk].offset = offset;
+        directory[chunk].nb_points = (uint32_t)std::min(chunk_capacity, nb_points - chunk * chunk_capacity);
+        directory[chunk].reserved = 0;
+        offset = align_chunk(offset + directory[chunk].nb_points * column_count(header.flags) * 4);
+    }
+
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (long chunk = 0; chunk < (long)directory.size(); chunk++)
+    {
+        cos_lib::io::binary_cloud_chunk_entry& entry = directory[chunk];
+        const pcl::PointXYZRGB* points = &cloud_ptr->points[chunk * chunk_capacity];
+
+        entry.min[0] = entry.max[0] = points[0].x;
+        entry.min[1] = entry.max[1] = points[0].y;
+        entry.min[2] = entry.max[2] = points[0].z;
+
+        for (size_t i = 1; i < entry.nb_points; i++)
+        {
+            entry.min[0] = std::min(entry.min[0], points[i].x); entry.max[0] = std::max(entry.max[0], points[i].x);
+            entry.min[1] = std::min(entry.min[1], points[i].y); entry.max[1] = std::max(entry.max[1], points[i].y);
+            entry.min[2] = std::min(entry.min[2], points[i].z); entry.max[2] = std::max(entry.max[2], points[i].z);
+        }
+    }
+
+    std::ofstream cloud_file(path, std::ios::out | std::ios::binary | std::ios::trunc);
+
+    if (!cloud_file.is_open())
+        throw cos_lib::except::invalid_path();
+
+    cloud_file.write((const char*)&header, sizeof(header));
+    cloud_file.write((const char*)directory.data(), directory.size() * sizeof(cos_lib::io::binary_cloud_chunk_entry));
+
+    // each chunk is gathered into its columns, padding included, then written with a single call
+    std::vector<char> buffer;
+    uint64_t position = sizeof(header) + directory.size() * sizeof(cos_lib::io::binary_cloud_chunk_entry);
+
+    for (size_t chunk = 0; chunk < directory.size() && cloud_file; chunk++)
+    {
+        const cos_lib::io::binary_cloud_chunk_entry& entry = directory[chunk];
+        const size_t first = chunk * chunk_capacity;
+        const size_t n = entry.nb_points;
+        const size_t padding = entry.offset - position;
+
+        buffer.assign(padding + n * column_count(header.flags) * 4, 0);
+
+        float* x = (float*)(buffer.data() + padding);
+        float* y = x + n;
+        float* z = y + n;
+        uint32_t* rgb = (uint32_t*)(z + n);
+
+        for (size_t i = 0; i < n; i++)
+        {
+            const pcl::PointXYZRGB& point = cloud_ptr->points[first + i];
+            x[i] = point.x;
+            y[i] = point.y;
+            z[i] = point.z;
+            rgb[i] = ((uint32_t)point.r << 16) | ((uint32_t)point.g << 8) | (uint32_t)point.b;
+        }
+
+        char* column = (char*)(rgb + n);
+
+        if (normals)
+        {
+            std::memcpy(column, &normals->normal_x[first], n * sizeof(float)); column += n * sizeof(float);
+            std::memcpy(column, &normals->normal_y[first], n * sizeof(float)); column += n * sizeof(float);
+            std::memcpy(column, &normals->normal_z[first], n * sizeof(float)); column += n * sizeof(float);
+            std::memcpy(column, &normals->curvature[first], n * sizeof(float)); column += n * sizeof(float);
+        }
+
+        if (labels)
+            std::memcpy(column, &(*labels)[first], n * sizeof(uint32_t));
+
+        cloud_file.write(buffer.data(), buffer.size());
+        position += buffer.size();
+    }
+
+    cloud_file.close();
+
+    if (cloud_file.fail())
+        throw cos_lib::except::invalid_path();
+}
+
+pcl::PointCloud<pcl::PointXYZRGB>::Ptr cos_lib::io::load_cloud_binary(std::string path)
+{
+    cos_lib::io::binary_cloud_view view(path);
+    return view.toCloud();
+}
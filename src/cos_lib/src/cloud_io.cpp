@@ -1,114 +1,491 @@
 #include "../include/cloud_io.h"
+#include "../include/cloud_binary.h"
 
-pcl::PointCloud<pcl::PointXYZRGB>::Ptr cos_lib::io::import_cloud_txt(std::string pathname)
+namespace
 {
-    QFile file(QString(pathname.c_str()));
+    bool is_separator(char c) { return c == '\t' || c == ' '; }
 
-    if(!file.open(QIODevice::ReadOnly | QIODevice::Text))
-        throw cos_lib::except::invalid_path();
+    /** @brief line_end gets a pointer on the '\n' ending the line, or on end */
+    const char* line_end(const char* line, const char* end)
+    {
+        const char* newline = (const char*)std::memchr(line, '\n', end - line);
+        return newline ? newline : end;
+    }
+
+    /** @brief content_end gets a pointer past the last character of a line that is neither a separator nor a carriage return */
+    const char* content_end(const char* line, const char* eol)
+    {
+        while (eol > line && (eol[-1] == '\r' || is_separator(eol[-1])))
+            eol--;
 
-    QTextStream flux(&file);
-    QString  line;  // each read line
-    std::vector<float> pt_x;
-    std::vector<float> pt_y;
-    std::vector<float> pt_z;
-    std::vector<float> pt_r;
-    std::vector<float> pt_g;
-    std::vector<float> pt_b;
+        return eol;
+    }
 
-    while(!flux.atEnd())
+    /**
+     * @brief parse_line reads the columns of one line
+     * @return the number of columns read, at most max_columns, or max_columns + 1 if the line holds more columns or something else than numbers
+     */
+    int parse_line(const char* it, const char* eol, float* values, int max_columns)
     {
-        line = flux.readLine();
-        QStringList result = line.split("\t"); // split the line with space as a separator character
+        int nb_columns = 0;
 
-        if(result.size() < 3)
-            throw cos_lib::except::invalid_path();
+        while (true)
+        {
+            while (it < eol && is_separator(*it))
+                it++;
+
+            if (it == eol)
+                return nb_columns;
+
+            if (nb_columns == max_columns)
+                return max_columns + 1;
+
+            const char* next = cos_lib::aux::parse_float(it, eol, values[nb_columns]);
+
+            if (next == it || (next < eol && !is_separator(*next)))
+                return max_columns + 1;
+
+            nb_columns++;
+            it = next;
+        }
+    }
+
+    /** @brief max_line_length is the maximum number of characters of a line written by format_points */
+    const size_t max_line_length = 3 * (cos_lib::aux::max_float_length + 1) + 3 * 4;
+
+    /**
+     * @brief format_points writes points as tab separated lines
+     * @param out is a pointer to a buffer of at least max_line_length characters per point
+     * @return a pointer past the last character written
+     */
+    char* format_points(const pcl::PointXYZRGB* begin, const pcl::PointXYZRGB* end, char* out)
+    {
+        for (const pcl::PointXYZRGB* pt = begin; pt < end; pt++)
+        {
+            out = cos_lib::aux::format_float(pt->x, out);
+            *out++ = '\t';
+            out = cos_lib::aux::format_float(pt->y, out);
+            *out++ = '\t';
+            out = cos_lib::aux::format_float(pt->z, out);
+            *out++ = '\t';
+            out = cos_lib::aux::format_uint(pt->r, out);
+            *out++ = '\t';
+            out = cos_lib::aux::format_uint(pt->g, out);
+            *out++ = '\t';
+            out = cos_lib::aux::format_uint(pt->b, out);
+            *out++ = '\n';
+        }
+
+        return out;
+    }
+
+    /** @brief The mapped_file class maps a whole file in memory, or reads it if it cannot be mapped, until it is destroyed */
+    class mapped_file
+    {
+    public:
+        mapped_file(std::string path) : file(QString(path.c_str()))
+        {
+            if (!this->file.open(QIODevice::ReadOnly))
+                throw cos_lib::except::invalid_path();
+
+            this->size = this->file.size();
+            this->data = nullptr;
+
+            if (this->size > 0)
+            {
+                uchar* mapping = this->file.map(0, this->size);
+
+                if (mapping)
+                    this->data = (const char*)mapping;
+
+                else
+                {
+                    this->content = this->file.readAll();
+                    this->data = this->content.constData();
+                    this->size = this->content.size();
+                }
+            }
+        }
+
+        // closing the file also unmaps it
+        ~mapped_file() { this->file.close(); }
+
+        const char* begin() const { return this->data; }
+        const char* end() const { return this->data + this->size; }
+
+    private:
+        QFile file;
+        QByteArray content;     // only filled if the file cannot be mapped
+        const char* data;
+        qint64 size;
+    };
+
+    /** @brief skip_lines gets a pointer past the first nb_lines lines of a text, or end if it holds less lines */
+    const char* skip_lines(const char* begin, const char* end, size_t nb_lines)
+    {
+        for (; nb_lines > 0 && begin < end; nb_lines--)
+        {
+            const char* eol = line_end(begin, end);
+            begin = (eol == end) ? end : eol + 1;
+        }
+
+        return begin;
+    }
 
-        QString r;  // reads each coordinate
+    /**
+     * @brief parse_lines parses the non empty lines of a text into a cloud, one point per line
+     * @details the text is cut into chunks of about 4 MB, each starting right after a newline. The lines of each chunk are
+     * counted in parallel so that each chunk knows where to write its points, then the points are parsed in parallel straight into the cloud
+     * @param parse_point is called as parse_point(line begin, line end, point) to parse a line without its separators
+     * and carriage return, and returns false if the line is not a point
+     * @throw invalid_path if a line is not a point
+     */
+    template<typename line_parser>
+    void parse_lines(const char* begin, const char* end, pcl::PointCloud<pcl::PointXYZRGB>& cloud, const line_parser& parse_point)
+    {
+        const size_t chunk_size = 1 << 22;
+        size_t nb_chunks = std::max((size_t)1, (size_t)(end - begin) / chunk_size);
+        std::vector<const char*> chunk_begins(nb_chunks + 1);
 
-        r = result.at(0);
-        pt_x.push_back(r.toFloat());
+        chunk_begins[0] = begin;
+        chunk_begins[nb_chunks] = end;
 
-        r = result.at(1);
-        pt_y.push_back(r.toFloat());
+        for (size_t chunk = 1; chunk < nb_chunks; chunk++)
+        {
+            const char* start = std::max(begin + chunk * ((end - begin) / nb_chunks), chunk_begins[chunk - 1]);
+            const char* eol = line_end(start, end);
+            chunk_begins[chunk] = (eol == end) ? end : eol + 1;
+        }
 
-        r = result.at(2);
-        pt_z.push_back(r.toFloat());
+        // first pass: each chunk counts its points so that it knows where to write them
+        std::vector<size_t> chunk_offsets(nb_chunks + 1, 0);
 
-        // point cloud is rgb
-        if (result.size() == 6)
+        #pragma omp parallel for schedule(dynamic, 1)
+        for (long chunk = 0; chunk < (long)nb_chunks; chunk++)
         {
-            pt_r.push_back(result.at(3).toFloat());
-            pt_g.push_back(result.at(4).toFloat());
-            pt_b.push_back(result.at(5).toFloat());
+            size_t nb_lines = 0;
+
+            for (const char* line = chunk_begins[chunk]; line < chunk_begins[chunk + 1]; )
+            {
+                const char* eol = line_end(line, chunk_begins[chunk + 1]);
+
+                if (content_end(line, eol) != line)
+                    nb_lines++;
+
+                line = (eol == chunk_begins[chunk + 1]) ? eol : eol + 1;
+            }
+
+            chunk_offsets[chunk + 1] = nb_lines;
         }
 
-        // point cloud is not rgb
-        else if (result.size() < 6)
+        for (size_t chunk = 0; chunk < nb_chunks; chunk++)
+            chunk_offsets[chunk + 1] += chunk_offsets[chunk];
+
+        cloud.resize(chunk_offsets[nb_chunks]);
+        cloud.width = cloud.points.size();
+        cloud.height = 1;
+
+        // second pass: the points are parsed straight into the cloud
+        std::atomic<bool> invalid_line(false);
+
+        #pragma omp parallel for schedule(dynamic, 1)
+        for (long chunk = 0; chunk < (long)nb_chunks; chunk++)
         {
-            pt_r.push_back((float)255);
-            pt_g.push_back((float)255);
-            pt_b.push_back((float)255);
+            size_t pt_index = chunk_offsets[chunk];
+
+            for (const char* line = chunk_begins[chunk]; line < chunk_begins[chunk + 1] && !invalid_line; )
+            {
+                const char* eol = line_end(line, chunk_begins[chunk + 1]);
+                const char* last = content_end(line, eol);
+                const char* first = line;
+
+                while (first < last && is_separator(*first))
+                    first++;
+
+                if (last != line && !parse_point(first, last, cloud.points[pt_index++]))
+                {
+                    invalid_line = true;
+                    break;
+                }
+
+                line = (eol == chunk_begins[chunk + 1]) ? eol : eol + 1;
+            }
         }
 
-        // unknown format
-        else
+        if (invalid_line)
             throw cos_lib::except::invalid_path();
     }
+}
 
-    file.close();
+pcl::PointCloud<pcl::PointXYZRGB>::Ptr cos_lib::io::import_cloud_txt(std::string pathname)
+{
+    mapped_file file(pathname);
 
+    return cos_lib::io::parse_cloud_txt(file.begin(), file.end());
+}
+
+pcl::PointCloud<pcl::PointXYZRGB>::Ptr cos_lib::io::parse_cloud_txt(const char* begin, const char* end)
+{
     pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud(new pcl::PointCloud<pcl::PointXYZRGB>);
 
-    // fill in the cloud data
-    for (unsigned int i = 0; i < pt_x.size(); i++)
+    // the column layout is read once, on the first line holding something
+    const char* first_line = begin;
+    int nb_columns = 0;
+    float values[7];
+
+    while (first_line < end && nb_columns == 0)
     {
-       pcl::PointXYZRGB pt;
-
-       pt.x = pt_x[i];
-       pt.y = pt_y[i];
-       pt.z = pt_z[i];
-       pt.r = pt_r[i];
-       pt.g = pt_g[i];
-       pt.b = pt_b[i];
-       cloud->push_back(pt);
+        const char* eol = line_end(first_line, end);
+        nb_columns = parse_line(first_line, content_end(first_line, eol), values, 6);
+        first_line = (eol == end) ? end : eol + 1;
     }
 
+    if (nb_columns == 0)
+        return cloud;
+
+    if (nb_columns < 3 || nb_columns > 6)
+        throw cos_lib::except::invalid_path();
+
+    const bool is_rgb = (nb_columns == 6);
+
+    parse_lines(begin, end, *cloud, [nb_columns, is_rgb](const char* line, const char* last, pcl::PointXYZRGB& pt)
+    {
+        float pt_values[7];
+
+        if (parse_line(line, last, pt_values, nb_columns) != nb_columns)
+            return false;
+
+        pt.x = pt_values[0];
+        pt.y = pt_values[1];
+        pt.z = pt_values[2];
+        pt.r = is_rgb ? (uint8_t)pt_values[3] : 255;
+        pt.g = is_rgb ? (uint8_t)pt_values[4] : 255;
+        pt.b = is_rgb ? (uint8_t)pt_values[5] : 255;
+
+        return true;
+    });
+
     return cloud;
 }
 
-pcl::PointCloud<pcl::PointXYZRGB>::Ptr cos_lib::io::import_cloud(std::string path)
+pcl::PointCloud<pcl::PointXYZRGB>::Ptr cos_lib::io::parse_cloud_pcd(const char* begin, const char* end)
 {
-    std::string ext;    // files extension
-    size_t i = path.rfind('.', path.length());
-    pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud;
+    pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud(new pcl::PointCloud<pcl::PointXYZRGB>);
+    const cos_lib::io::pcd_header header = cos_lib::io::parse_pcd_header(begin, end);
+    const char* data = begin + header.data_offset;
+    const size_t nb_points = header.nb_points;
+
+    if (header.data == cos_lib::io::pcd_header::ascii)
+    {
+        parse_lines(data, end, *cloud, [&header](const char* line, const char* last, pcl::PointXYZRGB& pt)
+        {
+            return cos_lib::io::parse_pcd_line(header, line, last, pt);
+        });
+
+        if (cloud->points.size() != nb_points)
+            throw cos_lib::except::invalid_path();
+
+        return cloud;
+    }
+
+    cloud->resize(nb_points);
+    cloud->width = nb_points;
+    cloud->height = 1;
+
+    if (header.data == cos_lib::io::pcd_header::binary)
+    {
+        if ((size_t)(end - data) / header.point_step < nb_points)
+            throw cos_lib::except::invalid_path();
+
+        #pragma omp parallel for schedule(static)
+        for (long i = 0; i < (long)nb_points; i++)
+            cos_lib::io::decode_pcd_point(header, data + i * header.point_step, cloud->points[i]);
+
+        return cloud;
+    }
+
+    // binary_compressed: the sizes of the compressed and decompressed data, then the LZF data
+    uint32_t sizes[2];
+
+    if (end - data < 8)
+        throw cos_lib::except::invalid_path();
+
+    std::memcpy(sizes, data, 8);
+
+    if ((size_t)(end - data - 8) < sizes[0] || sizes[1] != nb_points * header.point_step)
+        throw cos_lib::except::invalid_path();
+
+    std::vector<char> columns(sizes[1]);
+
+    if (sizes[1] > 0 && cos_lib::io::lzf_decompress(data + 8, sizes[0], columns.data(), columns.size()) != columns.size())
+        throw cos_lib::except::invalid_path();
+
+    #pragma omp parallel for schedule(static)
+    for (long i = 0; i < (long)nb_points; i++)
+        cos_lib::io::decode_pcd_compressed_point(header, columns.data(), i, cloud->points[i]);
 
-    if (i != std::string::npos)
-      ext = path.substr(i+1, path.length() - i);
+    return cloud;
+}
 
-    if (ext.compare("pcd") == 0)
+pcl::PointCloud<pcl::PointXYZRGB>::Ptr cos_lib::io::parse_cloud_ply(const char* begin, const char* end)
+{
+    pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud(new pcl::PointCloud<pcl::PointXYZRGB>);
+    const cos_lib::io::ply_header header = cos_lib::io::parse_ply_header(begin, end);
+    const char* data = begin + header.data_offset;
+    const size_t nb_points = header.nb_points;
 
+    if (header.data == cos_lib::io::ply_header::ascii)
     {
-        pcl::io::loadPCDFile<pcl::PointXYZRGB> (path, *cloud);
+        // the vertices are the lines following the elements stored before them, the other elements following the vertices
+        const char* vertices = skip_lines(data, end, header.skipped_size);
+
+        parse_lines(vertices, skip_lines(vertices, end, nb_points), *cloud, [&header](const char* line, const char* last, pcl::PointXYZRGB& pt)
+        {
+            return cos_lib::io::parse_ply_line(header, line, last, pt);
+        });
 
-        if (!cloud)
+        if (cloud->points.size() != nb_points)
             throw cos_lib::except::invalid_path();
+
+        return cloud;
     }
 
-    else if (ext.compare("txt") == 0)
-        cloud = cos_lib::io::import_cloud_txt(path);
+    if ((size_t)(end - data) < header.skipped_size || (header.point_step > 0 && (size_t)(end - data - header.skipped_size) / header.point_step < nb_points))
+        throw cos_lib::except::invalid_path();
+
+    data += header.skipped_size;
+    cloud->resize(nb_points);
+    cloud->width = nb_points;
+    cloud->height = 1;
+
+    #pragma omp parallel for schedule(static)
+    for (long i = 0; i < (long)nb_points; i++)
+        cos_lib::io::decode_ply_point(header, data + i * header.point_step, cloud->points[i]);
+
+    return cloud;
+}
+
+pcl::PointCloud<pcl::PointXYZRGB>::Ptr cos_lib::io::parse_cloud_las(const char* begin, const char* end, double* origin)
+{
+    pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud(new pcl::PointCloud<pcl::PointXYZRGB>);
+    const cos_lib::io::las_header header = cos_lib::io::parse_las_header(begin, end);
+    const char* data = begin + header.data_offset;
+    const size_t nb_points = header.nb_points;
+
+    // no LASzip decoder is available
+    if (header.is_compressed)
+        throw cos_lib::except::invalid_path();
+
+    if (origin)
+        std::copy(header.origin, header.origin + 3, origin);
+
+    // colours are meant to use 16 bits, but some scanners store 8 bits colours in them
+    uint16_t colour_max = 0;
+
+    #pragma omp parallel for schedule(static) reduction(max:colour_max)
+    for (long i = 0; i < (long)nb_points; i++)
+        colour_max = std::max(colour_max, cos_lib::io::decode_las_colour_max(header, data + i * header.point_step));
+
+    const int colour_shift = (colour_max > 255) ? 8 : 0;
+
+    cloud->resize(nb_points);
+    cloud->width = nb_points;
+    cloud->height = 1;
+
+    #pragma omp parallel for schedule(static)
+    for (long i = 0; i < (long)nb_points; i++)
+        cos_lib::io::decode_las_point(header, data + i * header.point_step, colour_shift, cloud->points[i]);
 
     return cloud;
 }
 
-void cos_lib::io::export_cloud(std::string path, pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud_ptr)
+cos_lib::io::cloud_format cos_lib::io::detect_cloud_format(const char* begin, const char* end)
+{
+    const size_t size = end - begin;
+
+    if (size >= 4 && std::memcmp(begin, "COSC", 4) == 0)
+        return cos_lib::io::cloud_format::cosc;
+
+    if (size >= 4 && std::memcmp(begin, "LASF", 4) == 0)
+        return (size > 104 && (begin[104] & 0xC0) != 0) ? cos_lib::io::cloud_format::laz : cos_lib::io::cloud_format::las;
+
+    if (size >= 4 && std::memcmp(begin, "ply", 3) == 0 && (begin[3] == '\n' || begin[3] == '\r'))
+        return cos_lib::io::cloud_format::ply;
+
+    // a .pcd file starts with comments or with one of the keywords of its header, a .txt file with a point
+    for (const char* line = begin; line < end; )
+    {
+        const char* eol = line_end(line, end);
+        const char* last = content_end(line, eol);
+        const char* first = line;
+
+        line = (eol == end) ? end : eol + 1;
+
+        while (first < last && is_separator(*first))
+            first++;
+
+        if (first == last)
+            continue;
+
+        if (*first == '#')
+            return cos_lib::io::cloud_format::pcd;
+
+        static const char* const keywords[] = { "VERSION", "FIELDS", "COLUMNS", "SIZE", "TYPE", "COUNT",
+                                                "WIDTH", "HEIGHT", "VIEWPOINT", "POINTS", "DATA" };
+
+        for (size_t i = 0; i < sizeof(keywords) / sizeof(keywords[0]); i++)
+        {
+            size_t length = std::strlen(keywords[i]);
+
+            if ((size_t)(last - first) > length && std::memcmp(first, keywords[i], length) == 0 && is_separator(first[length]))
+                return cos_lib::io::cloud_format::pcd;
+        }
+
+        float values[7];
+        int nb_columns = parse_line(first, last, values, 6);
+
+        return (nb_columns >= 3 && nb_columns <= 6) ? cos_lib::io::cloud_format::txt : cos_lib::io::cloud_format::unknown;
+    }
+
+    // an empty text is an empty cloud
+    return cos_lib::io::cloud_format::txt;
+}
+
+pcl::PointCloud<pcl::PointXYZRGB>::Ptr cos_lib::io::import_cloud(std::string path, double* origin)
 {
+    mapped_file file(path);
 
+    if (origin)
+        std::fill(origin, origin + 3, 0.0);
+
+    switch (cos_lib::io::detect_cloud_format(file.begin(), file.end()))
+    {
+    case cos_lib::io::cloud_format::txt:
+        return cos_lib::io::parse_cloud_txt(file.begin(), file.end());
+
+    case cos_lib::io::cloud_format::pcd:
+        return cos_lib::io::parse_cloud_pcd(file.begin(), file.end());
+
+    case cos_lib::io::cloud_format::ply:
+        return cos_lib::io::parse_cloud_ply(file.begin(), file.end());
+
+    case cos_lib::io::cloud_format::las:
+        return cos_lib::io::parse_cloud_las(file.begin(), file.end(), origin);
+
+    case cos_lib::io::cloud_format::cosc:
+        return cos_lib::io::load_cloud_binary(path);
+
+    default:
+        throw cos_lib::except::invalid_path();
+    }
+}
+
+void cos_lib::io::export_cloud(std::string path, pcl::PointCloud<pcl::PointXYZRGB>::ConstPtr cloud_ptr, bool parallel)
+{
     if (!cloud_ptr)
         throw cos_lib::except::invalid_cloud_pointer();
 
     std::ofstream cloud_file;
-    std::string line;
 
     // opening file
     cloud_file.open(path, std::ios::out);
@@ -116,16 +493,29 @@ void cos_lib::io::export_cloud(std::string path, pcl::PointCloud<pcl::PointXYZRG
     if (!cloud_file.is_open())
         throw cos_lib::except::invalid_path();
 
-    for (auto cloud_it = cloud_ptr->points.begin(); cloud_it < cloud_ptr->points.end(); cloud_it++)
+    const size_t nb_points = cloud_ptr->points.size();
+    const size_t chunk_size = 1 << 16;
+    const long nb_chunks = (long)((nb_points + chunk_size - 1) / chunk_size);
+
+    // each thread formats its chunks into its own buffer, the ordered block then writes the chunks one after the other
+    #pragma omp parallel if(parallel)
     {
-        line = boost::lexical_cast<std::string>((float)(*cloud_it).x) + "\t"
-                + boost::lexical_cast<std::string>((float)(*cloud_it).y) + "\t"
-                + boost::lexical_cast<std::string>((float)(*cloud_it).z) + "\t"
-                + boost::lexical_cast<std::string>((short)(*cloud_it).r) + "\t"
-                + boost::lexical_cast<std::string>((short)(*cloud_it).g) + "\t"
-                + boost::lexical_cast<std::string>((short)(*cloud_it).b)
-                + "\n";
-
-        cloud_file << line;
+        std::vector<char> buffer(chunk_size * max_line_length);
+
+        #pragma omp for ordered schedule(static, 1)
+        for (long chunk = 0; chunk < nb_chunks; chunk++)
+        {
+            size_t first = chunk * chunk_size;
+            char* last = format_points(cloud_ptr->points.data() + first,
+                                       cloud_ptr->points.data() + std::min(first + chunk_size, nb_points), buffer.data());
+
+            #pragma omp ordered
+            cloud_file.write(buffer.data(), last - buffer.data());
+        }
     }
+
+    cloud_file.close();
+
+    if (cloud_file.fail())
+        throw cos_lib::except::invalid_path();
 }
@@ -39,6 +39,29 @@ std::vector<float> cos_lib::cloud_manip::cloud_z_coords(pcl::PointCloud<pcl::Poi
     return z_coords;
 }
 
+cos_lib::cloud_manip::cloud_bounds cos_lib::cloud_manip::compute_bounds(const pcl::PointCloud<pcl::PointXYZRGB>& cloud)
+{
+    float x_min = FLT_MAX, y_min = FLT_MAX, z_min = FLT_MAX;
+    float x_max = -FLT_MAX, y_max = -FLT_MAX, z_max = -FLT_MAX;
+    const pcl::PointXYZRGB* points = cloud.points.data();
+    const long nb_points = (long)cloud.points.size();
+
+    #pragma omp parallel for simd schedule(static) reduction(min:x_min, y_min, z_min) reduction(max:x_max, y_max, z_max)
+    for (long i = 0; i < nb_points; i++)
+    {
+        x_min = points[i].x < x_min ? points[i].x : x_min;
+        y_min = points[i].y < y_min ? points[i].y : y_min;
+        z_min = points[i].z < z_min ? points[i].z : z_min;
+        x_max = points[i].x > x_max ? points[i].x : x_max;
+        y_max = points[i].y > y_max ? points[i].y : y_max;
+        z_max = points[i].z > z_max ? points[i].z : z_max;
+    }
+
+    cos_lib::cloud_manip::cloud_bounds bounds = { x_min, x_max, y_min, y_max, z_min, z_max };
+
+    return bounds;
+}
+
 void cos_lib::cloud_manip::copy_cloud(pcl::PointCloud<pcl::PointXYZRGB>::Ptr src_ptr,
                              pcl::PointCloud<pcl::PointXYZRGB>::Ptr dest_ptr)
 {
@@ -55,16 +78,22 @@ void cos_lib::cloud_manip::scale_cloud(pcl::PointCloud<pcl::PointXYZRGB>::Ptr cl
     if (!cloud_ptr)
         throw cos_lib::except::invalid_cloud_pointer();
 
+    cos_lib::cloud_manip::scale_batch(*cloud_ptr, x_scale, y_scale, z_scale);
+}
+
+void cos_lib::cloud_manip::scale_batch(pcl::PointCloud<pcl::PointXYZRGB>& batch, float x_scale, float y_scale, float z_scale)
+{
     if (cos_lib::aux::float_cmp(x_scale, 0.00, 0.005)
             || cos_lib::aux::float_cmp(y_scale, 0.00, 0.005)
             || cos_lib::aux::float_cmp(z_scale, 0.00, 0.005))
         throw std::invalid_argument("Scaling cloud by 0 will destroy the cloud.");
 
-    for (auto cloud_it = cloud_ptr->points.begin(); cloud_it < cloud_ptr->points.end(); cloud_it++)
+    #pragma omp parallel for schedule(static)
+    for (long i = 0; i < (long)batch.points.size(); i++)
     {
-        cloud_it->x *= x_scale;
-        cloud_it->y *= y_scale;
-        cloud_it->z *= z_scale;
+        batch.points[i].x *= x_scale;
+        batch.points[i].y *= y_scale;
+        batch.points[i].z *= z_scale;
     }
 }
 
@@ -75,61 +104,53 @@ pcl::PointCloud<pcl::PointXYZRGB>::Ptr cos_lib::cloud_manip::crop_cloud(
     if (!base_cloud_ptr)
         throw cos_lib::except::invalid_cloud_pointer();
 
-    pcl::PointCloud<pcl::PointXYZRGB>::Ptr cropped_cloud_ptr(new pcl::PointCloud<pcl::PointXYZRGB>);
-    bool crop_pt;
+    pcl::PointCloud<pcl::PointXYZRGB>::Ptr cropped_cloud_ptr(new pcl::PointCloud<pcl::PointXYZRGB>(*base_cloud_ptr));
 
-    for (auto cloud_it = base_cloud_ptr->begin(); cloud_it != base_cloud_ptr->end(); cloud_it++)
-    {
-        crop_pt = false;
+    cos_lib::cloud_manip::crop_batch(*cropped_cloud_ptr, x_thresh, y_thresh, z_thresh);
 
-        if ((std::abs(cloud_it->x) > std::abs(x_thresh)) && !cos_lib::aux::float_cmp(x_thresh, 0.00, 0.005))
-            crop_pt = true;
+    return cropped_cloud_ptr;
+}
 
-        if ((std::abs(cloud_it->y) > std::abs(y_thresh)) && !cos_lib::aux::float_cmp(y_thresh, 0.00, 0.005))
-            crop_pt = true;
+void cos_lib::cloud_manip::crop_batch(pcl::PointCloud<pcl::PointXYZRGB>& batch, float x_thresh, float y_thresh, float z_thresh)
+{
+    // a null threshold does not crop, which is the same as an infinite one
+    float x_limit = cos_lib::aux::float_cmp(x_thresh, 0.00, 0.005) ? FLT_MAX : std::abs(x_thresh);
+    float y_limit = cos_lib::aux::float_cmp(y_thresh, 0.00, 0.005) ? FLT_MAX : std::abs(y_thresh);
+    float z_limit = cos_lib::aux::float_cmp(z_thresh, 0.00, 0.005) ? FLT_MAX : std::abs(z_thresh);
+    size_t nb_kept = 0;
 
-        if ((std::abs(cloud_it->z) > std::abs(z_thresh)) && !cos_lib::aux::float_cmp(z_thresh, 0.00, 0.005))
-            crop_pt = true;
+    for (size_t i = 0; i < batch.points.size(); i++)
+    {
+        const pcl::PointXYZRGB& point = batch.points[i];
 
-        if (!crop_pt)
-            cropped_cloud_ptr->push_back(*cloud_it);
+        if (!(std::abs(point.x) > x_limit) && !(std::abs(point.y) > y_limit) && !(std::abs(point.z) > z_limit))
+            batch.points[nb_kept++] = point;
     }
 
-    return cropped_cloud_ptr;
+    batch.points.resize(nb_kept);
+    batch.width = nb_kept;
+    batch.height = 1;
 }
 
-void cos_lib::cloud_manip::homogenize_cloud(pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud_ptr, short epsilon)
+void cos_lib::cloud_manip::homogenize_cloud(pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud_ptr, short epsilon,
+                                           cos_lib::colour_histogram* histogram)
 {
     if (!cloud_ptr)
         throw cos_lib::except::invalid_cloud_pointer();
 
-    if (epsilon == 0)
-        throw std::invalid_argument("Epsilon cannot be 0 for cloud homogenization.");
-
-    for (auto cloud_it = cloud_ptr->begin(); cloud_it < cloud_ptr->end(); cloud_it++)
-    {
-        short r_times_epsilon = (short)(*cloud_it).r / epsilon;
-        short g_times_epsilon = (short)(*cloud_it).g / epsilon;
-        short b_times_epsilon = (short)(*cloud_it).b / epsilon;
-
-        if ((r_times_epsilon * epsilon) > 255)
-            (*cloud_it).r = 255;
-
-        else
-            (*cloud_it).r = r_times_epsilon * epsilon;
-
-        if ((g_times_epsilon * epsilon) > 255)
-            (*cloud_it).g = 255;
+    cos_lib::cloud_manip::homogenize_batch(*cloud_ptr, epsilon, histogram);
+}
 
-        else
-            (*cloud_it).g = g_times_epsilon * epsilon;
+void cos_lib::cloud_manip::homogenize_batch(pcl::PointCloud<pcl::PointXYZRGB>& batch, short epsilon,
+                                           cos_lib::colour_histogram* histogram)
+{
+    cos_lib::colour_quantizer quantizer(epsilon);
 
-        if ((b_times_epsilon * epsilon) > 255)
-            (*cloud_it).b = 255;
+    if (histogram)
+        quantizer.apply(batch, *histogram);
 
-        else
-            (*cloud_it).b = b_times_epsilon * epsilon;
-    }
+    else
+        quantizer.apply(batch);
 }
 
 std::vector<pcl::PointCloud<pcl::PointXYZRGB>::Ptr> cos_lib::cloud_manip::fragment_cloud(
@@ -207,9 +228,9 @@ std::vector<cos_lib::point_xy_greyscale> cos_lib::cloud_manip::cloud_to_2d_greys
         throw cos_lib::except::invalid_cloud_pointer();
 
     std::vector<cos_lib::point_xy_greyscale> greyscale_points;
-    std::vector<float> z_coords = cos_lib::cloud_manip::cloud_z_coords(cloud_ptr);
-    float z_min = *(std::min_element(z_coords.begin(), z_coords.end()));
-    float z_max = *(std::max_element(z_coords.begin(), z_coords.end()));
+    cos_lib::cloud_manip::cloud_bounds bounds = cos_lib::cloud_manip::compute_bounds(*cloud_ptr);
+    float z_min = bounds.z_min;
+    float z_max = bounds.z_max;
 
     for (auto cloud_it = cloud_ptr->begin(); cloud_it < cloud_ptr->end(); cloud_it++)
     {
@@ -253,9 +274,9 @@ std::vector<cos_lib::point_xy_mixed> cos_lib::cloud_manip::cloud_to_2d_mixed(pcl
         throw cos_lib::except::invalid_cloud_pointer();
 
     std::vector<cos_lib::point_xy_mixed> mixed_points;
-    std::vector<float> z_coords = cos_lib::cloud_manip::cloud_z_coords(cloud_ptr);
-    float z_min = *(std::min_element(z_coords.begin(), z_coords.end()));
-    float z_max = *(std::max_element(z_coords.begin(), z_coords.end()));
+    cos_lib::cloud_manip::cloud_bounds bounds = cos_lib::cloud_manip::compute_bounds(*cloud_ptr);
+    float z_min = bounds.z_min;
+    float z_max = bounds.z_max;
 
     for (auto cloud_it = cloud_ptr->begin(); cloud_it < cloud_ptr->end(); cloud_it++)
     {
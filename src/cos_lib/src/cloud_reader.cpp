@@ -0,0 +1,278 @@
+#include "../include/cloud_reader.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    /** @brief block_size is the number of characters read at once from text files */
+    const size_t block_size = 1 << 22;
+
+    /** @brief header_size is the number of bytes read at the beginning of a file to find its format or its .pcd header */
+    const size_t header_size = 1 << 16;
+
+    void set_batch_size(pcl::PointCloud<pcl::PointXYZRGB>& batch)
+    {
+        batch.width = batch.points.size();
+        batch.height = 1;
+    }
+}
+
+cos_lib::io::cloud_reader::cloud_reader(size_t batch_size)
+{
+    if (batch_size == 0)
+        throw std::invalid_argument("The batch size must be strictly positive.");
+
+    this->batch_size = batch_size;
+}
+
+cos_lib::io::text_block_reader::text_block_reader(std::istream& file, size_t block_size) : file(file)
+{
+    this->block_size = block_size;
+    this->tail_begin = 0;
+    this->tail_end = 0;
+}
+
+bool cos_lib::io::text_block_reader::next(const char*& begin, const char*& end)
+{
+    // the beginning of the line cut by the previous block is moved to the front
+    size_t filled = this->tail_end - this->tail_begin;
+
+    if (filled > 0)
+        std::memmove(this->buffer.data(), this->buffer.data() + this->tail_begin, filled);
+    this->tail_begin = this->tail_end = 0;
+
+    while (true)
+    {
+        if (this->buffer.size() < filled + this->block_size)
+            this->buffer.resize(filled + this->block_size);
+
+        this->file.read(this->buffer.data() + filled, this->block_size);
+        size_t nb_read = (size_t)this->file.gcount();
+
+        if (this->file.bad())
+            throw cos_lib::except::invalid_path();
+
+        filled += nb_read;
+
+        if (nb_read == 0)
+        {
+            begin = this->buffer.data();
+            end = begin + filled;
+            return filled > 0;
+        }
+
+        // the block ends after the last '\n' read, a line longer than a block making it grow
+        size_t last_newline = filled;
+
+        while (last_newline > filled - nb_read && this->buffer[last_newline - 1] != '\n')
+            last_newline--;
+
+        if (last_newline > filled - nb_read)
+        {
+            begin = this->buffer.data();
+            end = begin + last_newline;
+            this->tail_begin = last_newline;
+            this->tail_end = filled;
+            return true;
+        }
+    }
+}
+
+cos_lib::io::txt_cloud_reader::txt_cloud_reader(std::string path, size_t batch_size)
+    : cloud_reader(batch_size), file(path, std::ios::in | std::ios::binary), blocks(file, block_size)
+{
+    if (!this->file.is_open())
+        throw cos_lib::except::invalid_path();
+
+    this->pending_begin = 0;
+}
+
+bool cos_lib::io::txt_cloud_reader::read(pcl::PointCloud<pcl::PointXYZRGB>& batch)
+{
+    batch.points.clear();
+
+    while (batch.points.size() < this->batch_size)
+    {
+        if (!this->pending || this->pending_begin == this->pending->points.size())
+        {
+            const char* begin;
+            const char* end;
+
+            if (!this->blocks.next(begin, end))
+                break;
+
+            this->pending = cos_lib::io::parse_cloud_txt(begin, end);
+            this->pending_begin = 0;
+            continue;
+        }
+
+        size_t nb_taken = std::min(this->batch_size - batch.points.size(), this->pending->points.size() - this->pending_begin);
+        auto first = this->pending->points.begin() + this->pending_begin;
+
+        batch.points.insert(batch.points.end(), first, first + nb_taken);
+        this->pending_begin += nb_taken;
+    }
+
+    set_batch_size(batch);
+
+    return !batch.points.empty();
+}
+
+cos_lib::io::pcd_cloud_reader::pcd_cloud_reader(std::string path, size_t batch_size)
+    : cloud_reader(batch_size), file(path, std::ios::in | std::ios::binary)
+{
+    if (!this->file.is_open())
+        throw cos_lib::except::invalid_path();
+
+    std::vector<char> head(header_size);
+
+    this->file.read(head.data(), head.size());
+    this->header = cos_lib::io::parse_pcd_header(head.data(), head.data() + this->file.gcount());
+
+    if (this->header.data == cos_lib::io::pcd_header::binary_compressed)
+        throw cos_lib::except::invalid_path();
+
+    this->file.clear();
+    this->file.seekg(this->header.data_offset);
+
+    this->nb_points_read = 0;
+    this->line = this->block_end = nullptr;
+
+    if (this->header.data == cos_lib::io::pcd_header::ascii)
+        this->blocks.reset(new cos_lib::io::text_block_reader(this->file, block_size));
+}
+
+bool cos_lib::io::pcd_cloud_reader::read(pcl::PointCloud<pcl::PointXYZRGB>& batch)
+{
+    size_t nb_points = std::min(this->batch_size, this->header.nb_points - this->nb_points_read);
+
+    batch.points.clear();
+
+    if (this->header.data == cos_lib::io::pcd_header::binary)
+    {
+        this->buffer.resize(nb_points * this->header.point_step);
+        this->file.read(this->buffer.data(), this->buffer.size());
+
+        if ((size_t)this->file.gcount() != this->buffer.size())
+            throw cos_lib::except::invalid_path();
+
+        batch.points.resize(nb_points);
+
+        #pragma omp parallel for schedule(static)
+        for (long i = 0; i < (long)nb_points; i++)
+            cos_lib::io::decode_pcd_point(this->header, this->buffer.data() + i * this->header.point_step, batch.points[i]);
+    }
+
+    else
+    {
+        while (batch.points.size() < nb_points)
+        {
+            if (this->line == this->block_end)
+            {
+                // the file holds less lines than announced by its header
+                if (!this->blocks->next(this->line, this->block_end))
+                    throw cos_lib::except::invalid_path();
+            }
+
+            const char* eol = (const char*)std::memchr(this->line, '\n', this->block_end - this->line);
+            const char* line_end = eol ? eol : this->block_end;
+            const char* first = this->line;
+
+            this->line = eol ? eol + 1 : this->block_end;
+
+            while (first < line_end && (*first == ' ' || *first == '\t' || *first == '\r'))
+                first++;
+
+            if (first == line_end)
+                continue;
+
+            pcl::PointXYZRGB point;
+
+            if (!cos_lib::io::parse_pcd_line(this->header, first, line_end, point))
+                throw cos_lib::except::invalid_path();
+
+            batch.points.push_back(point);
+        }
+    }
+
+    this->nb_points_read += nb_points;
+    set_batch_size(batch);
+
+    return nb_points > 0;
+}
+
+cos_lib::io::binary_cloud_reader::binary_cloud_reader(std::string path, size_t batch_size)
+    : cloud_reader(batch_size), view(path)
+{
+    this->chunk = 0;
+    this->chunk_position = 0;
+}
+
+bool cos_lib::io::binary_cloud_reader::read(pcl::PointCloud<pcl::PointXYZRGB>& batch)
+{
+    batch.points.clear();
+
+    while (batch.points.size() < this->batch_size && this->chunk < this->view.getNbChunks())
+    {
+        cos_lib::io::binary_cloud_chunk columns = this->view.getChunk(this->chunk);
+        size_t first = this->chunk_position;
+        size_t nb_taken = std::min(this->batch_size - batch.points.size(), columns.nb_points - first);
+        size_t offset = batch.points.size();
+
+        batch.points.resize(offset + nb_taken);
+
+        for (size_t i = 0; i < nb_taken; i++)
+        {
+            pcl::PointXYZRGB& point = batch.points[offset + i];
+            uint32_t rgb = columns.rgb[first + i];
+
+            point.x = columns.x[first + i];
+            point.y = columns.y[first + i];
+            point.z = columns.z[first + i];
+            point.r = (uint8_t)(rgb >> 16);
+            point.g = (uint8_t)(rgb >> 8);
+            point.b = (uint8_t)rgb;
+        }
+
+        this->chunk_position += nb_taken;
+
+        if (this->chunk_position == columns.nb_points)
+        {
+            this->chunk++;
+            this->chunk_position = 0;
+        }
+    }
+
+    set_batch_size(batch);
+
+    return !batch.points.empty();
+}
+
+std::unique_ptr<cos_lib::io::cloud_reader> cos_lib::io::open_cloud_reader(std::string path, size_t batch_size)
+{
+    // the format is detected from the first bytes of the file, whatever its extension
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+
+    if (!file.is_open())
+        throw cos_lib::except::invalid_path();
+
+    std::vector<char> head(header_size);
+    file.read(head.data(), head.size());
+    file.close();
+
+    switch (cos_lib::io::detect_cloud_format(head.data(), head.data() + file.gcount()))
+    {
+    case cos_lib::io::cloud_format::txt:
+        return std::unique_ptr<cos_lib::io::cloud_reader>(new cos_lib::io::txt_cloud_reader(path, batch_size));
+
+    case cos_lib::io::cloud_format::pcd:
+        return std::unique_ptr<cos_lib::io::cloud_reader>(new cos_lib::io::pcd_cloud_reader(path, batch_size));
+
+    case cos_lib::io::cloud_format::cosc:
+        return std::unique_ptr<cos_lib::io::cloud_reader>(new cos_lib::io::binary_cloud_reader(path, batch_size));
+
+    default:
+        throw cos_lib::except::invalid_path();
+    }
+}
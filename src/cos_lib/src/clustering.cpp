@@ -1,181 +1,255 @@
-/* Author : Kévin Naudin
- * Version : 1.0
- * Made for the I3 Mainz laboratory under GPL license
- */
-
-#include "../include/clustering.h"
-
-// Initializes static variables
-std::map<std::string, pcl::PointCloud<cos_lib::point_clstr>::Ptr> cos_lib::clustering::coloured_clouds_map;
-std::vector<cos_lib::point_clstr*> cos_lib::clustering::neighboursNotYetPushed;
-
-std::vector<pcl::PointCloud<pcl::PointXYZRGB>::Ptr> cos_lib::clustering::getClustersFromColouredCloud(pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud, double neighbours_radius, bool isWidop, size_t min_cluster_size)
-{
-    // If widop file, rescale to usable coordinates
-    if(isWidop) cos_lib::cloud_manip::scale_cloud(cloud, 1, 100, 1);
-
-    // Vector storing the clusters
-    std::vector<pcl::PointCloud<pcl::PointXYZRGB>::Ptr> returned_clusters;
-
-    // This algorithm works only with Cluster Points
-    pcl::PointCloud<cos_lib::point_clstr>::Ptr base_cloud (new pcl::PointCloud<cos_lib::point_clstr>);
-    cos_lib::cloud_manip::convertXYZRGBToClstr(cloud, base_cloud);
-
-    // Frees memory by deleting the unused cloud
-    cloud->points.clear();
-    cloud->points.shrink_to_fit();
-    cloud = nullptr;
-
-    // Creates as many fragmented cloud as there are colours
-    cos_lib::clustering::sortPointsByColor(base_cloud);
-    base_cloud->points.clear();
-    base_cloud->points.shrink_to_fit();
-    base_cloud = nullptr;
-
-    std::cout << coloured_clouds_map.size() << " colours found." << std::endl;
-
-    // We will go through the entire map to get each unicoloured cloud as there are and as many points as they contain
-    std::map<std::string, pcl::PointCloud<cos_lib::point_clstr>::Ptr>::iterator map_iterator;
-    pcl::PointCloud<cos_lib::point_clstr>::iterator cloud_iterator;
-    int colour_counter = 0;
-    int count_clusters = 0;
-
-    std::vector<cos_lib::point_clstr*> neighboursToSee;
-    std::vector<cos_lib::point_clstr*> useless_vector;
-    std::vector<cos_lib::point_clstr*> resultingNeighbours;
-    size_t i;
-
-    for(map_iterator=coloured_clouds_map.begin(); map_iterator!=coloured_clouds_map.end(); map_iterator++)
-    {
-        colour_counter++;
-        if(map_iterator->first != "000" &&  map_iterator->first !="00200")
-        {
-            std::cout << "Analizing coloured cloud number " << colour_counter << std::endl;
-            std::cout << "Hint : This coloured cloud contains " << (map_iterator->second)->size() << " points" << std::endl;
-            // As we need a kdtree to know our points neighbours but the vector it creates take a lot of memory, we will in advance tell our points who are their neighbours
-            cos_lib::clustering::setNeighbourhoodForPoints(map_iterator->second, neighbours_radius);
-
-            // Now we need to create the clusters for this unicoloured cloud
-            for(cloud_iterator=(map_iterator->second)->begin(); cloud_iterator!=(map_iterator->second)->end(); cloud_iterator++)
-            {
-                if(!(*cloud_iterator).getVisited())
-                {
-                    // Deallocates memory used by the vector
-                    neighboursToSee.clear();
-                    neighboursToSee.shrink_to_fit();
-
-                    pcl::PointCloud<cos_lib::point_clstr>::Ptr new_cluster (new pcl::PointCloud<cos_lib::point_clstr>);
-                    new_cluster->push_back(*cloud_iterator);
-
-                    neighboursToSee.push_back(&(*cloud_iterator));
-                    i = 0;
-                    while(i < neighboursToSee.size())
-                    {
-                        resultingNeighbours.clear();
-                        resultingNeighbours.shrink_to_fit();
-                        resultingNeighbours = cos_lib::clustering::addNeighboursIntoCluster(neighboursToSee[i], new_cluster);
-                        std::merge(useless_vector.begin(), useless_vector.end(), resultingNeighbours.begin(), resultingNeighbours.end(), std::back_inserter(neighboursToSee));
-                        i++;
-                    }
-                    if(new_cluster->size() >= min_cluster_size)
-                    {
-                        count_clusters++;
-                        std::cout << "Cluster added because it contains " << new_cluster->size() << " points" << std::endl;
-                        pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud_xyzrgb (new pcl::PointCloud<pcl::PointXYZRGB>);
-                        cos_lib::cloud_manip::convertClstrToXYZRGB(new_cluster, cloud_xyzrgb);
-                        new_cluster->points.clear();
-                        new_cluster->points.shrink_to_fit();
-                        new_cluster = nullptr;
-                        cos_lib::cloud_manip::scale_cloud(cloud_xyzrgb, 1, ((float)1/(float)100), 1);
-                        returned_clusters.push_back(cloud_xyzrgb);
-                    }
-                    else
-                    {
-                        new_cluster->points.clear();
-                        new_cluster->points.shrink_to_fit();
-                        new_cluster = nullptr;
-                    }
-                }
-            }
-        }
-        (map_iterator->second)->points.clear();
-        (map_iterator->second)->points.shrink_to_fit();
-        coloured_clouds_map.erase(map_iterator);
-    }
-    return returned_clusters;
-}
-
-void cos_lib::clustering::sortPointsByColor(pcl::PointCloud<cos_lib::point_clstr>::Ptr base_cloud)
-{
-    pcl::PointCloud<cos_lib::point_clstr>::iterator cloud_iterator;
-    std::map<std::string, pcl::PointCloud<cos_lib::point_clstr>::Ptr>::iterator map_iterator;
-    // Strings are less memory eating than floats
-    std::string point_color;
-
-    for(cloud_iterator=base_cloud->begin(); cloud_iterator!=base_cloud->end(); cloud_iterator++)
-    {
-        point_color = std::to_string((int)(*cloud_iterator).r) + std::to_string((int)(*cloud_iterator).g) + std::to_string((int)(*cloud_iterator).b);
-        map_iterator=coloured_clouds_map.find(point_color);
-        // If the colour has already been seen in the map we basically had the point to the pre-existing coloured cloud
-        if(map_iterator != coloured_clouds_map.end())
-        {
-            (map_iterator->second)->push_back(*cloud_iterator);
-        }
-        // If the colour has never been seen we create a new cloud for this colour
-        else
-        {
-            pcl::PointCloud<cos_lib::point_clstr>::Ptr unicoloured_cloud (new pcl::PointCloud<cos_lib::point_clstr>);
-            unicoloured_cloud->push_back(*cloud_iterator);
-            coloured_clouds_map[point_color] = unicoloured_cloud;
-        }
-    }
-}
-
-void cos_lib::clustering::setNeighbourhoodForPoints(pcl::PointCloud<cos_lib::point_clstr>::Ptr unicoloured_cloud, double neighbours_radius)
-{
-    pcl::PointCloud<cos_lib::point_clstr>::iterator cloud_iterator;
-
-    pcl::KdTreeFLANN<cos_lib::point_clstr> kdtree;
-    kdtree.setInputCloud(unicoloured_cloud);
-
-    std::vector<int> PointsID; // Contains the neighbours indices
-    std::vector<float> PointsDist; // Only needed by the KDTree for the radius search
-
-    for(cloud_iterator=unicoloured_cloud->begin(); cloud_iterator!=unicoloured_cloud->end(); cloud_iterator++)
-    {
-        // Checks if the point has at least one neighbour except itself
-        if(kdtree.radiusSearch(*cloud_iterator, neighbours_radius, PointsID, PointsDist) >= 1)
-        {
-            for(size_t i = 1; i<PointsID.size(); i++)
-            {
-                (*cloud_iterator).addNeighbour(&(unicoloured_cloud->points[PointsID[i]]));
-            }
-        }
-        PointsID.clear();
-        PointsID.shrink_to_fit();
-        PointsDist.clear();
-        PointsDist.shrink_to_fit();
-    }
-    kdtree = nullptr;
-}
-
-std::vector<cos_lib::point_clstr*> cos_lib::clustering::addNeighboursIntoCluster(cos_lib::point_clstr* point_ptr, pcl::PointCloud<cos_lib::point_clstr>::Ptr cluster)
-{
-    neighboursNotYetPushed.clear();
-    neighboursNotYetPushed.shrink_to_fit();
-    std::list<cos_lib::point_clstr*>::iterator nghbr_it;
-
-    point_ptr->setVisited(true);
-    for(nghbr_it=point_ptr->getIteratorOnFirstNeighbour(); nghbr_it!=point_ptr->getIteratorOnLastNeighbour(); nghbr_it++)
-    {
-        if(!(*nghbr_it)->getAdded())
-        {
-            (*nghbr_it)->setAdded(true);
-            cluster->push_back(**nghbr_it);
-            neighboursNotYetPushed.push_back(*nghbr_it);
-        }
-    }
-    point_ptr->clearNeighbours();
-
-    return neighboursNotYetPushed;
-}
+/* Author : Kévin Naudin
+ * Version : 1.0
+ * Made for the I3 Mainz laboratory under GPL license
+ */
+
+#include "../include/clustering.h"
+
+cos_lib::clustering::clustering(double neighbours_radius, bool isWidop, size_t min_cluster_size, method clustering_method)
+{
+    this->neighbours_radius = neighbours_radius;
+    // Widop clouds are much flatter along y, the points are as if they were 100 times further apart on this axis
+    if(isWidop) this->setScale(1, 100, 1);
+    else this->setScale(1, 1, 1);
+    this->min_cluster_size = min_cluster_size;
+    this->clustering_method = clustering_method;
+
+    // Black and 0,0,200 are not clustered by default
+    this->ignored_colours.insert(0x000000);
+    this->ignored_colours.insert(0x0000C8);
+}
+
+std::vector<pcl::PointCloud<pcl::PointXYZRGB>::Ptr> cos_lib::clustering::getClustersFromColouredCloud(pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud, double neighbours_radius, bool isWidop, size_t min_cluster_size, method clustering_method)
+{
+    cos_lib::clustering engine(neighbours_radius, isWidop, min_cluster_size, clustering_method);
+    return engine.getClusters(cloud);
+}
+
+void cos_lib::clustering::setScale(float x_scale, float y_scale, float z_scale)
+{
+    if(!(x_scale > 0) || !(y_scale > 0) || !(z_scale > 0))
+        throw std::invalid_argument("The scales of the distance must be strictly positive.");
+
+    this->scale[0] = x_scale;
+    this->scale[1] = y_scale;
+    this->scale[2] = z_scale;
+}
+
+std::vector<pcl::PointCloud<pcl::PointXYZRGB>::Ptr> cos_lib::clustering::getClusters(pcl::PointCloud<pcl::PointXYZRGB>::ConstPtr cloud) const
+{
+    // Vector storing the clusters
+    std::vector<pcl::PointCloud<pcl::PointXYZRGB>::Ptr> returned_clusters;
+
+    // The colours are finished in any order, so the clusters are kept by colour to be returned by increasing colour
+    std::map<uint32_t, std::vector<pcl::PointCloud<pcl::PointXYZRGB>::Ptr>> clusters_per_colour;
+
+    this->streamClusters(cloud, [&cloud, &clusters_per_colour](uint32_t colour, const uint32_t* indices_begin, const uint32_t* indices_end)
+    {
+        clusters_per_colour[colour].push_back(cos_lib::clustering::convertCluster(cloud, indices_begin, indices_end));
+    });
+
+    for(std::map<uint32_t, std::vector<pcl::PointCloud<pcl::PointXYZRGB>::Ptr>>::iterator colour_it = clusters_per_colour.begin(); colour_it != clusters_per_colour.end(); colour_it++)
+    {
+        returned_clusters.insert(returned_clusters.end(), colour_it->second.begin(), colour_it->second.end());
+        colour_it->second.clear();
+    }
+
+    std::cout << returned_clusters.size() << " clusters found." << std::endl;
+    return returned_clusters;
+}
+
+void cos_lib::clustering::streamClusters(pcl::PointCloud<pcl::PointXYZRGB>::ConstPtr cloud, const cluster_sink& sink) const
+{
+    // Each colour gets a range of point indices, the points themselves stay where they are
+    cos_lib::colour_buckets buckets;
+    buckets.build(cloud);
+
+    std::cout << buckets.getNbColours() << " colours found." << std::endl;
+
+    std::vector<size_t> analysed_colours;
+    for(size_t bucket = 0; bucket < buckets.getNbColours(); bucket++)
+    {
+        if(this->ignored_colours.count(buckets.getColour(bucket)) == 0)
+            analysed_colours.push_back(bucket);
+    }
+
+    // The threads hand their clusters over one at a time, so the sink does not have to be thread safe. Once a colour failed,
+    // the clusters of the colours still being analysed are dropped
+    std::mutex sink_mutex;
+    std::atomic<bool> failed(false);
+    cluster_sink locked_sink = [&sink, &sink_mutex, &failed](uint32_t colour, const uint32_t* indices_begin, const uint32_t* indices_end)
+    {
+        std::lock_guard<std::mutex> lock(sink_mutex);
+        if(!failed)
+            sink(colour, indices_begin, indices_end);
+    };
+
+    if(this->clustering_method == UNION_FIND)
+    {
+        // The threads share each colour, so the colours are simply taken one after the other
+        for(size_t i = 0; i < analysed_colours.size(); i++)
+            this->streamClustersByUnionFind(cloud, buckets.getColour(analysed_colours[i]), buckets.bucketBegin(analysed_colours[i]), buckets.bucketEnd(analysed_colours[i]), locked_sink);
+    }
+    else
+    {
+        // The biggest colours are analysed first so that one huge colour does not end up alone at the end of the run
+        std::vector<size_t> schedule(analysed_colours);
+        std::stable_sort(schedule.begin(), schedule.end(), [&buckets](size_t a, size_t b)
+        {
+            return buckets.getBucketSize(a) > buckets.getBucketSize(b);
+        });
+
+        // Each thread takes the next colour as soon as it is done with its previous one. An exception cannot leave the parallel loop,
+        // so it is kept with its colour, the colours left are skipped and the first one is thrown again after the loop
+        std::vector<std::exception_ptr> errors(schedule.size());
+
+        #pragma omp parallel for schedule(dynamic, 1)
+        for(long i = 0; i < (long)schedule.size(); i++)
+        {
+            if(failed)
+                continue;
+
+            try
+            {
+                this->streamClustersFromUnicolouredCloud(cloud, buckets.getColour(schedule[i]), buckets.bucketBegin(schedule[i]), buckets.bucketEnd(schedule[i]), locked_sink);
+            }
+            catch(...)
+            {
+                errors[i] = std::current_exception();
+                failed = true;
+            }
+        }
+
+        for(size_t i = 0; i < errors.size(); i++)
+        {
+            if(errors[i])
+                std::rethrow_exception(errors[i]);
+        }
+    }
+    buckets.clear();
+}
+
+void cos_lib::clustering::streamClustersFromUnicolouredCloud(pcl::PointCloud<pcl::PointXYZRGB>::ConstPtr cloud, uint32_t colour, const uint32_t* indices_begin, const uint32_t* indices_end, const cluster_sink& sink) const
+{
+    size_t nb_points = indices_end - indices_begin;
+    cos_lib::voxel_hash_index index(this->neighbours_radius);
+    cos_lib::neighbour_graph graph;
+    std::vector<bool> added(nb_points, false);
+    std::vector<uint32_t> cluster_positions;
+
+    #pragma omp critical(clustering_log)
+    std::cout << "Analizing a coloured cloud of " << nb_points << " points" << std::endl;
+
+    // As the radius never changes, a voxel hash with cells of that size finds the neighbours by scanning 27 cells, which we will in advance store in a flat graph
+    index.setScale(this->scale[0], this->scale[1], this->scale[2]);
+    index.build(cloud, indices_begin, indices_end);
+    graph.build(index, this->neighbours_radius);
+
+    // Now we need to create the clusters for this colour
+    for(size_t seed_position = 0; seed_position < nb_points; seed_position++)
+    {
+        if(!added[seed_position])
+        {
+            cos_lib::clustering::growCluster(seed_position, graph, added, cluster_positions);
+            if(cluster_positions.size() >= this->min_cluster_size)
+            {
+                // The positions are turned into indices in the cloud in place
+                for(size_t i = 0; i < cluster_positions.size(); i++)
+                    cluster_positions[i] = indices_begin[cluster_positions[i]];
+                sink(colour, cluster_positions.data(), cluster_positions.data() + cluster_positions.size());
+            }
+        }
+    }
+    graph.clear();
+}
+
+void cos_lib::clustering::streamClustersByUnionFind(pcl::PointCloud<pcl::PointXYZRGB>::ConstPtr cloud, uint32_t colour, const uint32_t* indices_begin, const uint32_t* indices_end, const cluster_sink& sink) const
+{
+    size_t nb_points = indices_end - indices_begin;
+    std::vector<uint32_t> roots(nb_points);
+
+    std::cout << "Analizing a coloured cloud of " << nb_points << " points" << std::endl;
+
+    {
+        cos_lib::disjoint_set sets(nb_points);
+        cos_lib::voxel_hash_index index(this->neighbours_radius);
+        index.setScale(this->scale[0], this->scale[1], this->scale[2]);
+        index.build(cloud, indices_begin, indices_end);
+
+        #pragma omp parallel
+        {
+            std::vector<uint32_t> PointsID; // Contains the neighbours indices
+            std::vector<float> PointsDist; // Only needed by the index for the radius search
+
+            // Each neighbourhood is forgotten as soon as its points have been joined
+            #pragma omp for schedule(dynamic, 1024)
+            for(long i = 0; i < (long)nb_points; i++)
+            {
+                index.radiusSearch(index.getPoint(i), this->neighbours_radius, PointsID, PointsDist, 0);
+                for(size_t j = 0; j < PointsID.size(); j++)
+                {
+                    // Neighbourhoods are symmetric, so each pair only needs to be joined once
+                    if(PointsID[j] > (uint32_t)i)
+                        sets.unite((uint32_t)i, (uint32_t)PointsID[j]);
+                }
+            }
+
+            #pragma omp for schedule(static)
+            for(long i = 0; i < (long)nb_points; i++)
+                roots[i] = sets.find((uint32_t)i);
+        }
+    }
+
+    // The representative of a cluster is its smallest position, which is also where region growing would have started it
+    std::vector<uint32_t> cluster_offsets(nb_points + 1, 0);
+    for(size_t i = 0; i < nb_points; i++)
+        cluster_offsets[roots[i] + 1]++;
+    for(size_t i = 0; i < nb_points; i++)
+        cluster_offsets[i + 1] += cluster_offsets[i];
+
+    // The clusters are written directly as indices in the cloud
+    std::vector<uint32_t> cluster_indices(nb_points);
+    std::vector<uint32_t> cluster_fill(cluster_offsets.begin(), cluster_offsets.end() - 1);
+    for(size_t i = 0; i < nb_points; i++)
+        cluster_indices[cluster_fill[roots[i]]++] = indices_begin[i];
+    cluster_fill.clear();
+    cluster_fill.shrink_to_fit();
+
+    for(size_t root = 0; root < nb_points; root++)
+    {
+        size_t cluster_size = cluster_offsets[root + 1] - cluster_offsets[root];
+        if(cluster_size > 0 && cluster_size >= this->min_cluster_size)
+            sink(colour, cluster_indices.data() + cluster_offsets[root], cluster_indices.data() + cluster_offsets[root + 1]);
+    }
+}
+
+pcl::PointCloud<pcl::PointXYZRGB>::Ptr cos_lib::clustering::convertCluster(pcl::PointCloud<pcl::PointXYZRGB>::ConstPtr cloud, const uint32_t* indices_begin, const uint32_t* indices_end)
+{
+    pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud_xyzrgb (new pcl::PointCloud<pcl::PointXYZRGB>);
+    cloud_xyzrgb->resize(indices_end - indices_begin);
+    for(size_t i = 0; i < cloud_xyzrgb->points.size(); i++)
+        cloud_xyzrgb->points[i] = cloud->points[indices_begin[i]];
+    cloud_xyzrgb->width = cloud_xyzrgb->points.size();
+    cloud_xyzrgb->height = 1;
+    return cloud_xyzrgb;
+}
+
+void cos_lib::clustering::growCluster(size_t seed_index, const cos_lib::neighbour_graph& graph, std::vector<bool>& added, std::vector<uint32_t>& cluster_indices)
+{
+    // The indices vector is both the cluster and the queue of the points which neighbours are yet to be seen
+    cluster_indices.clear();
+    cluster_indices.push_back((uint32_t)seed_index);
+    added[seed_index] = true;
+
+    for(size_t i = 0; i < cluster_indices.size(); i++)
+    {
+        for(const uint32_t* nghbr_it = graph.neighboursBegin(cluster_indices[i]); nghbr_it != graph.neighboursEnd(cluster_indices[i]); nghbr_it++)
+        {
+            if(!added[*nghbr_it])
+            {
+                added[*nghbr_it] = true;
+                cluster_indices.push_back(*nghbr_it);
+            }
+        }
+    }
+}
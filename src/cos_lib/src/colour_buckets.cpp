@@ -0,0 +1,240 @@
+#include "../include/colour_buckets.h"
+
+#include <cstdio>
+
+cos_lib::colour_buckets::colour_buckets()
+{
+
+}
+
+void cos_lib::colour_buckets::build(pcl::PointCloud<pcl::PointXYZRGB>::ConstPtr cloud)
+{
+    this->clear();
+
+    size_t nb_points = cloud->size();
+    std::vector<uint32_t> keys(nb_points);
+    std::vector<uint32_t> sorted_keys(nb_points);
+    std::vector<uint32_t> sorted_indices(nb_points);
+    this->indices.resize(nb_points);
+
+    #pragma omp parallel for schedule(static)
+    for(long i = 0; i < (long)nb_points; i++)
+    {
+        keys[i] = cos_lib::colour_buckets::packColour(cloud->points[i]);
+        this->indices[i] = (uint32_t)i;
+    }
+
+    // 24 bits colours are sorted in two passes of 12 bits, the lowest bits first
+    cos_lib::colour_buckets::radixPass(keys, this->indices, sorted_keys, sorted_indices, 0);
+    cos_lib::colour_buckets::radixPass(sorted_keys, sorted_indices, keys, this->indices, 12);
+    sorted_keys.clear();
+    sorted_keys.shrink_to_fit();
+    sorted_indices.clear();
+    sorted_indices.shrink_to_fit();
+
+    // A new bucket starts each time the colour changes
+    for(size_t i = 0; i < nb_points; i++)
+    {
+        if(i == 0 || keys[i] != keys[i - 1])
+        {
+            this->colours.push_back(keys[i]);
+            this->offsets.push_back(i);
+        }
+    }
+    this->offsets.push_back(nb_points);
+}
+
+void cos_lib::colour_buckets::clear()
+{
+    this->colours.clear();
+    this->colours.shrink_to_fit();
+    this->offsets.clear();
+    this->offsets.shrink_to_fit();
+    this->indices.clear();
+    this->indices.shrink_to_fit();
+}
+
+void cos_lib::colour_buckets::radixPass(const std::vector<uint32_t>& keys_in, const std::vector<uint32_t>& indices_in,
+                                        std::vector<uint32_t>& keys_out, std::vector<uint32_t>& indices_out, unsigned int shift)
+{
+    const size_t nb_radix = 4096;
+    const size_t chunk_size = 65536;
+    size_t nb_points = keys_in.size();
+
+    // The cloud is cut into at most 64 chunks, each chunk being counted then scattered by one thread
+    size_t nb_chunks = std::min((size_t)64, std::max((size_t)1, nb_points / chunk_size));
+    size_t points_per_chunk = (nb_points + nb_chunks - 1) / nb_chunks;
+    std::vector<size_t> positions(nb_chunks * nb_radix, 0);
+
+    #pragma omp parallel for schedule(static)
+    for(long chunk = 0; chunk < (long)nb_chunks; chunk++)
+    {
+        size_t* chunk_counts = positions.data() + chunk * nb_radix;
+        size_t end = std::min(nb_points, (chunk + 1) * points_per_chunk);
+        for(size_t i = chunk * points_per_chunk; i < end; i++)
+            chunk_counts[(keys_in[i] >> shift) & (nb_radix - 1)]++;
+    }
+
+    // Each chunk writes a digit after the previous digits and after the same digit of the previous chunks, which keeps the sort stable
+    size_t position = 0;
+    for(size_t digit = 0; digit < nb_radix; digit++)
+    {
+        for(size_t chunk = 0; chunk < nb_chunks; chunk++)
+        {
+            size_t count = positions[chunk * nb_radix + digit];
+            positions[chunk * nb_radix + digit] = position;
+            position += count;
+        }
+    }
+
+    #pragma omp parallel for schedule(static)
+    for(long chunk = 0; chunk < (long)nb_chunks; chunk++)
+    {
+        size_t* chunk_positions = positions.data() + chunk * nb_radix;
+        size_t end = std::min(nb_points, (chunk + 1) * points_per_chunk);
+        for(size_t i = chunk * points_per_chunk; i < end; i++)
+        {
+            size_t destination = chunk_positions[(keys_in[i] >> shift) & (nb_radix - 1)]++;
+            keys_out[destination] = keys_in[i];
+            indices_out[destination] = indices_in[i];
+        }
+    }
+}
+
+cos_lib::colour_bucket_stream::colour_bucket_stream(std::string spill_path, size_t max_buffered_points)
+{
+    this->spill_path = spill_path;
+    this->spill.open(spill_path, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+
+    if(!this->spill.is_open())
+        throw cos_lib::except::invalid_path();
+
+    this->spill_size = 0;
+    this->max_buffered_points = std::max((size_t)1, max_buffered_points);
+    this->nb_buffered_points = 0;
+    this->nb_points = 0;
+}
+
+cos_lib::colour_bucket_stream::~colour_bucket_stream()
+{
+    this->spill.close();
+    std::remove(this->spill_path.c_str());
+}
+
+void cos_lib::colour_bucket_stream::add(const pcl::PointCloud<pcl::PointXYZRGB>& batch)
+{
+    // Neighbour points often share their colour, so the last bucket is kept to avoid most of the lookups
+    uint32_t last_colour = 0;
+    cos_lib::colour_bucket_stream::bucket* last_bucket = nullptr;
+
+    for(size_t i = 0; i < batch.points.size(); i++)
+    {
+        const pcl::PointXYZRGB& point = batch.points[i];
+        uint32_t colour = cos_lib::colour_buckets::packColour(point);
+
+        if(!last_bucket || colour != last_colour)
+        {
+            last_bucket = &this->buckets[colour];
+            last_colour = colour;
+        }
+
+        last_bucket->buffer.push_back(point.x);
+        last_bucket->buffer.push_back(point.y);
+        last_bucket->buffer.push_back(point.z);
+        last_bucket->nb_points++;
+        this->nb_points++;
+
+        if(++this->nb_buffered_points >= this->max_buffered_points)
+        {
+            this->flush();
+            last_bucket = nullptr;
+        }
+    }
+}
+
+std::vector<uint32_t> cos_lib::colour_bucket_stream::getColours() const
+{
+    std::vector<uint32_t> colours;
+    colours.reserve(this->buckets.size());
+
+    for(auto it = this->buckets.begin(); it != this->buckets.end(); it++)
+        colours.push_back(it->first);
+
+    return colours;
+}
+
+size_t cos_lib::colour_bucket_stream::getBucketSize(uint32_t colour) const
+{
+    auto it = this->buckets.find(colour);
+    return (it == this->buckets.end()) ? 0 : it->second.nb_points;
+}
+
+pcl::PointCloud<pcl::PointXYZRGB>::Ptr cos_lib::colour_bucket_stream::loadBucket(uint32_t colour)
+{
+    pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud(new pcl::PointCloud<pcl::PointXYZRGB>);
+    auto it = this->buckets.find(colour);
+
+    if(it == this->buckets.end())
+        return cloud;
+
+    const cos_lib::colour_bucket_stream::bucket& bucket = it->second;
+    std::vector<float> coordinates(bucket.nb_points * 3);
+    size_t position = 0;
+
+    // The spilled segments come first, then the points still buffered
+    for(size_t i = 0; i < bucket.segments.size(); i++)
+    {
+        this->spill.seekg(bucket.segments[i].offset);
+        this->spill.read((char*)(coordinates.data() + position), bucket.segments[i].nb_points * 3 * sizeof(float));
+
+        if(!this->spill)
+            throw cos_lib::except::invalid_path();
+
+        position += bucket.segments[i].nb_points * 3;
+    }
+    std::copy(bucket.buffer.begin(), bucket.buffer.end(), coordinates.begin() + position);
+
+    cloud->resize(bucket.nb_points);
+    cloud->width = bucket.nb_points;
+    cloud->height = 1;
+
+    for(size_t i = 0; i < bucket.nb_points; i++)
+    {
+        pcl::PointXYZRGB& point = cloud->points[i];
+        point.x = coordinates[3 * i];
+        point.y = coordinates[3 * i + 1];
+        point.z = coordinates[3 * i + 2];
+        point.r = (uint8_t)(colour >> 16);
+        point.g = (uint8_t)(colour >> 8);
+        point.b = (uint8_t)colour;
+    }
+
+    return cloud;
+}
+
+void cos_lib::colour_bucket_stream::flush()
+{
+    this->spill.seekp(this->spill_size);
+
+    for(auto it = this->buckets.begin(); it != this->buckets.end(); it++)
+    {
+        std::vector<float>& buffer = it->second.buffer;
+        if(buffer.empty())
+            continue;
+
+        cos_lib::colour_bucket_stream::segment spilled;
+        spilled.offset = this->spill_size;
+        spilled.nb_points = buffer.size() / 3;
+        this->spill.write((const char*)buffer.data(), buffer.size() * sizeof(float));
+        this->spill_size += buffer.size() * sizeof(float);
+        it->second.segments.push_back(spilled);
+
+        buffer.clear();
+        buffer.shrink_to_fit();
+    }
+
+    if(!this->spill)
+        throw cos_lib::except::invalid_path();
+
+    this->nb_buffered_points = 0;
+}
@@ -0,0 +1,96 @@
+#include "../include/colour_quantizer.h"
+
+namespace
+{
+    /**
+     * @brief max_local_cells Largest histogram each thread counts on its own, bigger ones being shared between the threads
+     */
+    const size_t max_local_cells = 1 << 16;
+}
+
+cos_lib::colour_quantizer::colour_quantizer(short epsilon)
+{
+    if(epsilon == 0)
+        throw std::invalid_argument("Epsilon cannot be 0 for cloud homogenization.");
+
+    // value / epsilon * epsilon is value / |epsilon| * |epsilon| and never goes over the value, so no channel ever needs to be clamped to 255
+    this->step = (size_t)(epsilon < 0 ? -(int)epsilon : (int)epsilon);
+
+    for(size_t value = 0; value < 256; value++)
+    {
+        uint32_t quantized = (uint32_t)(value / this->step * this->step);
+
+        this->red[value] = quantized << 16;
+        this->green[value] = quantized << 8;
+        this->blue[value] = quantized;
+        this->levels[value] = (uint32_t)(value / this->step);
+    }
+
+    this->nb_levels = this->levels[255] + 1;
+}
+
+void cos_lib::colour_quantizer::apply(pcl::PointCloud<pcl::PointXYZRGB>& batch) const
+{
+    pcl::PointXYZRGB* points = batch.points.data();
+
+    #pragma omp parallel for schedule(static)
+    for(long i = 0; i < (long)batch.points.size(); i++)
+        points[i].rgba = this->quantize(points[i].rgba);
+}
+
+void cos_lib::colour_quantizer::apply(pcl::PointCloud<pcl::PointXYZRGB>& batch, cos_lib::colour_histogram& histogram) const
+{
+    if(batch.points.size() > UINT32_MAX)
+        throw std::invalid_argument("The batch holds too many points for its histogram.");
+
+    pcl::PointXYZRGB* points = batch.points.data();
+    const size_t nb_cells = this->nb_levels * this->nb_levels * this->nb_levels;
+    const bool local_counts = (nb_cells <= max_local_cells);
+    std::vector<uint32_t> counts(nb_cells, 0);
+
+    // Small histograms are counted by each thread then summed, bigger ones are counted together with atomic increments
+    #pragma omp parallel
+    {
+        std::vector<uint32_t> thread_counts(local_counts ? nb_cells : 0, 0);
+
+        #pragma omp for schedule(static)
+        for(long i = 0; i < (long)batch.points.size(); i++)
+        {
+            uint32_t rgba = points[i].rgba;
+            size_t cell = ((size_t)this->levels[(rgba >> 16) & 0xFF] * this->nb_levels + this->levels[(rgba >> 8) & 0xFF]) * this->nb_levels + this->levels[rgba & 0xFF];
+
+            points[i].rgba = this->quantize(rgba);
+
+            if(local_counts)
+                thread_counts[cell]++;
+            else
+            {
+                #pragma omp atomic
+                counts[cell]++;
+            }
+        }
+
+        if(local_counts)
+        {
+            #pragma omp critical
+            for(size_t cell = 0; cell < nb_cells; cell++)
+                counts[cell] += thread_counts[cell];
+        }
+    }
+
+    // The cells are ordered by red, green then blue level, which is the order of the packed colours
+    histogram.colours.clear();
+    histogram.counts.clear();
+    for(size_t cell = 0; cell < nb_cells; cell++)
+    {
+        if(counts[cell] == 0)
+            continue;
+
+        uint32_t red_level = (uint32_t)(cell / (this->nb_levels * this->nb_levels));
+        uint32_t green_level = (uint32_t)(cell / this->nb_levels % this->nb_levels);
+        uint32_t blue_level = (uint32_t)(cell % this->nb_levels);
+
+        histogram.colours.push_back((red_level * this->step) << 16 | (green_level * this->step) << 8 | (blue_level * this->step));
+        histogram.counts.push_back(counts[cell]);
+    }
+}
@@ -0,0 +1,40 @@
+#include "../include/disjoint_set.h"
+
+cos_lib::disjoint_set::disjoint_set(size_t nb_elements) : parents(nb_elements)
+{
+    for(size_t i = 0; i < nb_elements; i++)
+        this->parents[i].store((uint32_t)i, std::memory_order_relaxed);
+}
+
+uint32_t cos_lib::disjoint_set::find(uint32_t element)
+{
+    uint32_t parent = this->parents[element].load(std::memory_order_relaxed);
+    while(parent != element)
+    {
+        // Path halving : the element is moved under its grand parent, which is harmless if another thread got there first
+        uint32_t grand_parent = this->parents[parent].load(std::memory_order_relaxed);
+        if(grand_parent != parent)
+            this->parents[element].compare_exchange_weak(parent, grand_parent, std::memory_order_relaxed);
+        element = grand_parent;
+        parent = this->parents[element].load(std::memory_order_relaxed);
+    }
+    return element;
+}
+
+void cos_lib::disjoint_set::unite(uint32_t element_a, uint32_t element_b)
+{
+    while(true)
+    {
+        element_a = this->find(element_a);
+        element_b = this->find(element_b);
+        if(element_a == element_b)
+            return;
+
+        // The biggest root goes under the smallest one, the link only succeeds if it still is a root
+        if(element_a < element_b)
+            std::swap(element_a, element_b);
+        uint32_t expected = element_a;
+        if(this->parents[element_a].compare_exchange_strong(expected, element_b, std::memory_order_acq_rel))
+            return;
+    }
+}
@@ -1,28 +1,15 @@
 #include "../include/image_greyscale.h"
 
-cos_lib::image_greyscale::image_greyscale(size_t width, size_t height) : image(width, height)
+cos_lib::image_greyscale::image_greyscale(size_t width, size_t height) : image(width, height), _pixels(width, height)
 {
-    _pixels.resize(height);
-
-    for (size_t i = 0; i < _pixels.size(); i++)
-        _pixels[i].resize(width);
-}
-
-unsigned short cos_lib::image_greyscale::get_grey_at(size_t y, size_t x) const
-{
-    return this->_pixels[y][x];
 }
 
-void cos_lib::image_greyscale::set_grey_at(size_t y, size_t x, unsigned short grey)
+cos_lib::image_greyscale::image_greyscale(cos_lib::pixel_buffer<unsigned short> pixels)
+    : image(pixels.width(), pixels.height()), _pixels(std::move(pixels))
 {
-    this->_pixels[y][x] = grey;
 }
 
 void cos_lib::image_greyscale::init()
 {
-    for (size_t y = 0; y < this->height(); y++)
-    {
-        for (size_t x = 0; x < this->width(); x++)
-            this->set_grey_at(y, x, 0);
-    }
+    this->_pixels.fill(0);
 }
@@ -1,5 +1,43 @@
 #include "../include/image_processing.h"
 
+namespace
+{
+    /**
+     * @brief read_view wraps a constant plane into a cv::Mat header without copying its pixels
+     * @details OpenCV has no read-only Mat, so these views are only handed to OpenCV functions as inputs
+     */
+    cv::Mat read_view(const cos_lib::pixel_buffer<unsigned short>& plane)
+    {
+        return cv::Mat((int)plane.height(), (int)plane.width(), CV_16UC1, (void*)plane.data(), plane.step());
+    }
+
+    cv::Mat read_view(const cos_lib::pixel_buffer<uint32_t>& plane)
+    {
+        return cv::Mat((int)plane.height(), (int)plane.width(), CV_8UC4, (void*)plane.data(), plane.step());
+    }
+
+    /**
+     * @brief has_null_alpha tells whether the fourth channel of a CV_8UC4 Mat is 0 everywhere,
+     * so that its pixels read as 0x00RRGGBB
+     */
+    bool has_null_alpha(const cv::Mat& bgra_mat)
+    {
+        for (int y = 0; y < bgra_mat.rows; y++)
+        {
+            const unsigned char* bgra_row = bgra_mat.ptr<unsigned char>(y);
+            unsigned char alpha = 0;
+
+            for (int x = 0; x < bgra_mat.cols; x++)
+                alpha |= bgra_row[4 * x + 3];
+
+            if (alpha)
+                return false;
+        }
+
+        return true;
+    }
+}
+
 std::vector<float> cos_lib::img_proc::greyscale_vector_x_coords(
         std::vector<cos_lib::point_xy_greyscale> greyscale_vector)
 {
@@ -71,11 +109,10 @@ std::vector<unsigned short> cos_lib::img_proc::greyscale_image_values(
 {
     std::vector<unsigned short> greyscale_values;
 
+    greyscale_values.reserve(gs_img.resolution());
+
     for (size_t y = 0; y < gs_img.height(); y++)
-    {
-        for (size_t x = 0; x < gs_img.width(); x++)
-            greyscale_values.push_back(gs_img.get_grey_at(y, x));
-    }
+        greyscale_values.insert(greyscale_values.end(), gs_img.row(y), gs_img.row(y) + gs_img.width());
 
     return greyscale_values;
 }
@@ -111,162 +148,378 @@ cos_lib::image_mixed cos_lib::img_proc::mixed_vector_to_image(
 }
 
 cos_lib::image_rgb cos_lib::img_proc::mixed_image_to_rgb(
-        cos_lib::image_mixed mixed_img)
+        const cos_lib::image_mixed& mixed_img)
 {
     cos_lib::image_rgb rgb_img(mixed_img.width(), mixed_img.height());
 
-    for (size_t y = 0; y < mixed_img.height(); y++)
-    {
-        for (size_t x = 0; x < mixed_img.width(); x++)
-            rgb_img.set_rgb_at(y, x, mixed_img.get_rgb_at(y, x));
-    }
+    rgb_img.pixels() = mixed_img.rgb_plane();
 
     return rgb_img;
 }
 
 cos_lib::image_greyscale cos_lib::img_proc::mixed_image_to_greyscale(
-        cos_lib::image_mixed mixed_img)
+        const cos_lib::image_mixed& mixed_img)
 {
     cos_lib::image_greyscale gs_img(mixed_img.width(), mixed_img.height());
 
-    for (size_t y = 0; y < mixed_img.height(); y++)
-    {
-        for (size_t x = 0; x < mixed_img.width(); x++)
-            gs_img.set_grey_at(y, x, mixed_img.get_grey_at(y, x));
-    }
+    gs_img.pixels() = mixed_img.grey_plane();
 
     return gs_img;
 }
 
-cos_lib::image_greyscale cos_lib::img_proc::cloud_to_depth_image(
-        pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud_ptr, size_t width, size_t height)
+const uint32_t cos_lib::img_proc::cloud_raster::empty_pixel;
+
+cos_lib::img_proc::cloud_raster::cloud_raster(size_t width, size_t height)
+    : image(width, height), point_indices(width, height)
 {
-    std::vector<cos_lib::point_xy_mixed> mixed_pt_arr;
+}
 
-    mixed_pt_arr = cos_lib::cloud_manip::cloud_to_2d_mixed(cloud_ptr);
-    cos_lib::image_mixed mixed_img = cos_lib::img_proc::mixed_vector_to_image(mixed_pt_arr,
-                                                                              width, height);
-    cos_lib::image_greyscale gs_img = cos_lib::img_proc::mixed_image_to_greyscale(mixed_img);
+bool cos_lib::img_proc::cloud_raster::pixel_of(const pcl::PointXYZRGB& point, size_t& x, size_t& y) const
+{
+    float image_x = cos_lib::aux::map(point.x, this->bounds.x_min, this->bounds.x_max, 0, (this->image.width() - 1));
+    float image_y = cos_lib::aux::map(point.y, this->bounds.y_min, this->bounds.y_max, 0, (this->image.height() - 1));
 
-    return gs_img;
+    // also rejects the coordinates that are not a number
+    if (!(image_x >= 0 && image_x < this->image.width() && image_y >= 0 && image_y < this->image.height()))
+        return false;
+
+    x = (size_t)image_x;
+    y = (size_t)image_y;
+
+    return true;
 }
 
-pcl::PointCloud<pcl::PointXYZRGB>::Ptr cos_lib::img_proc::mixed_image_to_cloud(
-        cos_lib::image_mixed mixed_img,
-        pcl::PointCloud<pcl::PointXYZRGB>::Ptr base_cloud_ptr)
+cos_lib::img_proc::cloud_raster cos_lib::img_proc::cloud_to_raster(
+        pcl::PointCloud<pcl::PointXYZRGB>::ConstPtr cloud_ptr, size_t width, size_t height)
 {
-    if (!base_cloud_ptr)
+    if (!cloud_ptr)
         throw cos_lib::except::invalid_cloud_pointer();
 
+    if (width == 0 || height == 0)
+        throw std::invalid_argument("The image must hold at least one pixel.");
+
+    // the largest index is kept for the empty pixels
+    if (cloud_ptr->points.size() >= cos_lib::img_proc::cloud_raster::empty_pixel)
+        throw std::invalid_argument("The cloud holds too many points to be rasterized.");
+
+    const pcl::PointXYZRGB* points = cloud_ptr->points.data();
+    const long nb_points = (long)cloud_ptr->points.size();
+    const long nb_pixels = (long)(width * height);
+    cos_lib::img_proc::cloud_raster raster(width, height);
+
+    raster.bounds = cos_lib::cloud_manip::compute_bounds(*cloud_ptr);
+
+    // a key holds the grey value of a point in its 32 high bits and the complement of its index in its 32 low bits,
+    // so that the largest key drawn on a pixel is the one of its highest point, the first of the cloud on ties
+    std::unique_ptr<std::atomic<uint64_t>[]> keys(new std::atomic<uint64_t>[nb_pixels]);
+
+    #pragma omp parallel
+    {
+        #pragma omp for schedule(static)
+        for (long pixel = 0; pixel < nb_pixels; pixel++)
+            keys[pixel].store(0, std::memory_order_relaxed);
+
+        #pragma omp for schedule(static)
+        for (long i = 0; i < nb_points; i++)
+        {
+            const pcl::PointXYZRGB& point = points[i];
+            unsigned short greyscale = (unsigned short)cos_lib::aux::map(point.z, raster.bounds.z_min, raster.bounds.z_max,
+                                                                         0.0, 255.0);
+            size_t image_x, image_y;
+
+            // a pixel starts with a null grey value which only a higher point replaces, points out of the image are not drawn
+            if (greyscale == 0 || !raster.pixel_of(point, image_x, image_y))
+                continue;
+
+            uint64_t key = ((uint64_t)greyscale << 32) | (uint32_t)~(uint32_t)i;
+            std::atomic<uint64_t>& pixel_key = keys[image_y * width + image_x];
+            uint64_t current = pixel_key.load(std::memory_order_relaxed);
+
+            while (current < key && !pixel_key.compare_exchange_weak(current, key, std::memory_order_relaxed))
+                ;
+        }
+
+        #pragma omp for schedule(static)
+        for (long y = 0; y < (long)height; y++)
+        {
+            unsigned short* grey_row = raster.image.grey_row(y);
+            uint32_t* rgb_row = raster.image.rgb_row(y);
+            uint32_t* index_row = raster.point_indices.row(y);
+
+            for (size_t x = 0; x < width; x++)
+            {
+                uint64_t key = keys[y * width + x].load(std::memory_order_relaxed);
+
+                if (key == 0)
+                {
+                    grey_row[x] = 0;
+                    rgb_row[x] = 0;
+                    index_row[x] = cos_lib::img_proc::cloud_raster::empty_pixel;
+                    continue;
+                }
+
+                uint32_t index = ~(uint32_t)key;
+                const pcl::PointXYZRGB& point = points[index];
+
+                grey_row[x] = (unsigned short)(key >> 32);
+                rgb_row[x] = ((uint32_t)point.r << 16) | ((uint32_t)point.g << 8) | (uint32_t)point.b;
+                index_row[x] = index;
+            }
+        }
+    }
+
+    return raster;
+}
+
+cos_lib::image_mixed cos_lib::img_proc::cloud_to_mixed_image(
+        pcl::PointCloud<pcl::PointXYZRGB>::ConstPtr cloud_ptr, size_t width, size_t height)
+{
+    return std::move(cos_lib::img_proc::cloud_to_raster(cloud_ptr, width, height).image);
+}
+
+pcl::PointCloud<pcl::PointXYZRGB>::Ptr cos_lib::img_proc::raster_to_cloud(const cos_lib::img_proc::cloud_raster& raster)
+{
     pcl::PointCloud<pcl::PointXYZRGB>::Ptr res_cloud_ptr(new pcl::PointCloud<pcl::PointXYZRGB>);
+    const cos_lib::image_mixed& mixed_img = raster.image;
+    const cos_lib::cloud_manip::cloud_bounds& bounds = raster.bounds;
+    const long height = (long)mixed_img.height();
+    const size_t width = mixed_img.width();
 
-    std::vector<float> x_coords = cos_lib::cloud_manip::cloud_x_coords(base_cloud_ptr);
-    std::vector<float> y_coords = cos_lib::cloud_manip::cloud_y_coords(base_cloud_ptr);
-    std::vector<float> z_coords = cos_lib::cloud_manip::cloud_z_coords(base_cloud_ptr);
+    // the points of a row are written after the ones of the rows above it, which are counted first
+    std::vector<size_t> row_offsets(height + 1, 0);
 
-    // min and max coordinates for the map function
-    float x_min = *(std::min_element(x_coords.begin(), x_coords.end()));
-    float x_max = *(std::max_element(x_coords.begin(), x_coords.end()));
-    float y_min = *(std::min_element(y_coords.begin(), y_coords.end()));
-    float y_max = *(std::max_element(y_coords.begin(), y_coords.end()));
-    float z_min = *(std::min_element(z_coords.begin(), z_coords.end()));
-    float z_max = *(std::max_element(z_coords.begin(), z_coords.end()));
+    #pragma omp parallel for schedule(static)
+    for (long y = 0; y < height; y++)
+    {
+        const uint32_t* index_row = raster.point_indices.row(y);
+        size_t nb_drawn = 0;
 
-    for (size_t y = 0; y < mixed_img.height(); y++)
+        for (size_t x = 0; x < width; x++)
+            nb_drawn += (index_row[x] != cos_lib::img_proc::cloud_raster::empty_pixel);
+
+        row_offsets[y + 1] = nb_drawn;
+    }
+
+    for (long y = 0; y < height; y++)
+        row_offsets[y + 1] += row_offsets[y];
+
+    res_cloud_ptr->points.resize(row_offsets[height]);
+
+    #pragma omp parallel for schedule(static)
+    for (long y = 0; y < height; y++)
     {
-        pcl::PointXYZRGB current_point;
-        float cloud_y = cos_lib::aux::map(y, 0, mixed_img.height() - 1, y_min, y_max);
+        const uint32_t* index_row = raster.point_indices.row(y);
+        const unsigned short* grey_row = mixed_img.grey_row(y);
+        const uint32_t* rgb_row = mixed_img.rgb_row(y);
+        pcl::PointXYZRGB* current_point = &res_cloud_ptr->points[row_offsets[y]];
+        float cloud_y = cos_lib::aux::map(y, 0, height - 1, bounds.y_min, bounds.y_max);
 
-        for (size_t x = 0; x < mixed_img.width(); x++)
+        for (size_t x = 0; x < width; x++)
         {
-            float cloud_x = cos_lib::aux::map(x, 0, mixed_img.width() - 1, x_min, x_max);
-            float cloud_z = cos_lib::aux::map(mixed_img.get_grey_at(y, x), 0, 255, z_min, z_max);
-
-            current_point.x = cloud_x;
-            current_point.y = cloud_y;
-            current_point.z = cloud_z;
-            current_point.r = (float)mixed_img.get_red_at(y, x);
-            current_point.g = (float)mixed_img.get_green_at(y, x);
-            current_point.b = (float)mixed_img.get_blue_at(y, x);
-            res_cloud_ptr->push_back(current_point);
+            if (index_row[x] == cos_lib::img_proc::cloud_raster::empty_pixel)
+                continue;
+
+            current_point->x = cos_lib::aux::map(x, 0, width - 1, bounds.x_min, bounds.x_max);
+            current_point->y = cloud_y;
+            current_point->z = cos_lib::aux::map(grey_row[x], 0, 255, bounds.z_min, bounds.z_max);
+            current_point->r = (uint8_t)(rgb_row[x] >> 16);
+            current_point->g = (uint8_t)(rgb_row[x] >> 8);
+            current_point->b = (uint8_t)rgb_row[x];
+            current_point++;
         }
     }
 
+    res_cloud_ptr->width = res_cloud_ptr->points.size();
+    res_cloud_ptr->height = 1;
+
     return res_cloud_ptr;
 }
 
-cv::Mat cos_lib::img_proc::greyscale_image_to_mat(cos_lib::image_greyscale gs_img)
+pcl::PointCloud<pcl::PointXYZRGB>::Ptr cos_lib::img_proc::select_points(
+        const cos_lib::img_proc::cloud_raster& raster, pcl::PointCloud<pcl::PointXYZRGB>::ConstPtr cloud_ptr,
+        const cos_lib::image_greyscale& mask)
 {
-    cv::Mat greyscale_mat(gs_img.height(), gs_img.width(), CV_8UC1);
+    if (!cloud_ptr)
+        throw cos_lib::except::invalid_cloud_pointer();
 
-    for (size_t y = 0; y < gs_img.height(); y++)
+    if (mask.width() != raster.image.width() || mask.height() != raster.image.height())
+        throw std::invalid_argument("The mask must be of the size of the raster.");
+
+    const auto& points = cloud_ptr->points;
+    std::vector<uint8_t> selected(points.size());
+    pcl::PointCloud<pcl::PointXYZRGB>::Ptr res_cloud_ptr(new pcl::PointCloud<pcl::PointXYZRGB>);
+
+    #pragma omp parallel for schedule(static)
+    for (long i = 0; i < (long)points.size(); i++)
+    {
+        size_t x, y;
+
+        selected[i] = raster.pixel_of(points[i], x, y) && mask.get_grey_at(y, x) != 0;
+    }
+
+    for (size_t i = 0; i < points.size(); i++)
     {
-        for (size_t x = 0; x < gs_img.width(); x++)
-            greyscale_mat.at<uchar>(y, x) = gs_img.get_grey_at(y, x);
+        if (selected[i])
+            res_cloud_ptr->points.push_back(points[i]);
     }
 
-    return greyscale_mat;
+    res_cloud_ptr->width = res_cloud_ptr->points.size();
+    res_cloud_ptr->height = 1;
+
+    return res_cloud_ptr;
 }
 
-cv::Mat cos_lib::img_proc::rgb_image_to_mat(cos_lib::image_rgb rgb_img)
+cos_lib::image_greyscale cos_lib::img_proc::cloud_to_depth_image(
+        pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud_ptr, size_t width, size_t height)
+{
+    cos_lib::image_mixed mixed_img = cos_lib::img_proc::cloud_to_mixed_image(cloud_ptr, width, height);
+
+    return cos_lib::image_greyscale(std::move(mixed_img.grey_plane()));
+}
+
+pcl::PointCloud<pcl::PointXYZRGB>::Ptr cos_lib::img_proc::mixed_image_to_cloud(
+        const cos_lib::image_mixed& mixed_img,
+        pcl::PointCloud<pcl::PointXYZRGB>::Ptr base_cloud_ptr)
 {
-    cv::Mat rgb_mat(rgb_img.height(), rgb_img.width(), CV_8UC3);
+    if (!base_cloud_ptr)
+        throw cos_lib::except::invalid_cloud_pointer();
+
+    pcl::PointCloud<pcl::PointXYZRGB>::Ptr res_cloud_ptr(new pcl::PointCloud<pcl::PointXYZRGB>);
+
+    // min and max coordinates for the map function
+    const cos_lib::cloud_manip::cloud_bounds bounds = cos_lib::cloud_manip::compute_bounds(*base_cloud_ptr);
+    const size_t width = mixed_img.width();
+
+    res_cloud_ptr->points.resize(mixed_img.resolution());
 
-    for (size_t y = 0; y < rgb_img.height(); y++)
+    #pragma omp parallel for schedule(static)
+    for (long y = 0; y < (long)mixed_img.height(); y++)
     {
-        for (size_t x = 0; x < rgb_img.width(); x++)
+        pcl::PointXYZRGB* current_point = &res_cloud_ptr->points[y * width];
+        const unsigned short* grey_row = mixed_img.grey_row(y);
+        const uint32_t* rgb_row = mixed_img.rgb_row(y);
+        float cloud_y = cos_lib::aux::map(y, 0, mixed_img.height() - 1, bounds.y_min, bounds.y_max);
+
+        for (size_t x = 0; x < width; x++, current_point++)
         {
-            rgb_mat.at<cv::Vec3b>(y, x)[0] = rgb_img.get_red_at(y, x);
-            rgb_mat.at<cv::Vec3b>(y, x)[1] = rgb_img.get_green_at(y, x);
-            rgb_mat.at<cv::Vec3b>(y, x)[2] = rgb_img.get_blue_at(y, x);
+            current_point->x = cos_lib::aux::map(x, 0, width - 1, bounds.x_min, bounds.x_max);
+            current_point->y = cloud_y;
+            current_point->z = cos_lib::aux::map(grey_row[x], 0, 255, bounds.z_min, bounds.z_max);
+            current_point->r = (uint8_t)(rgb_row[x] >> 16);
+            current_point->g = (uint8_t)(rgb_row[x] >> 8);
+            current_point->b = (uint8_t)rgb_row[x];
         }
     }
 
+    res_cloud_ptr->width = res_cloud_ptr->points.size();
+    res_cloud_ptr->height = 1;
+
+    return res_cloud_ptr;
+}
+
+cv::Mat cos_lib::img_proc::greyscale_image_to_mat(const cos_lib::image_greyscale& gs_img)
+{
+    cv::Mat greyscale_mat;
+
+    read_view(gs_img.pixels()).convertTo(greyscale_mat, CV_8U);
+
+    return greyscale_mat;
+}
+
+cv::Mat cos_lib::img_proc::rgb_image_to_mat(const cos_lib::image_rgb& rgb_img)
+{
+    cv::Mat rgb_mat;
+
+    cv::cvtColor(read_view(rgb_img.pixels()), rgb_mat, cv::COLOR_BGRA2RGB);
+
     return rgb_mat;
 }
 
-cos_lib::image_greyscale cos_lib::img_proc::mat_to_greyscale_image(cv::Mat gs_mat)
+cv::Mat cos_lib::img_proc::mat_view(cos_lib::pixel_buffer<unsigned short>& plane)
 {
-    cos_lib::image_greyscale gs_img(gs_mat.cols, gs_mat.rows);
+    return cv::Mat((int)plane.height(), (int)plane.width(), CV_16UC1, plane.data(), plane.step());
+}
 
-    gs_img.init();
+cv::Mat cos_lib::img_proc::mat_view(cos_lib::pixel_buffer<uint32_t>& plane)
+{
+    return cv::Mat((int)plane.height(), (int)plane.width(), CV_8UC4, plane.data(), plane.step());
+}
 
-    for (size_t y = 0; y < gs_img.height(); y++)
+cos_lib::image_greyscale cos_lib::img_proc::mat_to_greyscale_image(cv::Mat gs_mat)
+{
+    if (gs_mat.type() == CV_16UC1 && gs_mat.step[0] % sizeof(unsigned short) == 0)
     {
-        for (size_t x = 0; x < gs_img.width(); x++)
-            gs_img.set_grey_at(y, x, (unsigned short)gs_mat.at<uchar>(y, x));
+        // the copy of the Mat held by the image keeps its reference count up
+        std::shared_ptr<void> owner = std::make_shared<cv::Mat>(gs_mat);
+
+        return cos_lib::image_greyscale(cos_lib::pixel_buffer<unsigned short>(gs_mat.cols, gs_mat.rows,
+                                                                              gs_mat.step[0] / sizeof(unsigned short),
+                                                                              (unsigned short*)gs_mat.data, owner));
     }
 
+    if (gs_mat.type() != CV_8UC1 && gs_mat.type() != CV_16UC1)
+        throw std::invalid_argument("The grey scale Mat must be of type CV_8UC1 or CV_16UC1.");
+
+    cos_lib::image_greyscale gs_img(gs_mat.cols, gs_mat.rows);
+    cv::Mat gs_view = cos_lib::img_proc::mat_view(gs_img.pixels());
+
+    gs_mat.convertTo(gs_view, CV_16U);
+
     return gs_img;
 }
 
 cos_lib::image_rgb cos_lib::img_proc::mat_to_rgb_image(cv::Mat rgb_mat)
 {
-    /// TO-DO
-    throw std::runtime_error("Not yet implemented.");
+    if (rgb_mat.type() == CV_8UC4 && rgb_mat.step[0] % sizeof(uint32_t) == 0 && has_null_alpha(rgb_mat))
+    {
+        std::shared_ptr<void> owner = std::make_shared<cv::Mat>(rgb_mat);
+
+        return cos_lib::image_rgb(cos_lib::pixel_buffer<uint32_t>(rgb_mat.cols, rgb_mat.rows,
+                                                                  rgb_mat.step[0] / sizeof(uint32_t),
+                                                                  (uint32_t*)rgb_mat.data, owner));
+    }
+
+    if (rgb_mat.type() != CV_8UC3 && rgb_mat.type() != CV_8UC4)
+        throw std::invalid_argument("The rgb Mat must be of type CV_8UC3 or CV_8UC4.");
+
+    cos_lib::image_rgb rgb_img(rgb_mat.cols, rgb_mat.rows);
+    cv::Mat rgb_view = cos_lib::img_proc::mat_view(rgb_img.pixels());
+
+    // red, green and blue are moved to the bytes of 0x00RRGGBB, the last one being set to 0
+    if (rgb_mat.channels() == 3)
+    {
+        const int from_to[] = { 0, 2, 1, 1, 2, 0, -1, 3 };
+        cv::mixChannels(&rgb_mat, 1, &rgb_view, 1, from_to, 4);
+    }
+
+    else
+    {
+        const int from_to[] = { 0, 0, 1, 1, 2, 2, -1, 3 };
+        cv::mixChannels(&rgb_mat, 1, &rgb_view, 1, from_to, 4);
+    }
+
+    return rgb_img;
 }
 
 cos_lib::image_greyscale cos_lib::img_proc::detect_contours(
-        cos_lib::image_greyscale gs_img, int hist_num_cls)
+        const cos_lib::image_greyscale& gs_img, int hist_num_cls)
 {
-    cv::Mat gs_mat; // gs_img as a cv::Mat object
+    const cv::Mat gs_mat = read_view(gs_img.pixels());   // gs_img as a cv::Mat object
     int channels[] = {0};
+    float grey_range[] = {0, 256};
+    const float* ranges[] = {grey_range};
     cv::Mat hist;   // histogram of gs_mat
-    cv::Mat eq_hist;
     cv::Mat grad_x, grad_y;
     cv::Mat abs_grad_x, abs_grad_y;
-    cv::Mat grad;
     cos_lib::image_greyscale img_cont(gs_img.width(), gs_img.height());   // contours of the parameter image
+    cv::Mat grad = cos_lib::img_proc::mat_view(img_cont.pixels());
 
-    gs_mat = cos_lib::img_proc::greyscale_image_to_mat(gs_img);
-    cv::calcHist(&gs_mat, 1, channels, cv::Mat(), hist, 1, &hist_num_cls, 0);
-    cv::equalizeHist(gs_mat, eq_hist);
+    cv::calcHist(&gs_mat, 1, channels, cv::Mat(), hist, 1, &hist_num_cls, ranges);
     cv::Sobel(gs_mat, grad_x, CV_64F, 1, 0, 3);
     cv::convertScaleAbs(grad_x, abs_grad_x);
     cv::Sobel(gs_mat, grad_y, CV_64F, 0, 1, 3);
     cv::convertScaleAbs(grad_y, abs_grad_y);
-    cv::addWeighted(abs_grad_x, 0.5, abs_grad_y, 0.5, 0, grad);
-    img_cont = cos_lib::img_proc::mat_to_greyscale_image(grad);
+    cv::addWeighted(abs_grad_x, 0.5, abs_grad_y, 0.5, 0, grad, CV_16U);
 
     return img_cont;
 }
@@ -276,13 +529,14 @@ void cos_lib::img_proc::remove_colors(cos_lib::image_mixed &mixed_img,
 {
     for (size_t y = 0; y < mixed_img.height(); y++)
     {
-        for (size_t x = 0; x < mixed_img.width(); x++)
+        uint32_t* rgb_row = mixed_img.rgb_row(y);
+
+        for (auto color_it = colors.begin(); color_it < colors.end(); color_it++)
         {
-            for (auto color_it = colors.begin(); color_it < colors.end(); color_it++)
-            {
-                if (mixed_img.get_rgb_at(y, x) == (*color_it))
-                    mixed_img.set_rgb_at(y, x, 0);
-            }
+            const uint32_t color = *color_it;
+
+            for (size_t x = 0; x < mixed_img.width(); x++)
+                rgb_row[x] = (rgb_row[x] == color) ? 0 : rgb_row[x];
         }
     }
 }
@@ -296,14 +550,13 @@ void cos_lib::img_proc::normalize(cos_lib::image_greyscale *gs_img_ptr)
     unsigned short min_gs_val = *(std::min_element(greyscale_values.begin(), greyscale_values.end()));
     unsigned short max_gs_val = *(std::max_element(greyscale_values.begin(), greyscale_values.end()));
 
+    const unsigned short factor = 255 / (max_gs_val - min_gs_val);
+
     for (size_t y = 0; y < gs_img_ptr->height(); y++)
     {
-        for (size_t x = 0; x < gs_img_ptr->width(); x++)
-        {
-            unsigned short normalized_greyscale_val = (255 / (max_gs_val - min_gs_val))
-                                                        * (gs_img_ptr->get_grey_at(y, x) - min_gs_val);
+        unsigned short* grey_row = gs_img_ptr->row(y);
 
-            gs_img_ptr->set_grey_at(y, x, normalized_greyscale_val);
-        }
+        for (size_t x = 0; x < gs_img_ptr->width(); x++)
+            grey_row[x] = factor * (grey_row[x] - min_gs_val);
     }
 }
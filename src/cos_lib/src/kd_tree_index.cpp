@@ -0,0 +1,41 @@
+#include "../include/kd_tree_index.h"
+
+cos_lib::kd_tree_index::kd_tree_index()
+{
+
+}
+
+void cos_lib::kd_tree_index::buildStructure()
+{
+    this->kdtree.setInputCloud(this->coordinates);
+}
+
+size_t cos_lib::kd_tree_index::radiusSearch(const pcl::PointXYZ& query, double radius, std::vector<uint32_t>& positions,
+                                            std::vector<float>& sq_distances, size_t max_neighbours) const
+{
+    std::vector<int> PointsID; // Contains the neighbours indices
+    this->kdtree.radiusSearch(query, radius, PointsID, sq_distances, (unsigned int)max_neighbours);
+    return cos_lib::kd_tree_index::copyResults(PointsID, positions);
+}
+
+size_t cos_lib::kd_tree_index::nearestKSearch(const pcl::PointXYZ& query, size_t k, std::vector<uint32_t>& positions,
+                                              std::vector<float>& sq_distances) const
+{
+    std::vector<int> PointsID; // Contains the neighbours indices
+    if(this->getNbPoints() == 0 || k == 0)
+    {
+        positions.clear();
+        sq_distances.clear();
+        return 0;
+    }
+    this->kdtree.nearestKSearch(query, (int)std::min(k, this->getNbPoints()), PointsID, sq_distances);
+    return cos_lib::kd_tree_index::copyResults(PointsID, positions);
+}
+
+size_t cos_lib::kd_tree_index::copyResults(const std::vector<int>& PointsID, std::vector<uint32_t>& positions)
+{
+    positions.resize(PointsID.size());
+    for(size_t i = 0; i < PointsID.size(); i++)
+        positions[i] = (uint32_t)PointsID[i];
+    return positions.size();
+}
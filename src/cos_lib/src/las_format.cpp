@@ -0,0 +1,101 @@
+#include "../include/las_format.h"
+
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+namespace
+{
+    template<typename T> T read_value(const char* data, size_t offset)
+    {
+        T value;
+        std::memcpy(&value, data + offset, sizeof(T));
+        return value;
+    }
+
+    /** @brief colour_offsets gives, for each point format, the position of its colour in a record, -1 if it has none */
+    const int colour_offsets[11] = { -1, -1, 20, 28, -1, 28, -1, 30, 30, -1, 30 };
+
+    /** @brief minimum_steps gives, for each point format, the minimum size of a record */
+    const size_t minimum_steps[11] = { 20, 28, 26, 34, 57, 63, 30, 36, 38, 59, 67 };
+}
+
+cos_lib::io::las_header cos_lib::io::parse_las_header(const char* begin, const char* end)
+{
+    const size_t file_size = end - begin;
+
+    // the header of the version 1.0 is 227 bytes long, the later versions only append fields
+    if (file_size < 227 || std::memcmp(begin, "LASF", 4) != 0)
+        throw cos_lib::except::invalid_path();
+
+    cos_lib::io::las_header header;
+    uint8_t point_format = read_value<uint8_t>(begin, 104);
+    uint16_t header_size = read_value<uint16_t>(begin, 94);
+
+    header.version_major = read_value<uint8_t>(begin, 24);
+    header.version_minor = read_value<uint8_t>(begin, 25);
+
+    // LASzip marks the compressed files by setting the two highest bits of the point format
+    header.is_compressed = (point_format & 0xC0) != 0;
+    header.point_format = point_format & 0x3F;
+    header.point_step = read_value<uint16_t>(begin, 105);
+    header.nb_points = read_value<uint32_t>(begin, 107);
+    header.data_offset = read_value<uint32_t>(begin, 96);
+
+    // from the version 1.4, the number of points is stored on 64 bits, the 32 bits one being 0 when it is too big
+    if (header.version_major == 1 && header.version_minor >= 4 && header_size >= 255 && file_size >= 255)
+        header.nb_points = (size_t)read_value<uint64_t>(begin, 247);
+
+    for (int axis = 0; axis < 3; axis++)
+    {
+        header.scale[axis] = read_value<double>(begin, 131 + 8 * axis);
+        header.offset[axis] = read_value<double>(begin, 155 + 8 * axis);
+
+        // the bounds are stored as max x, min x, max y, min y, max z, min z
+        const double minimum = read_value<double>(begin, 187 + 16 * axis);
+        header.origin[axis] = std::isfinite(minimum) ? std::floor(minimum) : header.offset[axis];
+        if (!std::isfinite(header.origin[axis]))
+            header.origin[axis] = 0;
+    }
+
+    if (header.point_format > 10 || header.point_step < minimum_steps[header.point_format])
+        throw cos_lib::except::invalid_path();
+
+    header.colour_offset = colour_offsets[header.point_format];
+
+    if (!header.is_compressed
+            && (header.data_offset > file_size || header.nb_points > (file_size - header.data_offset) / header.point_step))
+        throw cos_lib::except::invalid_path();
+
+    return header;
+}
+
+uint16_t cos_lib::io::decode_las_colour_max(const cos_lib::io::las_header& header, const char* record)
+{
+    if (header.colour_offset < 0)
+        return 0;
+
+    uint16_t red = read_value<uint16_t>(record, header.colour_offset);
+    uint16_t green = read_value<uint16_t>(record, header.colour_offset + 2);
+    uint16_t blue = read_value<uint16_t>(record, header.colour_offset + 4);
+
+    return std::max(red, std::max(green, blue));
+}
+
+void cos_lib::io::decode_las_point(const cos_lib::io::las_header& header, const char* record, int colour_shift, pcl::PointXYZRGB& point)
+{
+    // the origin is subtracted in double, before the coordinates lose their precision as floats
+    point.x = (float)(read_value<int32_t>(record, 0) * header.scale[0] + (header.offset[0] - header.origin[0]));
+    point.y = (float)(read_value<int32_t>(record, 4) * header.scale[1] + (header.offset[1] - header.origin[1]));
+    point.z = (float)(read_value<int32_t>(record, 8) * header.scale[2] + (header.offset[2] - header.origin[2]));
+
+    if (header.colour_offset < 0)
+    {
+        point.r = point.g = point.b = 255;
+        return;
+    }
+
+    point.r = (uint8_t)(read_value<uint16_t>(record, header.colour_offset) >> colour_shift);
+    point.g = (uint8_t)(read_value<uint16_t>(record, header.colour_offset + 2) >> colour_shift);
+    point.b = (uint8_t)(read_value<uint16_t>(record, header.colour_offset + 4) >> colour_shift);
+}
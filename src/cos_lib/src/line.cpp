@@ -7,7 +7,7 @@ cos_lib::Line::Line(){
 
 }
 
-cos_lib::Line::Line(std::vector<int> inliers, Eigen::VectorXf* coefficients)
+cos_lib::Line::Line(std::vector<int> inliers, Eigen::VectorXf coefficients)
 {
     this->inliers = inliers;
     this->coefficients = coefficients;
@@ -17,7 +17,7 @@ std::vector<int> cos_lib::Line::getInliers(){
     return this->inliers;
 }
 
-Eigen::VectorXf *cos_lib::Line::getCoefficients(){
+Eigen::VectorXf cos_lib::Line::getCoefficients(){
     return this->coefficients;
 }
 
@@ -29,8 +29,8 @@ std::vector<float> cos_lib::Line::getAnglesToOrigin(){
     Eigen::Vector3f z(0,0,1);
 
     Eigen::Vector3f direction;
-    direction[0] = (*coefficients)[3]; direction[1] = (*coefficients)[4];
-    direction [2] = (*coefficients)[5];
+    direction[0] = coefficients[3]; direction[1] = coefficients[4];
+    direction [2] = coefficients[5];
 
     std::cout << x.dot(y) << std::endl;
     float angleX = acos((x.dot(direction)));
@@ -46,16 +46,16 @@ std::vector<float> cos_lib::Line::getAnglesToOrigin(){
 float cos_lib::Line::angleBetweenLines(Line* l1, Line* l2){
     Eigen::Vector4f point;
 
-    Eigen::VectorXf* coefficients1 = l1->getCoefficients();
+    Eigen::VectorXf coefficients1 = l1->getCoefficients();
 
-    std::cout << (*coefficients1)[3] << std::endl;
-    Eigen::Vector3f direction1((*coefficients1)[3], (*coefficients1)[4], (*coefficients1)[5]);
+    std::cout << coefficients1[3] << std::endl;
+    Eigen::Vector3f direction1(coefficients1[3], coefficients1[4], coefficients1[5]);
 
-    Eigen::VectorXf* coefficients2 = l2->getCoefficients();
-    Eigen::Vector3f direction2((*coefficients2)[3], (*coefficients2)[4], (*coefficients2)[5]);
+    Eigen::VectorXf coefficients2 = l2->getCoefficients();
+    Eigen::Vector3f direction2(coefficients2[3], coefficients2[4], coefficients2[5]);
 
     float angle = 0;
-    if(pcl::lineWithLineIntersection((*coefficients1), (*coefficients2), point)){
+    if(pcl::lineWithLineIntersection(coefficients1, coefficients2, point)){
          angle = acos((direction1.dot(direction2)));
     }
 
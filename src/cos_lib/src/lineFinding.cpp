@@ -1,4 +1,7 @@
 #include "../include/lineFinding.h"
+#include "../include/ransac_engine.h"
+#include "../include/local_ransac.h"
+#include "../include/invalid_cloud_pointer.h"
 
 #include <pcl/common/io.h>
 #include <pcl/common/common.h>
@@ -15,8 +18,102 @@
 #include <pcl/filters/extract_indices.h>
 #include <stdlib.h>
 #include <time.h>
+#include <exception>
 #include <pcl/sample_consensus/rransac.h>
 
+namespace
+{
+    /**
+     * @brief randomColor returns a vector of <R,G,B> ints between 0 & 255 drawn from a generator
+     */
+    std::vector<int> randomColor(cos_lib::sample_generator& generator){
+        uint64_t bits = generator.next();
+
+        std::vector<int> color;
+        color.push_back((int)(bits & 0xFF));
+        color.push_back((int)((bits >> 8) & 0xFF));
+        color.push_back((int)((bits >> 16) & 0xFF));
+
+        return color;
+    }
+
+    /**
+     * @brief extractLines extracts the lines of a cloud, the samples and the colors being drawn from a generator so that several clouds can be
+     * processed by different threads at the same time
+     * @param cloud IN the cloud to look for the lines in
+     * @param distanceThreshold IN distance under which a point belongs to a line
+     * @param pointsPerLine IN minimum number of points of a line
+     * @param generator IN OUT the generator seeding the extraction and drawing the colors
+     * @param lines OUT the lines found are appended to it, their inliers being indices in the cloud
+     * @param colors OUT the color of each line is appended to it
+     */
+    void extractLines(const pcl::PointCloud<pcl::PointXYZRGB>& cloud, double distanceThreshold, int pointsPerLine, cos_lib::sample_generator& generator,
+                      std::vector<cos_lib::Line>& lines, std::vector<std::vector<int> >& colors){
+        cos_lib::point_buffer buffer(cloud, generator.next());
+        cos_lib::line_model model;
+        cos_lib::local_ransac_extractor extractor(buffer, model, distanceThreshold, pointsPerLine, generator.next());
+
+        // lines are extracted until a line of pointsPerLine points is unlikely to be left
+        std::vector<int> inliers = extractor.extractModel();
+        while(!inliers.empty()){
+            lines.push_back(cos_lib::Line(inliers, extractor.getModelCoefficients()));
+            colors.push_back(randomColor(generator));
+            inliers = extractor.extractModel();
+        }
+    }
+
+    /**
+     * @brief writeColoredLines writes colored copies of the inliers of lines in a slice of a cloud, the inliers of the lines becoming the indices
+     * of the copies
+     * @param cloud IN the cloud the inliers come from
+     * @param lines IN OUT the lines
+     * @param colors IN the color of each line
+     * @param colored OUT the cloud the points are written in, big enough to hold them
+     * @param offset IN the index of the first point written
+     */
+    void writeColoredLines(const pcl::PointCloud<pcl::PointXYZRGB>& cloud, std::vector<cos_lib::Line>& lines, const std::vector<std::vector<int> >& colors,
+                           pcl::PointCloud<pcl::PointXYZRGB>& colored, size_t offset){
+        for(uint l=0; l<lines.size(); l++){
+            std::vector<int> inliers = lines[l].getInliers();
+            std::vector<int> written(inliers.size());
+
+            for(uint i=0; i<inliers.size(); i++){
+                pcl::PointXYZRGB& point = colored.points[offset];
+                point = cloud.points[inliers[i]];
+                point.r = colors[l][0];
+                point.g = colors[l][1];
+                point.b = colors[l][2];
+                written[i] = (int)offset++;
+            }
+
+            lines[l] = cos_lib::Line(written, lines[l].getCoefficients());
+        }
+    }
+
+    /**
+     * @brief appendColoredPoints Appends colored copies of a set of points of a cloud to another cloud
+     * @param cloud IN the cloud the points come from
+     * @param inliers IN the indices of the points
+     * @param color IN the ints representing an RGB color
+     * @param colored OUT the cloud the points are appended to
+     */
+    void appendColoredPoints(pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud, const std::vector<int>& inliers, std::vector<int> color,
+                             pcl::PointCloud<pcl::PointXYZRGB>::Ptr colored){
+        size_t offset = colored->points.size();
+
+        colored->points.resize(offset + inliers.size());
+        for(uint i=0; i<inliers.size(); i++){
+            pcl::PointXYZRGB& point = colored->points[offset + i];
+            point = cloud->points[inliers[i]];
+            point.r = color[0];
+            point.g = color[1];
+            point.b = color[2];
+        }
+        colored->width = colored->points.size();
+        colored->height = 1;
+    }
+}
+
 pcl::PointCloud<pcl::PointXYZRGB>::Ptr cos_lib::lineColoring(pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud){
 
     srand(time(NULL));
@@ -57,17 +154,18 @@ pcl::PointCloud<pcl::PointXYZRGB>::Ptr cos_lib::lineColoring(pcl::PointCloud<pcl
 
 cos_lib::Plane*  cos_lib::findBestPlane(pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud, std::vector<int> inliers, Eigen::VectorXf coef){
 
-    pcl::SampleConsensusModelPlane<pcl::PointXYZRGB>::Ptr model (new pcl::SampleConsensusModelPlane<pcl::PointXYZRGB> (cloud));
-    pcl::RandomSampleConsensus<pcl::PointXYZRGB> ransac (model);
-    ransac.setDistanceThreshold(0.01);
-    ransac.computeModel();
-    ransac.getInliers(inliers);
-    ransac.getModelCoefficients(coef);
+    cos_lib::point_buffer buffer(*cloud, rand());
+    cos_lib::plane_model model;
+    cos_lib::ransac_engine ransac(model, 0.01, rand());
+    ransac.setRefinement(true);
+    ransac.computeModel(buffer);
+    inliers = ransac.getInliers();
+    coef = ransac.getModelCoefficients();
 
     Plane* p = new Plane(inliers, coef);
 
-
-    std::cout << "plane coef: " << coef[0] << " | " << coef[1] << " | " << coef[2] << " | " << coef[3] << " | " << std::endl;
+    if(coef.size() == 4)
+        std::cout << "plane coef: " << coef[0] << " | " << coef[1] << " | " << coef[2] << " | " << coef[3] << " | " << std::endl;
 
     return p;
 }
@@ -100,38 +198,24 @@ void cos_lib::coloringOneLine(pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud, std:
     }
 }
 
-void cos_lib::findLinesInYDirection(pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud){
+void cos_lib::findLinesInYDirection(pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud, double distanceThreshold, int pointsPerLine){
     srand(time(NULL));
 
-    pcl::PointCloud<pcl::PointXYZRGB>::Ptr temp (new pcl::PointCloud<pcl::PointXYZRGB>);
     pcl::PointCloud<pcl::PointXYZRGB>::Ptr colored (new pcl::PointCloud<pcl::PointXYZRGB>);
-    *temp = *cloud;
-    colored->clear();
+    cos_lib::point_buffer buffer(*cloud, rand());
+    cos_lib::axis_line_model model(Eigen::Vector3f::UnitY(), M_PI / 4);
+    cos_lib::local_ransac_extractor extractor(buffer, model, distanceThreshold, pointsPerLine, rand());
 
+    // only lines within 45 degrees of y are drawn, the other lines are left in the buffer
     int i = 0;
-    while( i<10 && temp->size()>1000){
-        std::vector<int> inliers;
-        Eigen::VectorXf coef;
-        Line* l = findALineInYDirection(temp);
-        if(l!=NULL){
-            inliers = l->getInliers();
-            coef = (*l->getCoefficients());
-            l->getAnglesToOrigin();
-            std::vector<int> color = colorRandomizer();
-            pcl::PointCloud<pcl::PointXYZRGB>::Ptr tempLine (new pcl::PointCloud<pcl::PointXYZRGB>);
-
-            tempLine = findOnePlane(temp, inliers);
-            temp = removeSetOfIndices(temp, inliers);
-
-            std::cout << "step #" <<i+1<< " | # of points in temp:"<<temp->size() << std::endl;
-            std::cout << "# of inliers:" << inliers.size() << std::endl;
+    std::vector<int> inliers = extractor.extractModel();
+    while(!inliers.empty()){
+        std::cout << "step #" <<i+1<< " | # of points left:"<<buffer.getNbActive() << std::endl;
+        std::cout << "# of inliers:" << inliers.size() << std::endl;
 
-            if(inliers.size()>0){
-                colorEntirePlane(tempLine, color);
-                *colored += *tempLine;
+        appendColoredPoints(cloud, inliers, colorRandomizer(), colored);
 
-            }
-        }
+        inliers = extractor.extractModel();
         i++;
     }
 
@@ -141,112 +225,122 @@ void cos_lib::findLinesInYDirection(pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud
 
 cos_lib::Line* cos_lib::findALineInYDirection(pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud){
 
-    pcl::SampleConsensusModelLine<pcl::PointXYZRGB>::Ptr model (new pcl::SampleConsensusModelLine<pcl::PointXYZRGB> (cloud));
-    pcl::RandomSampleConsensus<pcl::PointXYZRGB> ransac (model);
-    //pcl::RandomizedRandomSampleConsensus<pcl::PointXYZRGB> ransac (model);
-    std::vector<int> inliers;
-    Eigen::VectorXf coefficients;
-    ransac.setDistanceThreshold(0.01);
+    return findALineAlongAxis(cloud, Eigen::Vector3f::UnitY(), M_PI / 4);
+}
+
+cos_lib::Line* cos_lib::findALineAlongAxis(pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud, const Eigen::Vector3f& axis, double maxAngle, double distanceThreshold){
+
+    cos_lib::point_buffer buffer(*cloud, rand());
+    cos_lib::axis_line_model model(axis, maxAngle);
+    cos_lib::ransac_engine ransac(model, distanceThreshold, rand());
     Line* l = NULL;
-    bool exit = false;
-    int i = 0;
-    while(!exit){
-        ransac.computeModel();
-        ransac.getInliers(inliers);
-        ransac.getModelCoefficients(coefficients);
-
-        float x = fabs(coefficients[3]);
-        float y = fabs(coefficients[4]);
-        float z = fabs(coefficients[5]);
-        i++;
-        if((y-x)>0 && (y-z)>0){
-            l = new Line(inliers, &coefficients);
-            exit = true;
-        }else{
-            if(i >= 8){
-                exit = true;
-            }
-        }
-    }
+
+    if(ransac.computeModel(buffer))
+        l = new Line(ransac.getInliers(), ransac.getModelCoefficients());
 
     return l;
 }
 
 
-pcl::PointCloud<pcl::PointXYZRGB>::Ptr cos_lib::findLinesInClusters(std::vector<pcl::PointCloud<pcl::PointXYZRGB>::Ptr> clusters){
-    std::vector<pcl::PointCloud<pcl::PointXYZRGB>::Ptr>::iterator it = clusters.begin();
-    std::vector<Line*> lines;
-    std::vector<Line*> temp;
-
-    pcl::PointCloud<pcl::PointXYZRGB>::Ptr res (new pcl::PointCloud<pcl::PointXYZRGB>);
-    pcl::PointCloud<pcl::PointXYZRGB>::Ptr temp2 (new pcl::PointCloud<pcl::PointXYZRGB>);
+pcl::PointCloud<pcl::PointXYZRGB>::Ptr cos_lib::findLinesInClusters(std::vector<pcl::PointCloud<pcl::PointXYZRGB>::Ptr> clusters, std::vector<Line>* lines,
+                                                                   uint64_t seed, double distanceThreshold, int pointsPerLine){
+    for(uint c=0; c<clusters.size(); c++){
+        if(!clusters[c])
+            throw cos_lib::except::invalid_cloud_pointer();
+    }
+    if(!(distanceThreshold >= 0))
+        throw std::invalid_argument("The distance threshold of RANSAC cannot be negative.");
+    if(pointsPerLine < 2)
+        throw std::invalid_argument("A line needs at least 2 points.");
+
+    std::vector<std::vector<Line> > clusterLines(clusters.size());
+    std::vector<std::vector<std::vector<int> > > clusterColors(clusters.size());
+    std::vector<std::exception_ptr> errors(clusters.size());
+
+    // each cluster draws its samples and colors from its own generator, so the lines only depend on the seed
+    // an exception cannot leave the parallel loop, so it is kept and thrown again after it
+    #pragma omp parallel for schedule(dynamic)
+    for(long c=0; c<(long)clusters.size(); c++){
+        try{
+            cos_lib::sample_generator generator(seed, c);
+            extractLines(*clusters[c], distanceThreshold, pointsPerLine, generator, clusterLines[c], clusterColors[c]);
+        }
+        catch(...){
+            errors[c] = std::current_exception();
+        }
+    }
 
-    for(it = clusters.begin(); it != clusters.end(); it++){
+    for(uint c=0; c<clusters.size(); c++){
+        if(errors[c])
+            std::rethrow_exception(errors[c]);
+    }
 
-        temp2 = findLines(*it);
-        *res += *temp2;
-//        temp = findLines(*it);
+    // the lines of each cluster are written in their own slice of the result
+    std::vector<size_t> offsets(clusters.size() + 1, 0);
+    for(uint c=0; c<clusters.size(); c++){
+        offsets[c + 1] = offsets[c];
+        for(uint l=0; l<clusterLines[c].size(); l++)
+            offsets[c + 1] += clusterLines[c][l].getInliers().size();
+    }
 
-        lines.insert(lines.end(), temp.begin(), temp.end());
+    pcl::PointCloud<pcl::PointXYZRGB>::Ptr res (new pcl::PointCloud<pcl::PointXYZRGB>);
+    res->points.resize(offsets.back());
+    res->width = res->points.size();
+    res->height = 1;
+
+    #pragma omp parallel for schedule(dynamic)
+    for(long c=0; c<(long)clusters.size(); c++)
+        writeColoredLines(*clusters[c], clusterLines[c], clusterColors[c], *res, offsets[c]);
+
+    if(lines != NULL){
+        lines->clear();
+        for(uint c=0; c<clusters.size(); c++)
+            lines->insert(lines->end(), clusterLines[c].begin(), clusterLines[c].end());
     }
 
     return res;
 }
 
-pcl::PointCloud<pcl::PointXYZRGB>::Ptr cos_lib::findLines(pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud){
+pcl::PointCloud<pcl::PointXYZRGB>::Ptr cos_lib::findLines(pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud, double distanceThreshold, int pointsPerLine, std::vector<Line>* lines){
 
     srand(time(NULL));
 
-    pcl::PointCloud<pcl::PointXYZRGB>::Ptr temp (new pcl::PointCloud<pcl::PointXYZRGB>);
-    pcl::PointCloud<pcl::PointXYZRGB>::Ptr colored (new pcl::PointCloud<pcl::PointXYZRGB>);
-    std::vector<Line*> lines;
-    *temp = *cloud;
-
-    int i = 0;
-    while( i<25 && temp->size()>1000){
-        std::vector<int> inliers;
-        Eigen::VectorXf* coef;
-        Line* l = findBestLine(temp);
-        if(l!=NULL){
-            inliers = l->getInliers();
-            coef = l->getCoefficients();
-            Line* ltemp = new Line(l->getInliers(),l->getCoefficients());
-
-
-            lines.push_back(ltemp);
-
-            std::vector<int> color = colorRandomizer();
-            pcl::PointCloud<pcl::PointXYZRGB>::Ptr tempPlane (new pcl::PointCloud<pcl::PointXYZRGB>);
+    cos_lib::sample_generator generator(rand());
+    std::vector<Line> found;
+    std::vector<std::vector<int> > colors;
+    extractLines(*cloud, distanceThreshold, pointsPerLine, generator, found, colors);
 
-            tempPlane = findOnePlane(temp, inliers);
+    size_t nbPoints = 0;
+    for(uint l=0; l<found.size(); l++)
+        nbPoints += found[l].getInliers().size();
 
-            colorEntirePlane(tempPlane, color);
-            *colored += *tempPlane;
-
-            temp = removeSetOfIndices(temp, inliers);
+    pcl::PointCloud<pcl::PointXYZRGB>::Ptr colored (new pcl::PointCloud<pcl::PointXYZRGB>);
+    colored->points.resize(nbPoints);
+    colored->width = colored->points.size();
+    colored->height = 1;
+    writeColoredLines(*cloud, found, colors, *colored, 0);
 
-        }
-        i++;
-    }
+    if(lines != NULL)
+        *lines = found;
 
     cloud->clear();
-//    return lines;
     return colored;
 }
 
 
 cos_lib::Line* cos_lib::findBestLine(pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud){
 
-    pcl::SampleConsensusModelLine<pcl::PointXYZRGB>::Ptr model (new pcl::SampleConsensusModelLine<pcl::PointXYZRGB> (cloud));
-    pcl::RandomSampleConsensus<pcl::PointXYZRGB> ransac (model);
+    cos_lib::point_buffer buffer(*cloud, rand());
+    cos_lib::line_model model;
+    cos_lib::ransac_engine ransac(model, 0.01, rand());
     std::vector<int> inliers;
     Eigen::VectorXf coefficients;
-    ransac.setDistanceThreshold(0.01);
     Line* l = NULL;
-    ransac.computeModel();
-    ransac.getInliers(inliers);
-    ransac.getModelCoefficients(coefficients);
-    l = new Line(inliers, &coefficients);
+    ransac.setRefinement(true);
+    ransac.computeModel(buffer);
+    inliers = ransac.getInliers();
+    coefficients = ransac.getModelCoefficients();
+    l = new Line(inliers, coefficients);
 
     return l;
 }
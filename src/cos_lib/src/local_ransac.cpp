@@ -0,0 +1,318 @@
+#include "../include/local_ransac.h"
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <chrono>
+
+namespace
+{
+    /**
+     * @brief candidates_per_batch Number of candidates drawn and scored together
+     */
+    const size_t candidates_per_batch = 64;
+
+    /**
+     * @brief subset_size Minimum number of slots the candidates are scored on when they are drawn
+     */
+    const size_t subset_size = 1 << 12;
+
+    /**
+     * @brief subset_support Number of inliers a model with min_support inliers is expected to have in the subset, which sets how large
+     * the subset grows for small models
+     */
+    const double subset_support = 16;
+
+    /**
+     * @brief confidence_deviations Number of standard deviations added to the inliers found in the subset, so that a candidate is only
+     * dropped when it is unlikely to reach min_support on the whole buffer
+     */
+    const double confidence_deviations = 3;
+
+    /**
+     * @brief min_cell_thresholds Size of the smallest cells of the octree, in distance thresholds, smaller cells giving unstable models
+     */
+    const double min_cell_thresholds = 4;
+
+    /**
+     * @brief level_mixing Share of the probability of a level following its scores, the rest being spread evenly so no level is abandoned
+     */
+    const double level_mixing = 0.9;
+
+    /**
+     * @brief max_rejected_draws Number of samples a candidate draws before giving up when the model cannot be fitted on any of them
+     */
+    const int max_rejected_draws = 100;
+
+    /**
+     * @brief max_cell_draws Number of entries drawn in a cell to find an active point not yet in the sample
+     */
+    const int max_cell_draws = 8;
+
+    /**
+     * @brief drawLocalHypothesis Draws samples whose points all lie in the cell of a level containing the first one until the model can be fitted
+     * @param nb_rejected Increased by the number of samples the model could not be fitted on
+     * @return false if the model could not be fitted on any sample
+     */
+    bool drawLocalHypothesis(const cos_lib::point_buffer& buffer, const cos_lib::sampling_octree& octree, const cos_lib::sac_model& model,
+                             cos_lib::sample_generator& generator, int level, Eigen::VectorXf& hypothesis, size_t& nb_rejected)
+    {
+        std::vector<size_t> sample(model.getSampleSize());
+        const uint8_t* active = buffer.getActive();
+
+        for(int draw = 0; draw < max_rejected_draws; draw++)
+        {
+            // Entries of points extracted since the octree was built are skipped, at least half of the entries being active
+            size_t entry = generator.nextBelow(octree.getNbEntries());
+            sample[0] = octree.getSlot(entry);
+            if(!active[sample[0]])
+                continue;
+
+            size_t begin, end;
+            octree.getCell(entry, level, begin, end);
+
+            bool complete = (end - begin >= sample.size());
+            for(size_t i = 1; complete && i < sample.size(); i++)
+            {
+                complete = false;
+                for(int cell_draw = 0; !complete && cell_draw < max_cell_draws; cell_draw++)
+                {
+                    sample[i] = octree.getSlot(begin + generator.nextBelow(end - begin));
+                    complete = active[sample[i]] && std::find(sample.begin(), sample.begin() + i, sample[i]) == sample.begin() + i;
+                }
+            }
+
+            if(complete && model.fit(buffer, sample.data(), hypothesis))
+                return true;
+            nb_rejected++;
+        }
+        return false;
+    }
+}
+
+cos_lib::local_ransac_extractor::local_ransac_extractor(cos_lib::point_buffer& buffer, const cos_lib::sac_model& model, double distance_threshold,
+                                                        size_t min_support, uint64_t seed) : buffer(buffer), model(model)
+{
+    if(!(distance_threshold >= 0))
+        throw std::invalid_argument("The distance threshold of RANSAC cannot be negative.");
+    if(min_support < model.getSampleSize())
+        throw std::invalid_argument("A model cannot be supported by less points than its sample.");
+
+    this->distance_threshold = (float)distance_threshold;
+    this->min_support = min_support;
+    this->probability = 0.99;
+    this->max_candidates = 100000;
+    this->refine = false;
+    this->seed = seed;
+    this->octree_size = 0;
+    this->nb_drawn = 0;
+    this->nb_extracted = 0;
+    this->coverage = 0;
+    this->statistics = cos_lib::ransac_statistics();
+}
+
+void cos_lib::local_ransac_extractor::setProbability(double probability)
+{
+    if(!(probability > 0 && probability < 1))
+        throw std::invalid_argument("The probability of RANSAC must be strictly between 0 and 1.");
+
+    this->probability = probability;
+}
+
+double cos_lib::local_ransac_extractor::missProbability(size_t nb_inliers) const
+{
+    return std::exp(-(double)nb_inliers * this->coverage);
+}
+
+void cos_lib::local_ransac_extractor::drawCandidates()
+{
+    if(this->octree_size != this->buffer.getSize() || this->octree.getNbEntries() == 0)
+    {
+        this->octree.build(this->buffer, min_cell_thresholds * this->distance_threshold);
+        this->octree_size = this->buffer.getSize();
+        this->level_scores.resize(this->octree.getDepth() + 1, 0);
+    }
+
+    const size_t nb_levels = this->octree.getDepth() + 1;
+    const size_t nb_active = this->buffer.getNbActive();
+
+    // A level is drawn with a probability following the scores of its candidates, mixed with an even share
+    std::vector<double> level_thresholds(nb_levels);
+    double total_score = 0;
+    for(size_t level = 0; level < nb_levels; level++)
+        total_score += this->level_scores[level];
+    for(size_t level = 0; level < nb_levels; level++)
+    {
+        double share = total_score > 0 ? level_mixing * this->level_scores[level] / total_score + (1 - level_mixing) / nb_levels : 1.0 / nb_levels;
+        level_thresholds[level] = (level > 0 ? level_thresholds[level - 1] : 0) + share;
+    }
+
+    // The buffer is shuffled, so any range of slots is a random subset of the points. Each batch takes the range following the one of the
+    // previous batch, so a model is not judged on the same points every time, and the range is large enough for a model with min_support
+    // inliers to be expected to have subset_support of them in it
+    const size_t buffer_size = this->buffer.getSize();
+    size_t subset_length = std::max(subset_size, (size_t)std::ceil(subset_support * buffer_size / this->min_support));
+    size_t subset_begin = 0;
+    if(subset_length < buffer_size)
+        subset_begin = (this->nb_drawn / candidates_per_batch * subset_length) % buffer_size;
+    else
+        subset_length = buffer_size;
+
+    // The range wraps around the end of the buffer
+    const size_t first_end = std::min(subset_begin + subset_length, buffer_size);
+    const size_t second_end = subset_begin + subset_length - first_end;
+    size_t subset_active = 0;
+    for(size_t slot = subset_begin; slot < first_end; slot++)
+        subset_active += this->buffer.getActive()[slot];
+    for(size_t slot = 0; slot < second_end; slot++)
+        subset_active += this->buffer.getActive()[slot];
+    if(subset_active == 0)
+    {
+        subset_begin = 0;
+        subset_length = buffer_size;
+        subset_active = nb_active;
+    }
+    const bool exact = (subset_length == buffer_size);
+
+    std::vector<Eigen::VectorXf> hypotheses(candidates_per_batch);
+    std::vector<size_t> levels(candidates_per_batch);
+    std::vector<size_t> scores(candidates_per_batch);
+    std::vector<size_t> rejected(candidates_per_batch);
+    std::vector<uint8_t> valid(candidates_per_batch);
+
+    #pragma omp parallel for schedule(dynamic)
+    for(long h = 0; h < (long)candidates_per_batch; h++)
+    {
+        cos_lib::sample_generator generator(this->seed, 1 + this->nb_drawn + h);
+        double level_draw = (generator.next() >> 11) * (1.0 / 9007199254740992.0);
+
+        levels[h] = 0;
+        while(levels[h] + 1 < nb_levels && level_draw >= level_thresholds[levels[h]])
+            levels[h]++;
+
+        rejected[h] = 0;
+        valid[h] = drawLocalHypothesis(this->buffer, this->octree, this->model, generator, (int)levels[h], hypotheses[h], rejected[h]);
+        if(valid[h])
+        {
+            size_t begin = exact ? 0 : subset_begin;
+            size_t end = exact ? buffer_size : std::min(begin + subset_length, buffer_size);
+            scores[h] = this->model.countInliers(this->buffer, hypotheses[h], this->distance_threshold, begin, end);
+            if(!exact)
+                scores[h] += this->model.countInliers(this->buffer, hypotheses[h], this->distance_threshold, 0, begin + subset_length - end);
+        }
+    }
+
+    for(size_t h = 0; h < candidates_per_batch; h++)
+    {
+        this->statistics.nb_rejected_samples += rejected[h];
+        if(!valid[h])
+            continue;
+
+        this->statistics.nb_evaluations += subset_length;
+        this->level_scores[levels[h]] += (double)scores[h] * nb_active / subset_active;
+
+        // The score kept is an upper confidence bound of the inliers on the whole buffer, the number found in the subset following about
+        // a Poisson law, so the queue never ranks a candidate below its exact score and a candidate is only dropped when it is unlikely
+        // to have min_support inliers
+        size_t score = scores[h];
+        if(!exact)
+        {
+            double bound = (scores[h] + confidence_deviations * std::sqrt((double)scores[h] + 1)) * nb_active / subset_active;
+            score = (size_t)std::min(bound, (double)nb_active);
+        }
+        if(score < this->min_support)
+            continue;
+
+        candidate drawn;
+        drawn.score = score;
+        drawn.scored_at = exact ? this->nb_extracted : SIZE_MAX;
+        drawn.rank = this->nb_drawn + h;
+        drawn.coefficients = hypotheses[h];
+        this->candidates.push_back(drawn);
+        std::push_heap(this->candidates.begin(), this->candidates.end());
+    }
+
+    // The first point of a sample is one of the active points, the level one of nb_levels and each other point one of about
+    // two points of the cell, which is how Schnabel et al. estimate the probability of drawing a given model
+    this->coverage += candidates_per_batch / ((double)nb_active * nb_levels * (1 << (this->model.getSampleSize() - 1)));
+    this->nb_drawn += candidates_per_batch;
+    this->statistics.nb_iterations += candidates_per_batch;
+}
+
+std::vector<int> cos_lib::local_ransac_extractor::extractModel()
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::vector<int> inliers;
+
+    this->statistics = cos_lib::ransac_statistics();
+    this->coefficients.resize(0);
+
+    while(this->buffer.getNbActive() >= this->min_support)
+    {
+        // Scores only decrease as points are extracted, so the best candidate is found by scoring again the top of the queue until it holds
+        // an exact score, candidates left with too few inliers being dropped for good
+        while(!this->candidates.empty() && this->candidates.front().scored_at != this->nb_extracted && this->candidates.front().score >= this->min_support)
+        {
+            std::pop_heap(this->candidates.begin(), this->candidates.end());
+            candidate& top = this->candidates.back();
+
+            top.score = this->model.countInliers(this->buffer, top.coefficients, this->distance_threshold, 0, this->buffer.getSize());
+            top.scored_at = this->nb_extracted;
+            this->statistics.nb_evaluations += this->buffer.getSize();
+
+            if(top.score >= this->min_support)
+                std::push_heap(this->candidates.begin(), this->candidates.end());
+            else
+                this->candidates.pop_back();
+        }
+
+        bool budget_spent = (this->nb_drawn >= this->max_candidates);
+        bool supported = !this->candidates.empty() && this->candidates.front().score >= this->min_support;
+
+        if(supported && (budget_spent || this->missProbability(this->candidates.front().score) < 1 - this->probability))
+        {
+            std::pop_heap(this->candidates.begin(), this->candidates.end());
+            candidate best = this->candidates.back();
+            this->candidates.pop_back();
+
+            std::vector<size_t> slots;
+            this->model.selectInliers(this->buffer, best.coefficients, this->distance_threshold, slots);
+            this->statistics.nb_evaluations += this->buffer.getSize();
+
+            // The refined model is only kept if it explains at least as many points as the candidate
+            Eigen::VectorXf refined;
+            std::vector<size_t> refined_slots;
+            if(this->refine && this->model.refit(this->buffer, slots, refined))
+            {
+                this->model.selectInliers(this->buffer, refined, this->distance_threshold, refined_slots);
+                this->statistics.nb_evaluations += this->buffer.getSize();
+
+                if(refined_slots.size() >= slots.size())
+                {
+                    best.coefficients = refined;
+                    slots.swap(refined_slots);
+                }
+            }
+
+            this->coefficients = best.coefficients;
+            inliers.resize(slots.size());
+            for(size_t i = 0; i < slots.size(); i++)
+                inliers[i] = this->buffer.getIndex(slots[i]);
+            std::sort(inliers.begin(), inliers.end());
+
+            this->buffer.deactivate(slots);
+            this->nb_extracted++;
+            break;
+        }
+
+        // Without a candidate good enough, the extraction stops once a model with min_support inliers would have been drawn
+        if(budget_spent || (!supported && this->missProbability(this->min_support) < 1 - this->probability))
+            break;
+
+        this->drawCandidates();
+    }
+
+    this->statistics.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    return inliers;
+}
@@ -0,0 +1,277 @@
+#include "../include/model_extraction.h"
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <Eigen/Eigenvalues>
+
+namespace
+{
+    /**
+     * @brief computeScatter Computes the centroid of a set of slots of a buffer and the scatter matrix of the points around it
+     */
+    void computeScatter(const cos_lib::point_buffer& buffer, const std::vector<size_t>& slots, Eigen::Vector3d& centroid, Eigen::Matrix3d& scatter)
+    {
+        const float* x = buffer.getX();
+        const float* y = buffer.getY();
+        const float* z = buffer.getZ();
+
+        centroid.setZero();
+        for(size_t i = 0; i < slots.size(); i++)
+            centroid += Eigen::Vector3d(x[slots[i]], y[slots[i]], z[slots[i]]);
+        centroid /= (double)slots.size();
+
+        scatter.setZero();
+        for(size_t i = 0; i < slots.size(); i++)
+        {
+            Eigen::Vector3d offset = Eigen::Vector3d(x[slots[i]], y[slots[i]], z[slots[i]]) - centroid;
+            scatter += offset * offset.transpose();
+        }
+    }
+}
+
+cos_lib::point_buffer::point_buffer(const pcl::PointCloud<pcl::PointXYZRGB>& cloud, uint64_t seed)
+{
+    size_t nb_points = cloud.points.size();
+    if(nb_points > (size_t)std::numeric_limits<int>::max())
+        throw std::invalid_argument("The cloud holds too many points for a point buffer.");
+
+    this->x.resize(nb_points);
+    this->y.resize(nb_points);
+    this->z.resize(nb_points);
+    this->active.assign(nb_points, 1);
+    this->indices.resize(nb_points);
+    this->nb_active = nb_points;
+
+    // Fisher-Yates shuffle of the indices, the coordinates are then gathered in that order
+    cos_lib::sample_generator generator(seed);
+    for(size_t i = 0; i < nb_points; i++)
+        this->indices[i] = (int)i;
+    for(size_t i = nb_points; i > 1; i--)
+        std::swap(this->indices[i - 1], this->indices[generator.nextBelow(i)]);
+
+    #pragma omp parallel for schedule(static)
+    for(long i = 0; i < (long)nb_points; i++)
+    {
+        const pcl::PointXYZRGB& point = cloud.points[this->indices[i]];
+        this->x[i] = point.x;
+        this->y[i] = point.y;
+        this->z[i] = point.z;
+    }
+}
+
+void cos_lib::point_buffer::deactivate(const std::vector<size_t>& slots)
+{
+    for(size_t i = 0; i < slots.size(); i++)
+    {
+        this->nb_active -= this->active[slots[i]];
+        this->active[slots[i]] = 0;
+    }
+
+    if(this->nb_active * 2 < this->getSize())
+        this->compact();
+}
+
+void cos_lib::point_buffer::compact()
+{
+    size_t kept = 0;
+    for(size_t slot = 0; slot < this->getSize(); slot++)
+    {
+        if(!this->active[slot])
+            continue;
+
+        this->x[kept] = this->x[slot];
+        this->y[kept] = this->y[slot];
+        this->z[kept] = this->z[slot];
+        this->indices[kept] = this->indices[slot];
+        kept++;
+    }
+
+    this->x.resize(kept);
+    this->y.resize(kept);
+    this->z.resize(kept);
+    this->indices.resize(kept);
+    this->active.assign(kept, 1);
+}
+
+bool cos_lib::plane_model::fit(const cos_lib::point_buffer& buffer, const size_t* sample, Eigen::VectorXf& coefficients) const
+{
+    const float* x = buffer.getX();
+    const float* y = buffer.getY();
+    const float* z = buffer.getZ();
+
+    Eigen::Vector3d origin(x[sample[0]], y[sample[0]], z[sample[0]]);
+    Eigen::Vector3d u = Eigen::Vector3d(x[sample[1]], y[sample[1]], z[sample[1]]) - origin;
+    Eigen::Vector3d v = Eigen::Vector3d(x[sample[2]], y[sample[2]], z[sample[2]]) - origin;
+    Eigen::Vector3d normal = u.cross(v);
+    double length = normal.norm();
+
+    // The sine of the angle between the two edges tells how far from a line the points are, whatever the scale of the cloud
+    if(!(length > 1e-6 * u.norm() * v.norm()))
+        return false;
+
+    normal /= length;
+    coefficients.resize(4);
+    coefficients << (float)normal[0], (float)normal[1], (float)normal[2], (float)-normal.dot(origin);
+    return true;
+}
+
+size_t cos_lib::plane_model::countInliers(const cos_lib::point_buffer& buffer, const Eigen::VectorXf& coefficients, float threshold, size_t begin, size_t end) const
+{
+    const float* x = buffer.getX();
+    const float* y = buffer.getY();
+    const float* z = buffer.getZ();
+    const uint8_t* active = buffer.getActive();
+    const float a = coefficients[0], b = coefficients[1], c = coefficients[2], d = coefficients[3];
+    size_t count = 0;
+
+    #pragma omp simd reduction(+:count)
+    for(size_t i = begin; i < end; i++)
+        count += active[i] & (std::fabs(a * x[i] + b * y[i] + c * z[i] + d) <= threshold);
+
+    return count;
+}
+
+void cos_lib::plane_model::selectInliers(const cos_lib::point_buffer& buffer, const Eigen::VectorXf& coefficients, float threshold, std::vector<size_t>& slots) const
+{
+    const float* x = buffer.getX();
+    const float* y = buffer.getY();
+    const float* z = buffer.getZ();
+    const uint8_t* active = buffer.getActive();
+    const float a = coefficients[0], b = coefficients[1], c = coefficients[2], d = coefficients[3];
+
+    slots.clear();
+    for(size_t i = 0; i < buffer.getSize(); i++)
+    {
+        if(active[i] && std::fabs(a * x[i] + b * y[i] + c * z[i] + d) <= threshold)
+            slots.push_back(i);
+    }
+}
+
+bool cos_lib::plane_model::refit(const cos_lib::point_buffer& buffer, const std::vector<size_t>& slots, Eigen::VectorXf& coefficients) const
+{
+    if(slots.size() < this->getSampleSize())
+        return false;
+
+    Eigen::Vector3d centroid;
+    Eigen::Matrix3d scatter;
+    computeScatter(buffer, slots, centroid, scatter);
+
+    // Eigenvalues come sorted by increasing value, points spread along a single direction do not define a plane
+    Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> solver(scatter);
+    if(!(solver.eigenvalues()[1] > 0))
+        return false;
+
+    Eigen::Vector3d normal = solver.eigenvectors().col(0);
+    coefficients.resize(4);
+    coefficients << (float)normal[0], (float)normal[1], (float)normal[2], (float)-normal.dot(centroid);
+    return true;
+}
+
+bool cos_lib::line_model::fit(const cos_lib::point_buffer& buffer, const size_t* sample, Eigen::VectorXf& coefficients) const
+{
+    const float* x = buffer.getX();
+    const float* y = buffer.getY();
+    const float* z = buffer.getZ();
+
+    Eigen::Vector3d origin(x[sample[0]], y[sample[0]], z[sample[0]]);
+    Eigen::Vector3d direction = Eigen::Vector3d(x[sample[1]], y[sample[1]], z[sample[1]]) - origin;
+    double length = direction.norm();
+
+    if(!(length > 0))
+        return false;
+
+    direction /= length;
+    coefficients.resize(6);
+    coefficients << (float)origin[0], (float)origin[1], (float)origin[2], (float)direction[0], (float)direction[1], (float)direction[2];
+    return true;
+}
+
+size_t cos_lib::line_model::countInliers(const cos_lib::point_buffer& buffer, const Eigen::VectorXf& coefficients, float threshold, size_t begin, size_t end) const
+{
+    const float* x = buffer.getX();
+    const float* y = buffer.getY();
+    const float* z = buffer.getZ();
+    const uint8_t* active = buffer.getActive();
+    const float px = coefficients[0], py = coefficients[1], pz = coefficients[2];
+    const float dx = coefficients[3], dy = coefficients[4], dz = coefficients[5];
+    const float sq_threshold = threshold * threshold;
+    size_t count = 0;
+
+    // The distance to the line is the norm of the cross product of the offset with the unit direction
+    #pragma omp simd reduction(+:count)
+    for(size_t i = begin; i < end; i++)
+    {
+        float vx = x[i] - px, vy = y[i] - py, vz = z[i] - pz;
+        float cx = vy * dz - vz * dy, cy = vz * dx - vx * dz, cz = vx * dy - vy * dx;
+        count += active[i] & (cx * cx + cy * cy + cz * cz <= sq_threshold);
+    }
+
+    return count;
+}
+
+void cos_lib::line_model::selectInliers(const cos_lib::point_buffer& buffer, const Eigen::VectorXf& coefficients, float threshold, std::vector<size_t>& slots) const
+{
+    const float* x = buffer.getX();
+    const float* y = buffer.getY();
+    const float* z = buffer.getZ();
+    const uint8_t* active = buffer.getActive();
+    const float px = coefficients[0], py = coefficients[1], pz = coefficients[2];
+    const float dx = coefficients[3], dy = coefficients[4], dz = coefficients[5];
+    const float sq_threshold = threshold * threshold;
+
+    slots.clear();
+    for(size_t i = 0; i < buffer.getSize(); i++)
+    {
+        float vx = x[i] - px, vy = y[i] - py, vz = z[i] - pz;
+        float cx = vy * dz - vz * dy, cy = vz * dx - vx * dz, cz = vx * dy - vy * dx;
+        if(active[i] && cx * cx + cy * cy + cz * cz <= sq_threshold)
+            slots.push_back(i);
+    }
+}
+
+bool cos_lib::line_model::refit(const cos_lib::point_buffer& buffer, const std::vector<size_t>& slots, Eigen::VectorXf& coefficients) const
+{
+    if(slots.size() < this->getSampleSize())
+        return false;
+
+    Eigen::Vector3d centroid;
+    Eigen::Matrix3d scatter;
+    computeScatter(buffer, slots, centroid, scatter);
+
+    Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> solver(scatter);
+    if(!(solver.eigenvalues()[2] > 0))
+        return false;
+
+    Eigen::Vector3d direction = solver.eigenvectors().col(2);
+    coefficients.resize(6);
+    coefficients << (float)centroid[0], (float)centroid[1], (float)centroid[2], (float)direction[0], (float)direction[1], (float)direction[2];
+    return true;
+}
+
+cos_lib::axis_line_model::axis_line_model(const Eigen::Vector3f& axis, double max_angle)
+{
+    if(!(axis.norm() > 0))
+        throw std::invalid_argument("The axis of a line model cannot be null.");
+    if(!(max_angle >= 0 && max_angle <= M_PI / 2))
+        throw std::invalid_argument("The angle between a line and its axis must be between 0 and pi / 2.");
+
+    this->axis = axis.normalized();
+    this->min_cosine = (float)std::cos(max_angle);
+}
+
+bool cos_lib::axis_line_model::isAligned(const Eigen::VectorXf& coefficients) const
+{
+    // Directions are unit vectors, so the cosine of their angle with the axis is their dot product, either way along the axis
+    return std::fabs(coefficients.segment<3>(3).dot(this->axis)) >= this->min_cosine;
+}
+
+bool cos_lib::axis_line_model::fit(const cos_lib::point_buffer& buffer, const size_t* sample, Eigen::VectorXf& coefficients) const
+{
+    return cos_lib::line_model::fit(buffer, sample, coefficients) && this->isAligned(coefficients);
+}
+
+bool cos_lib::axis_line_model::refit(const cos_lib::point_buffer& buffer, const std::vector<size_t>& slots, Eigen::VectorXf& coefficients) const
+{
+    return cos_lib::line_model::refit(buffer, slots, coefficients) && this->isAligned(coefficients);
+}
@@ -0,0 +1,38 @@
+#include "../include/neighbour_graph.h"
+
+cos_lib::neighbour_graph::neighbour_graph()
+{
+
+}
+
+void cos_lib::neighbour_graph::build(const cos_lib::spatial_index& index, double neighbours_radius)
+{
+    this->clear();
+
+    std::vector<uint32_t> PointsID; // Contains the neighbours indices
+    std::vector<float> PointsDist; // Only needed by the index for the radius search
+
+    this->offsets.reserve(index.getNbPoints() + 1);
+    this->offsets.push_back(0);
+
+    for(size_t i = 0; i < index.getNbPoints(); i++)
+    {
+        index.radiusSearch(index.getPoint(i), neighbours_radius, PointsID, PointsDist, 0);
+        for(size_t j = 0; j < PointsID.size(); j++)
+        {
+            // A point is not its own neighbour
+            if(PointsID[j] != i)
+                this->indices.push_back(PointsID[j]);
+        }
+        this->offsets.push_back(this->indices.size());
+    }
+    this->indices.shrink_to_fit();
+}
+
+void cos_lib::neighbour_graph::clear()
+{
+    this->offsets.clear();
+    this->offsets.shrink_to_fit();
+    this->indices.clear();
+    this->indices.shrink_to_fit();
+}
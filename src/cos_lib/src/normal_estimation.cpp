@@ -9,75 +9,115 @@ void cos_lib::estimate_normals(
     if (cos_lib::aux::float_cmp(radius, 0.00, 0.005))
         throw std::logic_error("Invalid radius value.");
 
-    if (cos_lib::aux::float_cmp(max_neighbs, 0.00, 0.005))
+    if (cos_lib::aux::float_cmp(max_neighbs, 0.00, 0.005) || max_neighbs < 0)
         throw std::logic_error("Invalid max neighbours value.");
 
-    pcl::KdTreeFLANN<pcl::PointXYZRGB> kdt; // kd-tree used for finding neighbours
+    // the cloud is cut into tiles of 64 radii with a halo of one radius, each tile's search structure then fits in cache
+    cos_lib::tile_scheduler tiles(64.0 * radius, radius);
+    cos_lib::normal_buffer normals;
 
-    kdt.setInputCloud(cloud_ptr);
+    tiles.build(cloud_ptr);
+    cos_lib::normal_estimator(radius, max_neighbs).compute(cloud_ptr, tiles, normals);
+    tiles.clear();
 
-    for (auto cloud_it = cloud_ptr->begin(); cloud_it < cloud_ptr->end(); cloud_it++)
+    cos_lib::color_with_normals(cloud_ptr, normals);
+}
+
+void cos_lib::estimate_normals(
+        pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud_ptr, const cos_lib::spatial_index& index, float radius, int max_neighbs)
+{
+    if (!cloud_ptr)
+        throw cos_lib::except::invalid_cloud_pointer();
+
+    if (cos_lib::aux::float_cmp(radius, 0.00, 0.005))
+        throw std::logic_error("Invalid radius value.");
+
+    if (cos_lib::aux::float_cmp(max_neighbs, 0.00, 0.005) || max_neighbs < 0)
+        throw std::logic_error("Invalid max neighbours value.");
+
+    if (index.getNbPoints() != cloud_ptr->size())
+        throw std::invalid_argument("The spatial index was not built on the whole cloud.");
+
+    cos_lib::normal_buffer normals;
+    cos_lib::normal_estimator(radius, max_neighbs).compute(index, normals);
+
+    cos_lib::color_with_normals(cloud_ptr, normals);
+}
+
+void cos_lib::color_with_normals(pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud_ptr, const cos_lib::normal_buffer& normals)
+{
+    if (!cloud_ptr)
+        throw cos_lib::except::invalid_cloud_pointer();
+
+    if (normals.size() != cloud_ptr->size())
+        throw std::invalid_argument("The normals do not match the cloud.");
+
+    // coloring the points based on their normal's coordinates, points without a normal keep their color
+    #pragma omp parallel for schedule(static)
+    for (long pt_index = 0; pt_index < (long)cloud_ptr->size(); pt_index++)
     {
-        std::vector<int> pt_ids; // neighbours' ids
-        std::vector<float> pt_sq_dist; // distances from the source to the neighbours
-
-        // if there are neighbours left
-        if (kdt.radiusSearch(*cloud_it, radius, pt_ids, pt_sq_dist, max_neighbs) > 0)
-        {
-            std::vector<cos_lib::aux::vector3> vects_to_avg; // vect_or average used for estimating normal;
-
-            for (size_t pt_index = 0; pt_index < (pt_ids.size() - 1); pt_index++)
-            {
-                cos_lib::aux::vector3 vect_1 = cos_lib::aux::vect_2pts(*cloud_it,
-                                                     cloud_ptr->points[pt_ids[pt_index + 1]]);
-                cos_lib::aux::vector3 vect_2;
-
-                // defining the second vect_or; making sure there is no 'out of bounds' error
-                if (pt_index == pt_ids.size() - 2)
-                    vect_2 = cos_lib::aux::vect_2pts(*cloud_it, cloud_ptr->points[pt_ids[1]]);
-
-                else
-                    vect_2 = cos_lib::aux::vect_2pts(*cloud_it, cloud_ptr->points[pt_ids[pt_index + 2]]);
-
-                vects_to_avg.push_back(cos_lib::aux::vector_abs(cos_lib::aux::cross_product(vect_1, vect_2)));
-            }
-
-            // calculating the normal and coloring the point based on its coordinates
-            cos_lib::aux::vector3 normal = cos_lib::aux::normalize_normal(cos_lib::aux::vector_avg(vects_to_avg));
-            cos_lib::aux::normal_to_rgb(&(*cloud_it), normal);
-
-            vects_to_avg.clear();
-            vects_to_avg.shrink_to_fit();
-        }
-
-        pt_ids.clear();
-        pt_sq_dist.clear();
-        pt_ids.shrink_to_fit();
-        pt_sq_dist.shrink_to_fit();
+        if (std::isnan(normals.normal_x[pt_index]))
+            continue;
+
+        cos_lib::aux::vector3 normal(std::abs(normals.normal_x[pt_index]), std::abs(normals.normal_y[pt_index]),
+                                     std::abs(normals.normal_z[pt_index]));
+        cos_lib::aux::normal_to_rgb(&cloud_ptr->points[pt_index], normal);
     }
 }
 
 void cos_lib::estimate_normals(
-        pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud_ptr)
+        pcl::PointCloud<pcl::PointXYZRGB>::ConstPtr cloud_ptr, pcl::PointCloud<pcl::Normal>::Ptr normals_ptr, float radius, int k)
 {
-      if (!cloud_ptr)
+    if (!cloud_ptr)
         throw cos_lib::except::invalid_cloud_pointer();
 
-      // Create the normal estimation class, and pass the input dataset to it
-      pcl::NormalEstimation<pcl::PointXYZRGB, pcl::Normal> ne;
-      ne.setInputCloud(cloud_ptr);
+    if (radius > 0)
+    {
+        cos_lib::voxel_hash_index index(radius); // cells of the search radius, so each search scans 27 cells
 
-      // Create an empty kdtree representation, and pass it to the normal estimation object.
-      // Its content will be filled inside the object, based on the given input dataset (as no other search surface is given).
-      pcl::search::KdTree<pcl::PointXYZRGB>::Ptr tree_ptr (new pcl::search::KdTree<pcl::PointXYZRGB> ());
-      ne.setSearchMethod (tree_ptr);
+        index.build(cloud_ptr);
+        cos_lib::estimate_normals(index, normals_ptr, radius, k);
+    }
 
-      // Output datasets
-      pcl::PointCloud<pcl::Normal>::Ptr cloud_normals_ptr (new pcl::PointCloud<pcl::Normal>);
+    else
+    {
+        cos_lib::kd_tree_index index; // no radius to size cells with
 
-      // Use all neighbors in a sphere of radius 3cm
-      ne.setRadiusSearch (0.03);
+        index.build(cloud_ptr);
+        cos_lib::estimate_normals(index, normals_ptr, radius, k);
+    }
+}
 
-      // Compute the features
-      ne.compute (*cloud_normals_ptr);
+void cos_lib::estimate_normals(
+        const cos_lib::spatial_index& index, pcl::PointCloud<pcl::Normal>::Ptr normals_ptr, float radius, int k)
+{
+    if (!normals_ptr)
+        throw cos_lib::except::invalid_cloud_pointer();
+
+    if (k < 0)
+        throw std::invalid_argument("Invalid k value.");
+
+    cos_lib::normal_buffer normals;
+    cos_lib::normal_estimator(radius, k).compute(index, normals);
+
+    normals_ptr->resize(normals.size());
+    normals_ptr->width = normals.size();
+    normals_ptr->height = 1;
+    normals_ptr->is_dense = false;
+
+    #pragma omp parallel for schedule(static)
+    for (long pt_index = 0; pt_index < (long)normals.size(); pt_index++)
+    {
+        pcl::Normal& normal = normals_ptr->points[pt_index];
+        const pcl::PointXYZ& pt = index.getPoint(pt_index);
+
+        // the normal must face the viewpoint, which is the origin
+        float sign = (normals.normal_x[pt_index] * pt.x + normals.normal_y[pt_index] * pt.y
+                      + normals.normal_z[pt_index] * pt.z) > 0 ? -1.0f : 1.0f;
+
+        normal.normal_x = sign * normals.normal_x[pt_index];
+        normal.normal_y = sign * normals.normal_y[pt_index];
+        normal.normal_z = sign * normals.normal_z[pt_index];
+        normal.curvature = normals.curvature[pt_index];
+    }
 }
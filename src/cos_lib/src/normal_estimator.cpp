@@ -0,0 +1,297 @@
+#include "../include/normal_estimator.h"
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+const size_t cos_lib::normal_estimator::block_size;
+
+void cos_lib::normal_buffer::resize(size_t nb_points)
+{
+    normal_x.resize(nb_points);
+    normal_y.resize(nb_points);
+    normal_z.resize(nb_points);
+    curvature.resize(nb_points);
+}
+
+cos_lib::normal_estimator::normal_estimator(float radius, size_t max_neighbs)
+{
+    if (!(radius >= 0))
+        throw std::invalid_argument("Invalid radius value.");
+
+    if (radius == 0 && max_neighbs == 0)
+        throw std::invalid_argument("A search needs either a radius or a number of neighbours.");
+
+    this->radius = radius;
+    this->max_neighbs = max_neighbs;
+}
+
+void cos_lib::normal_estimator::compute(pcl::PointCloud<pcl::PointXYZRGB>::ConstPtr cloud_ptr, normal_buffer& normals) const
+{
+    if (!cloud_ptr)
+        throw cos_lib::except::invalid_cloud_pointer();
+
+    if (this->radius > 0)
+    {
+        cos_lib::voxel_hash_index index(this->radius); // cells of the search radius, so each search scans 27 cells
+
+        index.build(cloud_ptr);
+        this->compute(index, normals);
+    }
+
+    else
+    {
+        cos_lib::kd_tree_index index; // no radius to size cells with
+
+        index.build(cloud_ptr);
+        this->compute(index, normals);
+    }
+}
+
+void cos_lib::normal_estimator::compute(const cos_lib::spatial_index& index, normal_buffer& normals) const
+{
+    const size_t nb_points = index.getNbPoints();
+    const size_t nb_blocks = (nb_points + block_size - 1) / block_size;
+
+    normals.resize(nb_points);
+
+    #pragma omp parallel
+    {
+        std::vector<uint32_t> pt_ids; // neighbours' positions in the index, reused from one point to the next
+        std::vector<float> pt_sq_dist;
+        float block_normals[3 * block_size];
+        float block_curvatures[block_size];
+
+        #pragma omp for schedule(dynamic, 16)
+        for (long block = 0; block < (long)nb_blocks; block++)
+        {
+            size_t first = block * block_size;
+            size_t count = std::min(block_size, nb_points - first);
+
+            this->computeBlock(index, first, count, pt_ids, pt_sq_dist, block_normals, block_curvatures);
+
+            for (size_t b = 0; b < count; b++)
+            {
+                normals.normal_x[first + b] = block_normals[0 * block_size + b];
+                normals.normal_y[first + b] = block_normals[1 * block_size + b];
+                normals.normal_z[first + b] = block_normals[2 * block_size + b];
+                normals.curvature[first + b] = block_curvatures[b];
+            }
+        }
+    }
+}
+
+void cos_lib::normal_estimator::compute(pcl::PointCloud<pcl::PointXYZRGB>::ConstPtr cloud_ptr, const cos_lib::tile_scheduler& tiles,
+                                        normal_buffer& normals) const
+{
+    if (!cloud_ptr)
+        throw cos_lib::except::invalid_cloud_pointer();
+
+    if (this->radius == 0 || (float)tiles.getHalo() < this->radius)
+        throw std::invalid_argument("The halo of the tiles must be at least as big as the search radius.");
+
+    normals.resize(cloud_ptr->size());
+
+    tiles.run([this, &cloud_ptr, &normals](const cos_lib::cloud_tile& tile)
+    {
+        // the core points come first in the tile, so they are the first positions of its index
+        cos_lib::voxel_hash_index index(this->radius);
+        index.build(cloud_ptr, tile.indices.data(), tile.indices.data() + tile.indices.size());
+
+        std::vector<uint32_t> pt_ids;
+        std::vector<float> pt_sq_dist;
+        float block_normals[3 * block_size];
+        float block_curvatures[block_size];
+
+        for (size_t first = 0; first < tile.nb_core_points; first += block_size)
+        {
+            size_t count = std::min(block_size, tile.nb_core_points - first);
+
+            this->computeBlock(index, first, count, pt_ids, pt_sq_dist, block_normals, block_curvatures);
+
+            // each point is the core point of one tile only, so no other thread writes there
+            for (size_t b = 0; b < count; b++)
+            {
+                uint32_t pt_index = tile.indices[first + b];
+                normals.normal_x[pt_index] = block_normals[0 * block_size + b];
+                normals.normal_y[pt_index] = block_normals[1 * block_size + b];
+                normals.normal_z[pt_index] = block_normals[2 * block_size + b];
+                normals.curvature[pt_index] = block_curvatures[b];
+            }
+        }
+    });
+}
+
+void cos_lib::normal_estimator::computeBlock(const cos_lib::spatial_index& index, size_t first, size_t count, std::vector<uint32_t>& pt_ids,
+                                             std::vector<float>& pt_sq_dist, float* normals, float* curvatures) const
+{
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    double covariances[6 * block_size];
+    bool valid[block_size];
+
+    for (size_t b = 0; b < block_size; b++)
+    {
+        valid[b] = false;
+
+        if (b < count)
+        {
+            if (this->radius > 0)
+                index.radiusSearch(index.getPoint(first + b), this->radius, pt_ids, pt_sq_dist, this->max_neighbs);
+            else
+                index.nearestKSearch(index.getPoint(first + b), this->max_neighbs, pt_ids, pt_sq_dist);
+            valid[b] = pt_ids.size() >= 3; // a plane needs at least 3 points
+        }
+
+        if (!valid[b])
+        {
+            // the identity keeps the solver busy on something harmless, its result is thrown away
+            covariances[0 * block_size + b] = 1; covariances[1 * block_size + b] = 0; covariances[2 * block_size + b] = 0;
+            covariances[3 * block_size + b] = 1; covariances[4 * block_size + b] = 0; covariances[5 * block_size + b] = 1;
+            continue;
+        }
+
+        // centroid first, so the covariance is accumulated on small centred values
+        double cx = 0, cy = 0, cz = 0;
+        for (size_t n = 0; n < pt_ids.size(); n++)
+        {
+            const pcl::PointXYZ& pt = index.getPoint(pt_ids[n]);
+            cx += pt.x; cy += pt.y; cz += pt.z;
+        }
+        cx /= pt_ids.size(); cy /= pt_ids.size(); cz /= pt_ids.size();
+
+        double xx = 0, xy = 0, xz = 0, yy = 0, yz = 0, zz = 0;
+        for (size_t n = 0; n < pt_ids.size(); n++)
+        {
+            const pcl::PointXYZ& pt = index.getPoint(pt_ids[n]);
+            double dx = pt.x - cx, dy = pt.y - cy, dz = pt.z - cz;
+            xx += dx * dx; xy += dx * dy; xz += dx * dz;
+            yy += dy * dy; yz += dy * dz; zz += dz * dz;
+        }
+
+        covariances[0 * block_size + b] = xx; covariances[1 * block_size + b] = xy; covariances[2 * block_size + b] = xz;
+        covariances[3 * block_size + b] = yy; covariances[4 * block_size + b] = yz; covariances[5 * block_size + b] = zz;
+    }
+
+    cos_lib::normal_estimator::solveBlock(covariances, normals, curvatures);
+
+    for (size_t b = 0; b < count; b++)
+    {
+        if (!valid[b])
+        {
+            normals[0 * block_size + b] = nan;
+            normals[1 * block_size + b] = nan;
+            normals[2 * block_size + b] = nan;
+            curvatures[b] = nan;
+        }
+    }
+}
+
+void cos_lib::normal_estimator::solveBlock(const double* covariances, float* normals, float* curvatures)
+{
+    const double two_pi_3 = 2.0 * M_PI / 3.0;
+    double smallest_eigenvalues[block_size];
+
+    // closed-form eigenvalues of a symmetric 3x3 matrix (Smith, 1961) then eigenvector from the rows of A - lambda * I,
+    // written without branches so the compiler can run the loop on vector registers
+    #pragma omp simd
+    for (size_t b = 0; b < block_size; b++)
+    {
+        double a00 = covariances[0 * block_size + b], a01 = covariances[1 * block_size + b], a02 = covariances[2 * block_size + b];
+        double a11 = covariances[3 * block_size + b], a12 = covariances[4 * block_size + b], a22 = covariances[5 * block_size + b];
+
+        // scaling the matrix keeps the cubic terms away from overflow and underflow
+        double max_coef = std::max(std::max(std::max(std::abs(a00), std::abs(a01)), std::max(std::abs(a02), std::abs(a11))),
+                                   std::max(std::abs(a12), std::abs(a22)));
+        double inv_scale = max_coef > 0 ? 1.0 / max_coef : 1.0;
+        a00 *= inv_scale; a01 *= inv_scale; a02 *= inv_scale;
+        a11 *= inv_scale; a12 *= inv_scale; a22 *= inv_scale;
+
+        double mean = (a00 + a11 + a22) / 3.0;
+        double k00 = a00 - mean, k11 = a11 - mean, k22 = a22 - mean;
+        double p = (k00 * k00 + k11 * k11 + k22 * k22 + 2.0 * (a01 * a01 + a02 * a02 + a12 * a12)) / 6.0;
+        double q = (k00 * (k11 * k22 - a12 * a12) - a01 * (a01 * k22 - a12 * a02) + a02 * (a01 * a12 - k11 * a02)) / 2.0;
+        double sqrt_p = std::sqrt(p);
+        double ratio = p > 0 ? q / (p * sqrt_p) : 0.0;
+        ratio = std::min(1.0, std::max(-1.0, ratio));
+        double phi = std::acos(ratio) / 3.0;
+
+        double lambda_0 = mean + 2.0 * sqrt_p * std::cos(phi + two_pi_3); // smallest
+        double lambda_2 = mean + 2.0 * sqrt_p * std::cos(phi);            // biggest
+        double lambda_1 = 3.0 * mean - lambda_0 - lambda_2;
+        smallest_eigenvalues[b] = lambda_0;
+
+        // the eigenvector is orthogonal to the rows of A - lambda_0 * I, the best conditioned cross product is kept
+        double r00 = a00 - lambda_0, r11 = a11 - lambda_0, r22 = a22 - lambda_0;
+        double c01x = a01 * a12 - a02 * r11, c01y = a02 * a01 - r00 * a12, c01z = r00 * r11 - a01 * a01;
+        double c02x = a01 * r22 - a02 * a12, c02y = a02 * a02 - r00 * r22, c02z = r00 * a12 - a01 * a02;
+        double c12x = r11 * r22 - a12 * a12, c12y = a12 * a02 - a01 * r22, c12z = a01 * a12 - r11 * a02;
+        double d01 = c01x * c01x + c01y * c01y + c01z * c01z;
+        double d02 = c02x * c02x + c02y * c02y + c02z * c02z;
+        double d12 = c12x * c12x + c12y * c12y + c12z * c12z;
+
+        double nx = c01x, ny = c01y, nz = c01z, d = d01;
+        nx = d02 > d ? c02x : nx; ny = d02 > d ? c02y : ny; nz = d02 > d ? c02z : nz; d = std::max(d, d02);
+        nx = d12 > d ? c12x : nx; ny = d12 > d ? c12y : ny; nz = d12 > d ? c12z : nz; d = std::max(d, d12);
+
+        // the matrix being scaled to 1, a smaller cross product only holds rounding errors
+        double inv_norm = d > 1e-12 ? 1.0 / std::sqrt(d) : 0.0;
+        normals[0 * block_size + b] = (float)(nx * inv_norm);
+        normals[1 * block_size + b] = (float)(ny * inv_norm);
+        normals[2 * block_size + b] = (float)(nz * inv_norm);
+
+        double sum = lambda_0 + lambda_1 + lambda_2;
+        curvatures[b] = sum > 0 ? (float)(std::max(0.0, lambda_0) / sum) : 0.0f;
+    }
+
+    // a double smallest eigenvalue (points on a line) leaves every cross product null, any vector orthogonal to the line is then a normal
+    for (size_t b = 0; b < block_size; b++)
+    {
+        if (normals[0 * block_size + b] != 0 || normals[1 * block_size + b] != 0 || normals[2 * block_size + b] != 0)
+            continue;
+
+        double lambda_0 = smallest_eigenvalues[b];
+        double max_coef = 0;
+        for (size_t c = 0; c < 6; c++)
+            max_coef = std::max(max_coef, std::abs(covariances[c * block_size + b]));
+        double inv_scale = max_coef > 0 ? 1.0 / max_coef : 1.0;
+
+        double rows[3][3] = {
+            { covariances[0 * block_size + b] * inv_scale - lambda_0, covariances[1 * block_size + b] * inv_scale, covariances[2 * block_size + b] * inv_scale },
+            { covariances[1 * block_size + b] * inv_scale, covariances[3 * block_size + b] * inv_scale - lambda_0, covariances[4 * block_size + b] * inv_scale },
+            { covariances[2 * block_size + b] * inv_scale, covariances[4 * block_size + b] * inv_scale, covariances[5 * block_size + b] * inv_scale - lambda_0 } };
+
+        size_t best_row = 0;
+        double best_norm = 0;
+        for (size_t r = 0; r < 3; r++)
+        {
+            double row_norm = rows[r][0] * rows[r][0] + rows[r][1] * rows[r][1] + rows[r][2] * rows[r][2];
+            if (row_norm > best_norm)
+            {
+                best_norm = row_norm;
+                best_row = r;
+            }
+        }
+
+        // every direction is an eigenvector of a multiple of the identity
+        double nx = 0, ny = 0, nz = 1;
+
+        if (best_norm > 0)
+        {
+            // crossing the row with the axis it is the least aligned with
+            const double* row = rows[best_row];
+            if (std::abs(row[0]) <= std::abs(row[1]) && std::abs(row[0]) <= std::abs(row[2]))
+            { nx = 0; ny = row[2]; nz = -row[1]; }
+            else if (std::abs(row[1]) <= std::abs(row[2]))
+            { nx = -row[2]; ny = 0; nz = row[0]; }
+            else
+            { nx = row[1]; ny = -row[0]; nz = 0; }
+
+            double norm = std::sqrt(nx * nx + ny * ny + nz * nz);
+            nx /= norm; ny /= norm; nz /= norm;
+        }
+
+        normals[0 * block_size + b] = (float)nx;
+        normals[1 * block_size + b] = (float)ny;
+        normals[2 * block_size + b] = (float)nz;
+    }
+}
@@ -0,0 +1,354 @@
+#include "../include/pcd_format.h"
+
+#include <cstring>
+#include <cstdlib>
+
+namespace
+{
+    bool is_separator(char c) { return c == '\t' || c == ' ' || c == '\r'; }
+
+    /** @brief split_line cuts a line into its words */
+    std::vector<std::string> split_line(const char* begin, const char* end)
+    {
+        std::vector<std::string> words;
+
+        while (begin < end)
+        {
+            while (begin < end && is_separator(*begin))
+                begin++;
+
+            const char* word = begin;
+
+            while (begin < end && !is_separator(*begin))
+                begin++;
+
+            if (begin > word)
+                words.push_back(std::string(word, begin));
+        }
+
+        return words;
+    }
+
+    /** @brief to_size reads a word holding a positive integer */
+    size_t to_size(const std::string& word)
+    {
+        char* word_end = nullptr;
+        unsigned long long value = std::strtoull(word.c_str(), &word_end, 10);
+
+        if (word.empty() || *word_end != '\0' || word[0] == '-')
+            throw cos_lib::except::invalid_path();
+
+        return (size_t)value;
+    }
+
+    /** @brief read_element reads an element of a binary point as a double */
+    double read_element(const char* record, char type, size_t size)
+    {
+        switch (type)
+        {
+        case 'F':
+            if (size == 4) { float value; std::memcpy(&value, record, 4); return value; }
+            if (size == 8) { double value; std::memcpy(&value, record, 8); return value; }
+            break;
+        case 'U':
+            if (size == 1) { uint8_t value; std::memcpy(&value, record, 1); return value; }
+            if (size == 2) { uint16_t value; std::memcpy(&value, record, 2); return value; }
+            if (size == 4) { uint32_t value; std::memcpy(&value, record, 4); return value; }
+            if (size == 8) { uint64_t value; std::memcpy(&value, record, 8); return (double)value; }
+            break;
+        case 'I':
+            if (size == 1) { int8_t value; std::memcpy(&value, record, 1); return value; }
+            if (size == 2) { int16_t value; std::memcpy(&value, record, 2); return value; }
+            if (size == 4) { int32_t value; std::memcpy(&value, record, 4); return value; }
+            if (size == 8) { int64_t value; std::memcpy(&value, record, 8); return (double)value; }
+            break;
+        }
+
+        return 0;
+    }
+
+    void set_colour(pcl::PointXYZRGB& point, uint32_t packed)
+    {
+        point.r = (uint8_t)(packed >> 16);
+        point.g = (uint8_t)(packed >> 8);
+        point.b = (uint8_t)packed;
+    }
+}
+
+cos_lib::io::pcd_header cos_lib::io::parse_pcd_header(const char* begin, const char* end)
+{
+    cos_lib::io::pcd_header header;
+    std::vector<std::string> names, sizes, types, counts;
+    size_t width = 0, height = 1;
+    bool has_points = false, has_data = false;
+
+    header.nb_points = 0;
+
+    for (const char* line = begin; line < end && !has_data; )
+    {
+        const char* eol = (const char*)std::memchr(line, '\n', end - line);
+
+        // the header must be complete, DATA line included, within the given characters
+        if (!eol)
+            throw cos_lib::except::invalid_path();
+
+        std::vector<std::string> words = split_line(line, eol);
+        line = eol + 1;
+
+        if (words.empty() || words[0][0] == '#')
+            continue;
+
+        std::string key = words[0];
+        words.erase(words.begin());
+
+        if (key == "FIELDS" || key == "COLUMNS")
+            names = words;
+
+        else if (key == "SIZE")
+            sizes = words;
+
+        else if (key == "TYPE")
+            types = words;
+
+        else if (key == "COUNT")
+            counts = words;
+
+        else if (key == "WIDTH" && words.size() == 1)
+            width = to_size(words[0]);
+
+        else if (key == "HEIGHT" && words.size() == 1)
+            height = to_size(words[0]);
+
+        else if (key == "POINTS" && words.size() == 1)
+        {
+            header.nb_points = to_size(words[0]);
+            has_points = true;
+        }
+
+        else if (key == "DATA" && words.size() == 1)
+        {
+            if (words[0] == "ascii")
+                header.data = cos_lib::io::pcd_header::ascii;
+
+            else if (words[0] == "binary")
+                header.data = cos_lib::io::pcd_header::binary;
+
+            else if (words[0] == "binary_compressed")
+                header.data = cos_lib::io::pcd_header::binary_compressed;
+
+            else
+                throw cos_lib::except::invalid_path();
+
+            header.data_offset = line - begin;
+            has_data = true;
+        }
+    }
+
+    if (!has_data || names.empty() || sizes.size() != names.size() || types.size() != names.size()
+            || (!counts.empty() && counts.size() != names.size()))
+        throw cos_lib::except::invalid_path();
+
+    if (!has_points)
+        header.nb_points = width * height;
+
+    header.point_step = 0;
+    header.nb_columns = 0;
+    header.x_field = header.y_field = header.z_field = header.colour_field = -1;
+
+    for (size_t i = 0; i < names.size(); i++)
+    {
+        cos_lib::io::pcd_field field;
+
+        field.name = names[i];
+        field.type = (types[i].size() == 1) ? types[i][0] : '?';
+        field.size = to_size(sizes[i]);
+        field.count = counts.empty() ? 1 : to_size(counts[i]);
+        field.offset = header.point_step;
+        field.column = header.nb_columns;
+
+        if ((field.type != 'F' && field.type != 'U' && field.type != 'I') || field.size == 0 || field.size > 8)
+            throw cos_lib::except::invalid_path();
+
+        header.point_step += field.size * field.count;
+        header.nb_columns += field.count;
+
+        if (field.name == "x") header.x_field = (int)i;
+        else if (field.name == "y") header.y_field = (int)i;
+        else if (field.name == "z") header.z_field = (int)i;
+        else if ((field.name == "rgb" || field.name == "rgba") && field.size == 4) header.colour_field = (int)i;
+
+        header.fields.push_back(field);
+    }
+
+    if (header.x_field < 0 || header.y_field < 0 || header.z_field < 0)
+        throw cos_lib::except::invalid_path();
+
+    return header;
+}
+
+void cos_lib::io::decode_pcd_point(const cos_lib::io::pcd_header& header, const char* record, pcl::PointXYZRGB& point)
+{
+    const cos_lib::io::pcd_field& x = header.fields[header.x_field];
+    const cos_lib::io::pcd_field& y = header.fields[header.y_field];
+    const cos_lib::io::pcd_field& z = header.fields[header.z_field];
+
+    point.x = (float)read_element(record + x.offset, x.type, x.size);
+    point.y = (float)read_element(record + y.offset, y.type, y.size);
+    point.z = (float)read_element(record + z.offset, z.type, z.size);
+
+    uint32_t packed = 0xFFFFFF;
+
+    // rgb is a float and rgba an unsigned integer, both holding the bits 0x00RRGGBB
+    if (header.colour_field >= 0)
+        std::memcpy(&packed, record + header.fields[header.colour_field].offset, 4);
+
+    set_colour(point, packed);
+}
+
+bool cos_lib::io::parse_pcd_line(const cos_lib::io::pcd_header& header, const char* begin, const char* end, pcl::PointXYZRGB& point)
+{
+    const size_t x_column = header.fields[header.x_field].column;
+    const size_t y_column = header.fields[header.y_field].column;
+    const size_t z_column = header.fields[header.z_field].column;
+    const size_t colour_column = (header.colour_field >= 0) ? header.fields[header.colour_field].column : header.nb_columns;
+    uint32_t packed = 0xFFFFFF;
+    size_t column = 0;
+
+    for (const char* it = begin; ; column++)
+    {
+        while (it < end && is_separator(*it))
+            it++;
+
+        if (it == end)
+            break;
+
+        const char* word_end = it;
+
+        while (word_end < end && !is_separator(*word_end))
+            word_end++;
+
+        if (column == colour_column)
+        {
+            // the colour is either written as an unsigned integer or as the float holding its bits
+            bool is_integer = true;
+
+            for (const char* c = it; c < word_end; c++)
+                is_integer = is_integer && *c >= '0' && *c <= '9';
+
+            if (is_integer)
+            {
+                uint64_t value = 0;
+
+                for (const char* c = it; c < word_end; c++)
+                    value = value * 10 + (*c - '0');
+
+                packed = (uint32_t)value;
+            }
+
+            else
+            {
+                float value;
+
+                if (cos_lib::aux::parse_float(it, word_end, value) != word_end)
+                    return false;
+
+                std::memcpy(&packed, &value, 4);
+            }
+        }
+
+        else if (column == x_column || column == y_column || column == z_column)
+        {
+            float value;
+
+            if (cos_lib::aux::parse_float(it, word_end, value) != word_end)
+                return false;
+
+            (column == x_column ? point.x : column == y_column ? point.y : point.z) = value;
+        }
+
+        it = word_end;
+    }
+
+    set_colour(point, packed);
+
+    return column == header.nb_columns;
+}
+
+void cos_lib::io::decode_pcd_compressed_point(const cos_lib::io::pcd_header& header, const char* data, size_t index, pcl::PointXYZRGB& point)
+{
+    const cos_lib::io::pcd_field& x = header.fields[header.x_field];
+    const cos_lib::io::pcd_field& y = header.fields[header.y_field];
+    const cos_lib::io::pcd_field& z = header.fields[header.z_field];
+
+    // the column of a field starts after the columns of the fields before it, which all hold one value per point
+    point.x = (float)read_element(data + header.nb_points * x.offset + index * x.size * x.count, x.type, x.size);
+    point.y = (float)read_element(data + header.nb_points * y.offset + index * y.size * y.count, y.type, y.size);
+    point.z = (float)read_element(data + header.nb_points * z.offset + index * z.size * z.count, z.type, z.size);
+
+    uint32_t packed = 0xFFFFFF;
+
+    if (header.colour_field >= 0)
+    {
+        const cos_lib::io::pcd_field& colour = header.fields[header.colour_field];
+        std::memcpy(&packed, data + header.nb_points * colour.offset + index * colour.size * colour.count, 4);
+    }
+
+    set_colour(point, packed);
+}
+
+size_t cos_lib::io::lzf_decompress(const char* in, size_t in_size, char* out, size_t out_size)
+{
+    const uint8_t* ip = (const uint8_t*)in;
+    const uint8_t* const in_end = ip + in_size;
+    uint8_t* op = (uint8_t*)out;
+    uint8_t* const out_begin = op;
+    uint8_t* const out_end = op + out_size;
+
+    while (ip < in_end)
+    {
+        size_t ctrl = *ip++;
+
+        // literal run of ctrl + 1 bytes
+        if (ctrl < 32)
+        {
+            ctrl++;
+
+            if (op + ctrl > out_end || ip + ctrl > in_end)
+                return 0;
+
+            std::memcpy(op, ip, ctrl);
+            op += ctrl;
+            ip += ctrl;
+        }
+
+        // back reference, which may overlap the bytes it writes
+        else
+        {
+            size_t length = ctrl >> 5;
+
+            if (length == 7)
+            {
+                if (ip >= in_end)
+                    return 0;
+
+                length += *ip++;
+            }
+
+            if (ip >= in_end)
+                return 0;
+
+            size_t distance = ((ctrl & 0x1f) << 8) + *ip++ + 1;
+            length += 2;
+
+            if ((size_t)(op - out_begin) < distance || op + length > out_end)
+                return 0;
+
+            const uint8_t* ref = op - distance;
+
+            for (size_t i = 0; i < length; i++)
+                *op++ = *ref++;
+        }
+    }
+
+    return op - out_begin;
+}
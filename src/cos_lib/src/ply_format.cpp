@@ -0,0 +1,304 @@
+#include "../include/ply_format.h"
+
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+
+namespace
+{
+    bool is_separator(char c) { return c == '\t' || c == ' ' || c == '\r'; }
+
+    /** @brief split_line cuts a line into its words */
+    std::vector<std::string> split_line(const char* begin, const char* end)
+    {
+        std::vector<std::string> words;
+
+        while (begin < end)
+        {
+            while (begin < end && is_separator(*begin))
+                begin++;
+
+            const char* word = begin;
+
+            while (begin < end && !is_separator(*begin))
+                begin++;
+
+            if (begin > word)
+                words.push_back(std::string(word, begin));
+        }
+
+        return words;
+    }
+
+    /** @brief property_type gets the type and the size of a property from its ply type name, false if the name is unknown */
+    bool property_type(const std::string& name, char& type, size_t& size)
+    {
+        static const char* const names[] = { "char", "int8", "uchar", "uint8", "short", "int16", "ushort", "uint16",
+                                             "int", "int32", "uint", "uint32", "float", "float32", "double", "float64" };
+        static const char types[] = { 'I', 'I', 'U', 'U', 'I', 'I', 'U', 'U', 'I', 'I', 'U', 'U', 'F', 'F', 'F', 'F' };
+        static const size_t sizes[] = { 1, 1, 1, 1, 2, 2, 2, 2, 4, 4, 4, 4, 4, 4, 8, 8 };
+
+        for (size_t i = 0; i < 16; i++)
+        {
+            if (name == names[i])
+            {
+                type = types[i];
+                size = sizes[i];
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    /** @brief read_property reads a property of a binary vertex as a double, swapping its bytes if the file is big-endian */
+    double read_property(const char* record, const cos_lib::io::ply_property& property, bool swap)
+    {
+        char bytes[8];
+
+        std::memcpy(bytes, record + property.offset, property.size);
+
+        if (swap)
+            std::reverse(bytes, bytes + property.size);
+
+        switch (property.type)
+        {
+        case 'F':
+            if (property.size == 4) { float value; std::memcpy(&value, bytes, 4); return value; }
+            { double value; std::memcpy(&value, bytes, 8); return value; }
+        case 'U':
+            if (property.size == 1) { uint8_t value; std::memcpy(&value, bytes, 1); return value; }
+            if (property.size == 2) { uint16_t value; std::memcpy(&value, bytes, 2); return value; }
+            { uint32_t value; std::memcpy(&value, bytes, 4); return value; }
+        default:
+            if (property.size == 1) { int8_t value; std::memcpy(&value, bytes, 1); return value; }
+            if (property.size == 2) { int16_t value; std::memcpy(&value, bytes, 2); return value; }
+            { int32_t value; std::memcpy(&value, bytes, 4); return value; }
+        }
+    }
+
+    /** @brief colour_channel converts a colour property to 8 bits, floating point colours being in [0, 1] */
+    uint8_t colour_channel(double value, char type)
+    {
+        if (type == 'F')
+            value *= 255;
+
+        return (uint8_t)std::min(255.0, std::max(0.0, value + (type == 'F' ? 0.5 : 0.0)));
+    }
+}
+
+cos_lib::io::ply_header cos_lib::io::parse_ply_header(const char* begin, const char* end)
+{
+    cos_lib::io::ply_header header;
+    bool has_format = false, has_end = false, in_vertex = false, after_vertex = false;
+    size_t element_count = 0, element_step = 0;
+    bool element_has_list = false;
+
+    header.nb_points = 0;
+    header.point_step = 0;
+    header.skipped_size = 0;
+
+    // the elements stored before the vertices are skipped, so their size is summed when the next element starts
+    auto close_element = [&]()
+    {
+        if (!in_vertex && !after_vertex)
+        {
+            if (header.data == cos_lib::io::ply_header::ascii)
+                header.skipped_size += element_count;
+
+            else if (element_has_list)
+                throw cos_lib::except::invalid_path();
+
+            else
+                header.skipped_size += element_count * element_step;
+        }
+
+        if (in_vertex)
+            after_vertex = true;
+
+        in_vertex = false;
+        element_count = element_step = 0;
+        element_has_list = false;
+    };
+
+    const char* line = begin;
+
+    for (size_t line_number = 0; line < end && !has_end; line_number++)
+    {
+        const char* eol = (const char*)std::memchr(line, '\n', end - line);
+
+        if (!eol)
+            throw cos_lib::except::invalid_path();
+
+        std::vector<std::string> words = split_line(line, eol);
+        line = eol + 1;
+
+        if (line_number == 0)
+        {
+            if (words.size() != 1 || words[0] != "ply")
+                throw cos_lib::except::invalid_path();
+
+            continue;
+        }
+
+        if (words.empty() || words[0] == "comment" || words[0] == "obj_info")
+            continue;
+
+        if (words[0] == "format" && words.size() == 3)
+        {
+            if (words[1] == "ascii")
+                header.data = cos_lib::io::ply_header::ascii;
+
+            else if (words[1] == "binary_little_endian")
+                header.data = cos_lib::io::ply_header::binary_little_endian;
+
+            else if (words[1] == "binary_big_endian")
+                header.data = cos_lib::io::ply_header::binary_big_endian;
+
+            else
+                throw cos_lib::except::invalid_path();
+
+            has_format = true;
+        }
+
+        else if (words[0] == "element" && words.size() == 3 && has_format)
+        {
+            close_element();
+
+            char* count_end = nullptr;
+            element_count = (size_t)std::strtoull(words[2].c_str(), &count_end, 10);
+
+            if (*count_end != '\0')
+                throw cos_lib::except::invalid_path();
+
+            if (words[1] == "vertex" && !after_vertex)
+            {
+                in_vertex = true;
+                header.nb_points = element_count;
+            }
+        }
+
+        else if (words[0] == "property" && words.size() == 5 && words[1] == "list")
+        {
+            if (in_vertex)
+                throw cos_lib::except::invalid_path();
+
+            element_has_list = true;
+        }
+
+        else if (words[0] == "property" && words.size() == 3)
+        {
+            cos_lib::io::ply_property property;
+
+            if (!property_type(words[1], property.type, property.size))
+                throw cos_lib::except::invalid_path();
+
+            property.name = words[2];
+            property.offset = element_step;
+            element_step += property.size;
+
+            if (in_vertex)
+            {
+                header.properties.push_back(property);
+                header.point_step = element_step;
+            }
+        }
+
+        else if (words[0] == "end_header")
+        {
+            close_element();
+            has_end = true;
+        }
+
+        else
+            throw cos_lib::except::invalid_path();
+    }
+
+    if (!has_end || !after_vertex)
+        throw cos_lib::except::invalid_path();
+
+    header.data_offset = line - begin;
+    header.x_property = header.y_property = header.z_property = -1;
+    header.colour_properties[0] = header.colour_properties[1] = header.colour_properties[2] = -1;
+
+    for (size_t i = 0; i < header.properties.size(); i++)
+    {
+        const std::string& name = header.properties[i].name;
+
+        if (name == "x") header.x_property = (int)i;
+        else if (name == "y") header.y_property = (int)i;
+        else if (name == "z") header.z_property = (int)i;
+        else if (name == "red" || name == "r" || name == "diffuse_red") header.colour_properties[0] = (int)i;
+        else if (name == "green" || name == "g" || name == "diffuse_green") header.colour_properties[1] = (int)i;
+        else if (name == "blue" || name == "b" || name == "diffuse_blue") header.colour_properties[2] = (int)i;
+    }
+
+    if (header.x_property < 0 || header.y_property < 0 || header.z_property < 0)
+        throw cos_lib::except::invalid_path();
+
+    return header;
+}
+
+void cos_lib::io::decode_ply_point(const cos_lib::io::ply_header& header, const char* record, pcl::PointXYZRGB& point)
+{
+    const bool swap = (header.data == cos_lib::io::ply_header::binary_big_endian);
+
+    point.x = (float)read_property(record, header.properties[header.x_property], swap);
+    point.y = (float)read_property(record, header.properties[header.y_property], swap);
+    point.z = (float)read_property(record, header.properties[header.z_property], swap);
+
+    uint8_t colour[3] = { 255, 255, 255 };
+
+    for (int channel = 0; channel < 3; channel++)
+    {
+        if (header.colour_properties[channel] >= 0)
+        {
+            const cos_lib::io::ply_property& property = header.properties[header.colour_properties[channel]];
+            colour[channel] = colour_channel(read_property(record, property, swap), property.type);
+        }
+    }
+
+    point.r = colour[0];
+    point.g = colour[1];
+    point.b = colour[2];
+}
+
+bool cos_lib::io::parse_ply_line(const cos_lib::io::ply_header& header, const char* begin, const char* end, pcl::PointXYZRGB& point)
+{
+    uint8_t colour[3] = { 255, 255, 255 };
+    size_t column = 0;
+
+    for (const char* it = begin; ; column++)
+    {
+        while (it < end && is_separator(*it))
+            it++;
+
+        if (it == end)
+            break;
+
+        if (column == header.properties.size())
+            return false;
+
+        float value;
+        const char* next = cos_lib::aux::parse_float(it, end, value);
+
+        if (next == it || (next < end && !is_separator(*next)))
+            return false;
+
+        if ((int)column == header.x_property) point.x = value;
+        else if ((int)column == header.y_property) point.y = value;
+        else if ((int)column == header.z_property) point.z = value;
+
+        for (int channel = 0; channel < 3; channel++)
+            if ((int)column == header.colour_properties[channel])
+                colour[channel] = colour_channel(value, header.properties[column].type);
+
+        it = next;
+    }
+
+    point.r = colour[0];
+    point.g = colour[1];
+    point.b = colour[2];
+
+    return column == header.properties.size();
+}
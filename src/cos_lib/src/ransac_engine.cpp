@@ -0,0 +1,231 @@
+#include "../include/ransac_engine.h"
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <chrono>
+
+namespace
+{
+    /**
+     * @brief max_rejected_draws Number of samples a hypothesis draws before giving up when the model cannot be fitted on any of them
+     */
+    const int max_rejected_draws = 100;
+
+    /**
+     * @brief min_parallel_evaluations Number of distances under which a batch is scored by a single thread, starting threads costing more
+     */
+    const size_t min_parallel_evaluations = 1 << 16;
+
+    /**
+     * @brief drawHypothesis Draws samples of distinct active slots until the model can be fitted on one of them
+     * @param nb_rejected Increased by the number of samples the model could not be fitted on
+     * @return false if the model could not be fitted on any sample
+     */
+    bool drawHypothesis(const cos_lib::point_buffer& buffer, const cos_lib::sac_model& model, cos_lib::sample_generator& generator,
+                        Eigen::VectorXf& hypothesis, size_t& nb_rejected)
+    {
+        // At least half of the slots of a buffer are active, so an active slot is found in two draws on average
+        std::vector<size_t> sample(model.getSampleSize());
+        const uint8_t* active = buffer.getActive();
+
+        for(int draw = 0; draw < max_rejected_draws; draw++)
+        {
+            bool distinct = true;
+            for(size_t i = 0; i < sample.size(); i++)
+            {
+                do
+                    sample[i] = generator.nextBelow(buffer.getSize());
+                while(!active[sample[i]]);
+
+                for(size_t j = 0; j < i; j++)
+                    distinct = distinct && (sample[j] != sample[i]);
+            }
+
+            if(distinct && model.fit(buffer, sample.data(), hypothesis))
+                return true;
+            nb_rejected++;
+        }
+        return false;
+    }
+}
+
+cos_lib::ransac_engine::ransac_engine(const cos_lib::sac_model& model, double distance_threshold, uint64_t seed) : model(model)
+{
+    if(!(distance_threshold >= 0))
+        throw std::invalid_argument("The distance threshold of RANSAC cannot be negative.");
+
+    this->distance_threshold = (float)distance_threshold;
+    this->probability = 0.99;
+    this->max_iterations = 10000;
+    this->batch_size = 64;
+    this->block_size = 1024;
+    this->refine = false;
+    this->seed = seed;
+    this->run = 0;
+    this->statistics = cos_lib::ransac_statistics();
+}
+
+void cos_lib::ransac_engine::setProbability(double probability)
+{
+    if(!(probability > 0 && probability < 1))
+        throw std::invalid_argument("The probability of RANSAC must be strictly between 0 and 1.");
+
+    this->probability = probability;
+}
+
+void cos_lib::ransac_engine::setPreemption(size_t batch_size, size_t block_size)
+{
+    if(batch_size == 0)
+        throw std::invalid_argument("RANSAC needs at least one hypothesis per batch.");
+
+    this->batch_size = batch_size;
+    this->block_size = block_size;
+}
+
+size_t cos_lib::ransac_engine::countInliers(const cos_lib::point_buffer& buffer, const Eigen::VectorXf& hypothesis, size_t first, size_t length) const
+{
+    size_t size = buffer.getSize();
+    size_t begin = first % size;
+
+    if(begin + length <= size)
+        return this->model.countInliers(buffer, hypothesis, this->distance_threshold, begin, begin + length);
+
+    return this->model.countInliers(buffer, hypothesis, this->distance_threshold, begin, size)
+         + this->model.countInliers(buffer, hypothesis, this->distance_threshold, 0, begin + length - size);
+}
+
+bool cos_lib::ransac_engine::computeModel(const cos_lib::point_buffer& buffer)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    uint64_t run_seed = this->seed + (this->run++) * 0x9E3779B97F4A7C15ull;
+
+    this->statistics = cos_lib::ransac_statistics();
+    this->inlier_slots.clear();
+    this->inliers.clear();
+    this->coefficients.resize(0);
+
+    const size_t size = buffer.getSize();
+    const size_t nb_active = buffer.getNbActive();
+    size_t best_count = 0;
+    size_t nb_needed = this->max_iterations;
+    Eigen::VectorXf best;
+
+    std::vector<Eigen::VectorXf> hypotheses(this->batch_size);
+    std::vector<uint8_t> valid(this->batch_size);
+    std::vector<size_t> scores(this->batch_size);
+    std::vector<size_t> rejected(this->batch_size);
+    std::vector<size_t> alive;
+    cos_lib::sample_generator offsets(run_seed);
+
+    for(size_t iteration = 0; iteration < nb_needed && nb_active >= this->model.getSampleSize(); iteration += this->batch_size)
+    {
+        size_t nb_hypotheses = std::min(this->batch_size, nb_needed - iteration);
+
+        #pragma omp parallel for schedule(dynamic)
+        for(long h = 0; h < (long)nb_hypotheses; h++)
+        {
+            cos_lib::sample_generator generator(run_seed, 1 + iteration + h);
+
+            rejected[h] = 0;
+            scores[h] = 0;
+            valid[h] = drawHypothesis(buffer, this->model, generator, hypotheses[h], rejected[h]);
+        }
+
+        alive.clear();
+        for(size_t h = 0; h < nb_hypotheses; h++)
+        {
+            this->statistics.nb_rejected_samples += rejected[h];
+            if(valid[h])
+                alive.push_back(h);
+        }
+        this->statistics.nb_iterations += nb_hypotheses;
+
+        // Preemption: the batch is scored block after block, only its best half going on after each block, ties going to the lowest rank
+        size_t first = offsets.nextBelow(size);
+        size_t scored = 0;
+
+        while(this->block_size > 0 && alive.size() > 1 && scored + this->block_size < size)
+        {
+            #pragma omp parallel for schedule(static) if(alive.size() * this->block_size >= min_parallel_evaluations)
+            for(long a = 0; a < (long)alive.size(); a++)
+                scores[alive[a]] += this->countInliers(buffer, hypotheses[alive[a]], first + scored, this->block_size);
+
+            this->statistics.nb_evaluations += alive.size() * this->block_size;
+            scored += this->block_size;
+
+            std::sort(alive.begin(), alive.end(), [&scores](size_t h1, size_t h2) { return scores[h1] > scores[h2] || (scores[h1] == scores[h2] && h1 < h2); });
+            alive.resize((alive.size() + 1) / 2);
+        }
+
+        // The hypotheses left are scored on the rest of the buffer, which gives their exact number of inliers
+        #pragma omp parallel for schedule(static) if(alive.size() * (size - scored) >= min_parallel_evaluations)
+        for(long a = 0; a < (long)alive.size(); a++)
+            scores[alive[a]] += this->countInliers(buffer, hypotheses[alive[a]], first + scored, size - scored);
+
+        this->statistics.nb_evaluations += alive.size() * (size - scored);
+
+        std::sort(alive.begin(), alive.end());
+        for(size_t a = 0; a < alive.size(); a++)
+        {
+            if(scores[alive[a]] > best_count)
+            {
+                best_count = scores[alive[a]];
+                best = hypotheses[alive[a]];
+            }
+        }
+
+        if(best_count > 0)
+        {
+            double inlier_ratio = (double)best_count / nb_active;
+            double no_outliers = 1 - std::pow(inlier_ratio, (double)this->model.getSampleSize());
+
+            no_outliers = std::max(std::numeric_limits<double>::epsilon(), std::min(1 - std::numeric_limits<double>::epsilon(), no_outliers));
+            double k = std::ceil(std::log(1 - this->probability) / std::log(no_outliers));
+            nb_needed = (size_t)std::min((double)this->max_iterations, k);
+        }
+    }
+
+    if(best_count > 0)
+    {
+        this->model.selectInliers(buffer, best, this->distance_threshold, this->inlier_slots);
+        this->statistics.nb_evaluations += size;
+
+        // The refined model is only kept if it explains at least as many points as the best hypothesis
+        Eigen::VectorXf refined;
+        std::vector<size_t> refined_slots;
+        if(this->refine && this->model.refit(buffer, this->inlier_slots, refined))
+        {
+            this->model.selectInliers(buffer, refined, this->distance_threshold, refined_slots);
+            this->statistics.nb_evaluations += size;
+
+            if(refined_slots.size() >= this->inlier_slots.size())
+            {
+                best = refined;
+                this->inlier_slots.swap(refined_slots);
+            }
+        }
+
+        this->coefficients = best;
+        this->inliers.resize(this->inlier_slots.size());
+        for(size_t i = 0; i < this->inlier_slots.size(); i++)
+            this->inliers[i] = buffer.getIndex(this->inlier_slots[i]);
+        std::sort(this->inliers.begin(), this->inliers.end());
+    }
+
+    this->statistics.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    return best_count > 0;
+}
+
+std::vector<int> cos_lib::ransac_engine::extractModel(cos_lib::point_buffer& buffer)
+{
+    if(!this->computeModel(buffer))
+        return std::vector<int>();
+
+    // Deactivating the inliers may compact the buffer, which makes their slots meaningless
+    buffer.deactivate(this->inlier_slots);
+    this->inlier_slots.clear();
+
+    return this->inliers;
+}
@@ -0,0 +1,103 @@
+#include "../include/sampling_octree.h"
+
+#include <cmath>
+#include <algorithm>
+
+namespace
+{
+    /**
+     * @brief spreadBits Inserts two 0 bits after each of the 10 lowest bits of a value
+     */
+    uint32_t spreadBits(uint32_t value)
+    {
+        value &= 0x3FF;
+        value = (value | (value << 16)) & 0x030000FF;
+        value = (value | (value << 8)) & 0x0300F00F;
+        value = (value | (value << 4)) & 0x030C30C3;
+        value = (value | (value << 2)) & 0x09249249;
+        return value;
+    }
+
+    /**
+     * @brief quantize Gets the leaf coordinate of a value along an axis of the octree
+     */
+    uint32_t quantize(float value, float origin, float scale)
+    {
+        float leaf = (value - origin) * scale;
+        return (uint32_t)std::min(std::max(leaf, 0.0f), (float)((1 << cos_lib::sampling_octree::max_depth) - 1));
+    }
+}
+
+cos_lib::sampling_octree::sampling_octree()
+{
+    this->depth = 0;
+}
+
+void cos_lib::sampling_octree::build(const cos_lib::point_buffer& buffer, double min_cell_size)
+{
+    const float* x = buffer.getX();
+    const float* y = buffer.getY();
+    const float* z = buffer.getZ();
+    const uint8_t* active = buffer.getActive();
+
+    this->codes.clear();
+    this->slots.clear();
+    this->depth = 0;
+
+    if(buffer.getNbActive() == 0)
+        return;
+
+    // The root is the bounding cube of the active points
+    float min[3] = { INFINITY, INFINITY, INFINITY };
+    float max[3] = { -INFINITY, -INFINITY, -INFINITY };
+    for(size_t slot = 0; slot < buffer.getSize(); slot++)
+    {
+        if(!active[slot])
+            continue;
+
+        min[0] = std::min(min[0], x[slot]); max[0] = std::max(max[0], x[slot]);
+        min[1] = std::min(min[1], y[slot]); max[1] = std::max(max[1], y[slot]);
+        min[2] = std::min(min[2], z[slot]); max[2] = std::max(max[2], z[slot]);
+    }
+    float extent = std::max(max[0] - min[0], std::max(max[1] - min[1], max[2] - min[2]));
+
+    // Cells of the deepest level are at least min_cell_size wide
+    while(this->depth < max_depth && extent / (float)(2 << this->depth) >= min_cell_size)
+        this->depth++;
+
+    float scale = extent > 0 ? (float)(1 << max_depth) / extent : 0;
+    std::vector<uint64_t> entries;
+    entries.reserve(buffer.getNbActive());
+    for(size_t slot = 0; slot < buffer.getSize(); slot++)
+    {
+        if(!active[slot])
+            continue;
+
+        uint32_t code = spreadBits(quantize(x[slot], min[0], scale))
+                      | spreadBits(quantize(y[slot], min[1], scale)) << 1
+                      | spreadBits(quantize(z[slot], min[2], scale)) << 2;
+        entries.push_back((uint64_t)code << 32 | slot);
+    }
+
+    // Sorting by code then slot keeps the octree the same whatever the order the entries were gathered in
+    std::sort(entries.begin(), entries.end());
+
+    this->codes.resize(entries.size());
+    this->slots.resize(entries.size());
+    for(size_t entry = 0; entry < entries.size(); entry++)
+    {
+        this->codes[entry] = (uint32_t)(entries[entry] >> 32);
+        this->slots[entry] = (uint32_t)entries[entry];
+    }
+}
+
+void cos_lib::sampling_octree::getCell(size_t entry, int level, size_t& begin, size_t& end) const
+{
+    // The cells of a level are the ranges of entries sharing the 3 * level highest bits of their code
+    int shift = 3 * (max_depth - level);
+    uint64_t first_code = (uint64_t)(this->codes[entry] >> shift) << shift;
+    uint64_t last_code = first_code + ((uint64_t)1 << shift);
+
+    begin = std::lower_bound(this->codes.begin(), this->codes.begin() + entry, first_code) - this->codes.begin();
+    end = std::lower_bound(this->codes.begin() + entry, this->codes.end(), last_code) - this->codes.begin();
+}
@@ -0,0 +1,63 @@
+#include "../include/spatial_index.h"
+#include "../include/invalid_cloud_pointer.h"
+
+cos_lib::spatial_index::spatial_index()
+{
+    this->scale[0] = 1;
+    this->scale[1] = 1;
+    this->scale[2] = 1;
+}
+
+cos_lib::spatial_index::~spatial_index()
+{
+
+}
+
+void cos_lib::spatial_index::setScale(float x_scale, float y_scale, float z_scale)
+{
+    if(!(x_scale > 0) || !(y_scale > 0) || !(z_scale > 0))
+        throw std::invalid_argument("The scales of a spatial index must be strictly positive.");
+
+    this->scale[0] = x_scale;
+    this->scale[1] = y_scale;
+    this->scale[2] = z_scale;
+}
+
+void cos_lib::spatial_index::build(pcl::PointCloud<pcl::PointXYZRGB>::ConstPtr cloud)
+{
+    if(!cloud)
+        throw cos_lib::except::invalid_cloud_pointer();
+
+    this->cloud_indices.clear();
+    this->cloud_indices.shrink_to_fit();
+
+    this->coordinates.reset(new pcl::PointCloud<pcl::PointXYZ>);
+    this->coordinates->resize(cloud->size());
+
+    #pragma omp parallel for schedule(static)
+    for(long i = 0; i < (long)cloud->size(); i++)
+        this->coordinates->points[i] = this->scalePoint(cloud->points[i]);
+    this->coordinates->width = this->coordinates->points.size();
+    this->coordinates->height = 1;
+
+    this->buildStructure();
+}
+
+void cos_lib::spatial_index::build(pcl::PointCloud<pcl::PointXYZRGB>::ConstPtr cloud, const uint32_t* indices_begin, const uint32_t* indices_end)
+{
+    if(!cloud)
+        throw cos_lib::except::invalid_cloud_pointer();
+
+    this->cloud_indices.assign(indices_begin, indices_end);
+
+    this->coordinates.reset(new pcl::PointCloud<pcl::PointXYZ>);
+    this->coordinates->resize(this->cloud_indices.size());
+
+    #pragma omp parallel for schedule(static)
+    for(long i = 0; i < (long)this->cloud_indices.size(); i++)
+        this->coordinates->points[i] = this->scalePoint(cloud->points[this->cloud_indices[i]]);
+    this->coordinates->width = this->coordinates->points.size();
+    this->coordinates->height = 1;
+
+    this->buildStructure();
+}
@@ -0,0 +1,136 @@
+#include "../include/tile_scheduler.h"
+#include "../include/invalid_cloud_pointer.h"
+
+#include <cmath>
+#include <algorithm>
+
+cos_lib::tile_scheduler::tile_scheduler(double tile_size, double halo)
+{
+    if(!(tile_size > 0))
+        throw std::invalid_argument("The tile size must be strictly positive.");
+    if(!(halo >= 0) || halo > tile_size)
+        throw std::invalid_argument("The halo must be positive and not bigger than the tile size.");
+
+    this->tile_size = tile_size;
+    this->halo = halo;
+}
+
+void cos_lib::tile_scheduler::build(pcl::PointCloud<pcl::PointXYZRGB>::ConstPtr cloud)
+{
+    if(!cloud)
+        throw cos_lib::except::invalid_cloud_pointer();
+
+    this->clear();
+
+    size_t nb_points = cloud->size();
+    if(nb_points == 0)
+        return;
+
+    double min[3] = { cloud->points[0].x, cloud->points[0].y, cloud->points[0].z };
+    double max[3] = { min[0], min[1], min[2] };
+    for(size_t i = 1; i < nb_points; i++)
+    {
+        const pcl::PointXYZRGB& point = cloud->points[i];
+        min[0] = std::min(min[0], (double)point.x); max[0] = std::max(max[0], (double)point.x);
+        min[1] = std::min(min[1], (double)point.y); max[1] = std::max(max[1], (double)point.y);
+        min[2] = std::min(min[2], (double)point.z); max[2] = std::max(max[2], (double)point.z);
+    }
+
+    int64_t nb_tiles[3];
+    for(int axis = 0; axis < 3; axis++)
+    {
+        nb_tiles[axis] = (int64_t)std::floor((max[axis] - min[axis]) / this->tile_size) + 1;
+        if(nb_tiles[axis] > ((int64_t)1 << 21) - 2)
+            throw std::invalid_argument("The cloud spans too many tiles, the tile size is too small.");
+    }
+
+    // Each point gives one entry for the tile it belongs to and one for each tile whose halo it lies in.
+    // An entry is (tile key, halo flag << 32 | point index), so sorting the entries gives each tile its core points then its halo points
+    std::vector<std::pair<uint64_t, uint64_t>> entries;
+
+    #pragma omp parallel
+    {
+        std::vector<std::pair<uint64_t, uint64_t>> thread_entries;
+
+        #pragma omp for schedule(static) nowait
+        for(long i = 0; i < (long)nb_points; i++)
+        {
+            const pcl::PointXYZRGB& point = cloud->points[i];
+            double coordinates[3] = { point.x, point.y, point.z };
+            int64_t tile[3];
+            bool near_low[3], near_high[3];
+            for(int axis = 0; axis < 3; axis++)
+            {
+                tile[axis] = std::min((int64_t)std::floor((coordinates[axis] - min[axis]) / this->tile_size), nb_tiles[axis] - 1);
+                near_low[axis] = tile[axis] > 0 && coordinates[axis] - (min[axis] + tile[axis] * this->tile_size) <= this->halo;
+                near_high[axis] = tile[axis] < nb_tiles[axis] - 1 && (min[axis] + (tile[axis] + 1) * this->tile_size) - coordinates[axis] <= this->halo;
+            }
+
+            // Tile coordinates are shifted by one in the keys, so a neighbour tile is never negative
+            for(int64_t dz = -1; dz <= 1; dz++)
+            {
+                if((dz == -1 && !near_low[2]) || (dz == 1 && !near_high[2])) continue;
+                for(int64_t dy = -1; dy <= 1; dy++)
+                {
+                    if((dy == -1 && !near_low[1]) || (dy == 1 && !near_high[1])) continue;
+                    for(int64_t dx = -1; dx <= 1; dx++)
+                    {
+                        if((dx == -1 && !near_low[0]) || (dx == 1 && !near_high[0])) continue;
+
+                        uint64_t key = (uint64_t)(tile[0] + dx + 1) | ((uint64_t)(tile[1] + dy + 1) << 21) | ((uint64_t)(tile[2] + dz + 1) << 42);
+                        uint64_t is_halo = (dx != 0 || dy != 0 || dz != 0) ? 1 : 0;
+                        thread_entries.push_back(std::make_pair(key, (is_halo << 32) | (uint64_t)i));
+                    }
+                }
+            }
+        }
+
+        #pragma omp critical(tile_scheduler_entries)
+        entries.insert(entries.end(), thread_entries.begin(), thread_entries.end());
+    }
+
+    std::sort(entries.begin(), entries.end());
+
+    for(size_t first = 0; first < entries.size(); )
+    {
+        size_t last = first;
+        while(last < entries.size() && entries[last].first == entries[first].first)
+            last++;
+
+        // A tile with no core point is only the halo of its neighbours
+        if((entries[first].second >> 32) == 0)
+        {
+            cos_lib::cloud_tile tile;
+            tile.nb_core_points = 0;
+            tile.indices.reserve(last - first);
+            for(size_t i = first; i < last; i++)
+            {
+                tile.indices.push_back((uint32_t)(entries[i].second & 0xFFFFFFFFull));
+                if((entries[i].second >> 32) == 0)
+                    tile.nb_core_points++;
+            }
+            this->tiles.push_back(tile);
+        }
+
+        first = last;
+    }
+
+    std::stable_sort(this->tiles.begin(), this->tiles.end(), [](const cos_lib::cloud_tile& a, const cos_lib::cloud_tile& b)
+    {
+        return a.nb_core_points > b.nb_core_points;
+    });
+}
+
+void cos_lib::tile_scheduler::clear()
+{
+    this->tiles.clear();
+    this->tiles.shrink_to_fit();
+}
+
+void cos_lib::tile_scheduler::run(const std::function<void(const cos_lib::cloud_tile&)>& task) const
+{
+    // The tiles are already sorted by decreasing size
+    #pragma omp parallel for schedule(dynamic, 1)
+    for(long tile = 0; tile < (long)this->tiles.size(); tile++)
+        task(this->tiles[tile]);
+}
@@ -0,0 +1,274 @@
+#include "../include/voxel_hash_index.h"
+
+cos_lib::voxel_hash_index::voxel_hash_index(double cell_size)
+{
+    if(!(cell_size > 0))
+        throw std::invalid_argument("The cell size of a voxel hash must be strictly positive.");
+
+    this->cell_size = cell_size;
+    for(int axis = 0; axis < 3; axis++)
+    {
+        this->origin[axis] = 0;
+        this->nb_cells[axis] = 0;
+    }
+}
+
+void cos_lib::voxel_hash_index::buildStructure()
+{
+    this->cell_keys.clear();
+    this->cell_offsets.clear();
+    this->cell_points.clear();
+    this->cell_positions.clear();
+    this->hash_table.clear();
+
+    size_t nb_points = this->getNbPoints();
+    if(nb_points == 0)
+    {
+        for(int axis = 0; axis < 3; axis++)
+            this->nb_cells[axis] = 0;
+        return;
+    }
+
+    // The grid starts at the lowest corner of the bounding box so cell coordinates are never negative
+    double min[3] = { this->coordinates->points[0].x, this->coordinates->points[0].y, this->coordinates->points[0].z };
+    double max[3] = { min[0], min[1], min[2] };
+    for(size_t i = 1; i < nb_points; i++)
+    {
+        const pcl::PointXYZ& point = this->coordinates->points[i];
+        min[0] = std::min(min[0], (double)point.x); max[0] = std::max(max[0], (double)point.x);
+        min[1] = std::min(min[1], (double)point.y); max[1] = std::max(max[1], (double)point.y);
+        min[2] = std::min(min[2], (double)point.z); max[2] = std::max(max[2], (double)point.z);
+    }
+    for(int axis = 0; axis < 3; axis++)
+    {
+        this->origin[axis] = min[axis];
+        this->nb_cells[axis] = this->getCellCoordinate(max[axis], axis) + 1;
+        if(this->nb_cells[axis] > ((int64_t)1 << 21))
+            throw std::invalid_argument("The cloud spans too many cells for the voxel hash, the cell size is too small.");
+    }
+
+    // Sorting the points by key puts each cell in one range, the position breaking ties keeps the order of the points within a cell
+    std::vector<std::pair<uint64_t, uint32_t>> sorted_points(nb_points);
+
+    #pragma omp parallel for schedule(static)
+    for(long i = 0; i < (long)nb_points; i++)
+    {
+        const pcl::PointXYZ& point = this->coordinates->points[i];
+        int64_t x = std::min(this->getCellCoordinate(point.x, 0), this->nb_cells[0] - 1);
+        int64_t y = std::min(this->getCellCoordinate(point.y, 1), this->nb_cells[1] - 1);
+        int64_t z = std::min(this->getCellCoordinate(point.z, 2), this->nb_cells[2] - 1);
+        sorted_points[i] = std::make_pair(cos_lib::voxel_hash_index::packKey(x, y, z), (uint32_t)i);
+    }
+    std::sort(sorted_points.begin(), sorted_points.end());
+
+    this->cell_points.resize(3 * nb_points);
+    this->cell_positions.resize(nb_points);
+    for(size_t i = 0; i < nb_points; i++)
+    {
+        if(i == 0 || sorted_points[i].first != sorted_points[i - 1].first)
+        {
+            this->cell_keys.push_back(sorted_points[i].first);
+            this->cell_offsets.push_back((uint32_t)i);
+        }
+        const pcl::PointXYZ& point = this->coordinates->points[sorted_points[i].second];
+        this->cell_points[3 * i] = point.x;
+        this->cell_points[3 * i + 1] = point.y;
+        this->cell_points[3 * i + 2] = point.z;
+        this->cell_positions[i] = sorted_points[i].second;
+    }
+    this->cell_offsets.push_back((uint32_t)nb_points);
+
+    // The table is kept at most half full so probing sequences stay short
+    size_t table_size = 1;
+    while(table_size < 2 * this->cell_keys.size())
+        table_size <<= 1;
+    this->hash_table.assign(table_size, UINT32_MAX);
+    for(size_t cell = 0; cell < this->cell_keys.size(); cell++)
+    {
+        size_t slot = this->hashKey(this->cell_keys[cell]);
+        while(this->hash_table[slot] != UINT32_MAX)
+            slot = (slot + 1) & (table_size - 1);
+        this->hash_table[slot] = (uint32_t)cell;
+    }
+}
+
+uint32_t cos_lib::voxel_hash_index::findCell(uint64_t key) const
+{
+    size_t slot = this->hashKey(key);
+    while(this->hash_table[slot] != UINT32_MAX)
+    {
+        if(this->cell_keys[this->hash_table[slot]] == key)
+            return this->hash_table[slot];
+        slot = (slot + 1) & (this->hash_table.size() - 1);
+    }
+    return UINT32_MAX;
+}
+
+void cos_lib::voxel_hash_index::scanCell(int64_t x, int64_t y, int64_t z, const pcl::PointXYZ& query, float max_sq_distance,
+                                         std::vector<uint32_t>& positions, std::vector<float>& sq_distances) const
+{
+    uint32_t cell = this->findCell(cos_lib::voxel_hash_index::packKey(x, y, z));
+    if(cell == UINT32_MAX)
+        return;
+
+    for(uint32_t i = this->cell_offsets[cell]; i < this->cell_offsets[cell + 1]; i++)
+    {
+        float dx = this->cell_points[3 * i] - query.x;
+        float dy = this->cell_points[3 * i + 1] - query.y;
+        float dz = this->cell_points[3 * i + 2] - query.z;
+        float sq_distance = dx * dx + dy * dy + dz * dz;
+        if(sq_distance <= max_sq_distance)
+        {
+            positions.push_back(this->cell_positions[i]);
+            sq_distances.push_back(sq_distance);
+        }
+    }
+}
+
+void cos_lib::voxel_hash_index::scanCellNearest(int64_t x, int64_t y, int64_t z, const pcl::PointXYZ& query, size_t k,
+                                                std::vector<std::pair<float, uint32_t>>& heap) const
+{
+    uint32_t cell = this->findCell(cos_lib::voxel_hash_index::packKey(x, y, z));
+    if(cell == UINT32_MAX)
+        return;
+
+    for(uint32_t i = this->cell_offsets[cell]; i < this->cell_offsets[cell + 1]; i++)
+    {
+        float dx = this->cell_points[3 * i] - query.x;
+        float dy = this->cell_points[3 * i + 1] - query.y;
+        float dz = this->cell_points[3 * i + 2] - query.z;
+        std::pair<float, uint32_t> candidate(dx * dx + dy * dy + dz * dz, this->cell_positions[i]);
+        if(heap.size() < k)
+        {
+            heap.push_back(candidate);
+            std::push_heap(heap.begin(), heap.end());
+        }
+        else if(candidate < heap.front())
+        {
+            std::pop_heap(heap.begin(), heap.end());
+            heap.back() = candidate;
+            std::push_heap(heap.begin(), heap.end());
+        }
+    }
+}
+
+size_t cos_lib::voxel_hash_index::radiusSearch(const pcl::PointXYZ& query, double radius, std::vector<uint32_t>& positions,
+                                               std::vector<float>& sq_distances, size_t max_neighbours) const
+{
+    positions.clear();
+    sq_distances.clear();
+    if(this->cell_keys.empty())
+        return 0;
+
+    // Only the cells overlapping the bounding box of the search sphere can hold neighbours
+    double coordinates[3] = { query.x, query.y, query.z };
+    int64_t lowest[3], highest[3];
+    for(int axis = 0; axis < 3; axis++)
+    {
+        lowest[axis] = std::max((int64_t)0, this->getCellCoordinate(coordinates[axis] - radius, axis));
+        highest[axis] = std::min(this->nb_cells[axis] - 1, this->getCellCoordinate(coordinates[axis] + radius, axis));
+        if(lowest[axis] > highest[axis])
+            return 0;
+    }
+
+    float max_sq_distance = (float)(radius * radius);
+    for(int64_t z = lowest[2]; z <= highest[2]; z++)
+        for(int64_t y = lowest[1]; y <= highest[1]; y++)
+            for(int64_t x = lowest[0]; x <= highest[0]; x++)
+                this->scanCell(x, y, z, query, max_sq_distance, positions, sq_distances);
+
+    if(max_neighbours > 0)
+    {
+        std::vector<std::pair<float, uint32_t>> neighbours(positions.size());
+        for(size_t i = 0; i < positions.size(); i++)
+            neighbours[i] = std::make_pair(sq_distances[i], positions[i]);
+
+        size_t nb_kept = std::min(max_neighbours, neighbours.size());
+        std::partial_sort(neighbours.begin(), neighbours.begin() + nb_kept, neighbours.end());
+
+        positions.resize(nb_kept);
+        sq_distances.resize(nb_kept);
+        for(size_t i = 0; i < nb_kept; i++)
+        {
+            sq_distances[i] = neighbours[i].first;
+            positions[i] = neighbours[i].second;
+        }
+    }
+
+    return positions.size();
+}
+
+size_t cos_lib::voxel_hash_index::nearestKSearch(const pcl::PointXYZ& query, size_t k, std::vector<uint32_t>& positions,
+                                                 std::vector<float>& sq_distances) const
+{
+    positions.clear();
+    sq_distances.clear();
+    if(this->cell_keys.empty() || k == 0)
+        return 0;
+    k = std::min(k, this->getNbPoints());
+
+    double coordinates[3] = { query.x, query.y, query.z };
+    int64_t centre[3];
+    for(int axis = 0; axis < 3; axis++)
+        centre[axis] = this->getCellCoordinate(coordinates[axis], axis);
+
+    // The cells are scanned by growing shells around the query cell, until the k-th closest point found so far
+    // is closer than anything outside of the scanned cube
+    std::vector<std::pair<float, uint32_t>> heap;
+    heap.reserve(k);
+    for(int64_t shell = 0; ; shell++)
+    {
+        int64_t lowest[3], highest[3];
+        bool covers_grid = true;
+        for(int axis = 0; axis < 3; axis++)
+        {
+            lowest[axis] = centre[axis] - shell;
+            highest[axis] = centre[axis] + shell;
+            covers_grid = covers_grid && lowest[axis] <= 0 && highest[axis] >= this->nb_cells[axis] - 1;
+        }
+
+        for(int64_t x = std::max((int64_t)0, lowest[0]); x <= std::min(this->nb_cells[0] - 1, highest[0]); x++)
+        {
+            for(int64_t y = std::max((int64_t)0, lowest[1]); y <= std::min(this->nb_cells[1] - 1, highest[1]); y++)
+            {
+                if(x == lowest[0] || x == highest[0] || y == lowest[1] || y == highest[1])
+                {
+                    for(int64_t z = std::max((int64_t)0, lowest[2]); z <= std::min(this->nb_cells[2] - 1, highest[2]); z++)
+                        this->scanCellNearest(x, y, z, query, k, heap);
+                }
+                else
+                {
+                    // Inside the shell's faces along x and y, only the two caps along z are new
+                    if(lowest[2] >= 0 && lowest[2] < this->nb_cells[2])
+                        this->scanCellNearest(x, y, lowest[2], query, k, heap);
+                    if(highest[2] >= 0 && highest[2] < this->nb_cells[2])
+                        this->scanCellNearest(x, y, highest[2], query, k, heap);
+                }
+            }
+        }
+
+        if(covers_grid)
+            break;
+        if(heap.size() == k)
+        {
+            double margin = coordinates[0] - (this->origin[0] + lowest[0] * this->cell_size);
+            for(int axis = 0; axis < 3; axis++)
+            {
+                margin = std::min(margin, coordinates[axis] - (this->origin[axis] + lowest[axis] * this->cell_size));
+                margin = std::min(margin, this->origin[axis] + (highest[axis] + 1) * this->cell_size - coordinates[axis]);
+            }
+            if(margin >= 0 && heap.front().first <= margin * margin)
+                break;
+        }
+    }
+
+    std::sort_heap(heap.begin(), heap.end());
+    positions.resize(heap.size());
+    sq_distances.resize(heap.size());
+    for(size_t i = 0; i < heap.size(); i++)
+    {
+        sq_distances[i] = heap[i].first;
+        positions[i] = heap[i].second;
+    }
+    return heap.size();
+}
@@ -47,7 +47,26 @@ SOURCES += main.cpp\
     ../cos_lib/src/point_xy_mixed.cpp \
     ../cos_lib/src/point_xy_rgb.cpp \
     ../cos_lib/src/vector3.cpp \
-    ../cos_lib/src/cloud_io.cpp
+    ../cos_lib/src/cloud_io.cpp \
+    ../cos_lib/src/neighbour_graph.cpp \
+    ../cos_lib/src/disjoint_set.cpp \
+    ../cos_lib/src/colour_buckets.cpp \
+    ../cos_lib/src/spatial_index.cpp \
+    ../cos_lib/src/voxel_hash_index.cpp \
+    ../cos_lib/src/kd_tree_index.cpp \
+    ../cos_lib/src/normal_estimator.cpp \
+    ../cos_lib/src/tile_scheduler.cpp \
+    ../cos_lib/src/ascii_number.cpp \
+    ../cos_lib/src/cloud_binary.cpp \
+    ../cos_lib/src/pcd_format.cpp \
+    ../cos_lib/src/cloud_reader.cpp \
+    ../cos_lib/src/ply_format.cpp \
+    ../cos_lib/src/las_format.cpp \
+    ../cos_lib/src/colour_quantizer.cpp \
+    ../cos_lib/src/model_extraction.cpp \
+    ../cos_lib/src/ransac_engine.cpp \
+    ../cos_lib/src/sampling_octree.cpp \
+    ../cos_lib/src/local_ransac.cpp
 
 HEADERS  += mainwindow.h \
     test_lib.h \
@@ -79,7 +98,27 @@ HEADERS  += mainwindow.h \
     ../cos_lib/include/point_xy_mixed.h \
     ../cos_lib/include/point_xy_rgb.h \
     ../cos_lib/include/vector3.h \
-    ../cos_lib/include/cloud_io.h
+    ../cos_lib/include/cloud_io.h \
+    ../cos_lib/include/neighbour_graph.h \
+    ../cos_lib/include/disjoint_set.h \
+    ../cos_lib/include/colour_buckets.h \
+    ../cos_lib/include/spatial_index.h \
+    ../cos_lib/include/voxel_hash_index.h \
+    ../cos_lib/include/kd_tree_index.h \
+    ../cos_lib/include/normal_estimator.h \
+    ../cos_lib/include/tile_scheduler.h \
+    ../cos_lib/include/ascii_number.h \
+    ../cos_lib/include/cloud_binary.h \
+    ../cos_lib/include/pcd_format.h \
+    ../cos_lib/include/cloud_reader.h \
+    ../cos_lib/include/ply_format.h \
+    ../cos_lib/include/las_format.h \
+    ../cos_lib/include/pixel_buffer.h \
+    ../cos_lib/include/colour_quantizer.h \
+    ../cos_lib/include/model_extraction.h \
+    ../cos_lib/include/ransac_engine.h \
+    ../cos_lib/include/sampling_octree.h \
+    ../cos_lib/include/local_ransac.h
 
 
 FORMS    += mainwindow.ui \
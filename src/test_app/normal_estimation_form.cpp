@@ -31,11 +31,6 @@ normal_estimation_form::normal_estimation_form(QWidget *parent) :
     ui->max_neighbs_sb->setMinimum(1.0);
     ui->max_neighbs_sb->setMaximum(1000.0);
 
-    // max. fragm. depth
-    ui->max_fragm_depth_sb->setMinimum(1);
-    ui->max_fragm_depth_sb->setMaximum(5000);
-    ui->max_fragm_depth_sb->setSingleStep(100);
-
     ui->cloud_in_ledit->setEnabled(false);
     ui->cloud_out_ledit->setEnabled(false);
     ui->launch_test_btn->setEnabled(false);
@@ -88,8 +83,7 @@ void normal_estimation_form::on_launch_test_btn_clicked()
 
     test_function_return_code = test::estimate_normals(ui->cloud_in_ledit->text().toStdString(), ui->cloud_out_ledit->text().toStdString(),
                                                         ui->radius_dsb->value(), ui->max_neighbs_sb->value(), ui->x_scale_dsb->value(),
-                                                        ui->y_scale_dsb->value(),ui->z_scale_dsb->value(),
-                                                        ui->max_fragm_depth_sb->value());
+                                                        ui->y_scale_dsb->value(),ui->z_scale_dsb->value());
 
     if (test_function_return_code)
         info_box.setText("Invalid input.");
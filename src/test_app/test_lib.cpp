@@ -26,28 +26,20 @@ int test::crop_cloud(std::string cloud_import_path, std::string cloud_export_pat
 }
 
 int test::estimate_normals(std::string cloud_import_path, std::string cloud_export_path, float radius,
-                            int max_neighbs, float x_scale, float y_scale, float z_scale,
-                            float max_fragment_depth)
+                            int max_neighbs, float x_scale, float y_scale, float z_scale)
 {
     int code = 0;
 
     try
     {
-        pcl::PointCloud<pcl::PointXYZRGB>::Ptr base_cloud_ptr;
         pcl::PointCloud<pcl::PointXYZRGB>::Ptr colored_cloud_ptr;   // output cloud
-        std::vector<pcl::PointCloud<pcl::PointXYZRGB>::Ptr> cloud_fragments;
-        float max_scaled_fragment_depth = max_fragment_depth * y_scale;
 
-        base_cloud_ptr = cos_lib::io::import_cloud(cloud_import_path);
-        cos_lib::cloud_manip::scale_cloud(base_cloud_ptr, x_scale, y_scale, z_scale); // scaling cloud
-        cloud_fragments = cos_lib::cloud_manip::fragment_cloud(base_cloud_ptr, max_scaled_fragment_depth); // fragmenting cloud for less executcos_lib::ion time
+        colored_cloud_ptr = cos_lib::io::import_cloud(cloud_import_path);
+        cos_lib::cloud_manip::scale_cloud(colored_cloud_ptr, x_scale, y_scale, z_scale); // scaling cloud
 
-        // estimating the normals for each cloud fragment in parallel
-        #pragma omp parallel for schedule(static)
-        for (unsigned long fragm_it = 0; fragm_it < cloud_fragments.size(); fragm_it++)
-           cos_lib::estimate_normals(cloud_fragments[fragm_it], radius, max_neighbs);
+        // the normals are estimated on all cores, the whole cloud at once
+        cos_lib::estimate_normals(colored_cloud_ptr, radius, max_neighbs);
 
-        colored_cloud_ptr = cos_lib::cloud_manip::merge_clouds(cloud_fragments); // merging fragments to build original cloud
         cos_lib::cloud_manip::scale_cloud(colored_cloud_ptr, (1.0/x_scale), (1.0/y_scale), (1.0/z_scale));    // restoring widop scale
         cos_lib::io::export_cloud(cloud_export_path + "/normal_estimation_test.txt", colored_cloud_ptr);
 
@@ -90,12 +82,11 @@ int test::cloud_to_image(int img_type, std::string cloud_import_path, std::strin
     try
     {
         pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud_ptr = cos_lib::io::import_cloud(cloud_import_path);
-        std::vector<cos_lib::point_xy_mixed> mixed_vector = cos_lib::cloud_manip::cloud_to_2d_mixed(cloud_ptr);
-        cos_lib::image_mixed mixed_img = cos_lib::img_proc::mixed_vector_to_image(mixed_vector, width, height);
+        cos_lib::image_mixed mixed_img = cos_lib::img_proc::cloud_to_mixed_image(cloud_ptr, width, height);
 
         if (img_type == 0)
         {
-            cos_lib::image_greyscale gs_img = cos_lib::img_proc::cloud_to_depth_image(cloud_ptr, width, height);
+            cos_lib::image_greyscale gs_img = cos_lib::img_proc::mixed_image_to_greyscale(mixed_img);
             cos_lib::io::export_greyscale_image(img_export_path + "/cloud_to_greyscale_image.pgm", 255, gs_img);
         }
 
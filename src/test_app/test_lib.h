@@ -18,7 +18,7 @@ namespace test
                     float x_thresh, float y_thresh, float z_thresh);
 
     int estimate_normals(std::string cloud_import_path, std::string cloud_export_path, float radius, int max_neighbs,
-                                  float x_scale, float y_scale, float z_scale, float max_fragment_depth);
+                                  float x_scale, float y_scale, float z_scale);
 
     int homogenize_cloud(std::string cloud_import_path, std::string cloud_export_path, short color_epsilon);
 